@@ -31,6 +31,7 @@ extern	cvar_t *allow_download_players;
 extern	cvar_t *allow_download_models;
 extern	cvar_t *allow_download_sounds;
 extern	cvar_t *allow_download_maps;
+extern	cvar_t *cl_downloadrate;
 
 extern	int precache_check;
 extern	int precache_spawncount;
@@ -43,10 +44,48 @@ static const char *env_suf[6] = {"rt", "bk", "lf", "ft", "up", "dn"};
 
 #define PLAYER_MULT 5
 
+/* blocks of a streamed download that came
+   in after a lost one, by block number */
+static byte cl_ahead[DOWNLOAD_WINDOW][DOWNLOAD_BLOCKSIZE];
+static int cl_aheadlength[DOWNLOAD_WINDOW]; /* 0 for none */
+static int cl_aheadblock[DOWNLOAD_WINDOW];
+static qboolean cl_aheadchanged;
+static int cl_downloadbase; /* offset of block 0 */
+
 /* ENV_CNT is map load, ENV_CNT+1 is first env map */
 #define ENV_CNT (CS_PLAYERSKINS + MAX_CLIENTS * PLAYER_MULT)
 #define TEXTURE_CNT (ENV_CNT+13)
 
+/*
+ * Asks for cls.downloadname. With cl_downloadrate
+ * set a new server streams it and tags the blocks
+ * with cls.downloadid, an old one ignores the
+ * extra arguments and sends a block per nextdl.
+ */
+static void CL_BeginDownload (int offset) {
+	cls.downloadid = cls.downloadnumber % 255 + 1;
+	cls.downloadposition = offset;
+	cls.downloadacked = offset;
+	cls.downloadstreaming = false;
+	cl_downloadbase = offset;
+	cl_aheadchanged = false;
+	memset (cl_aheadlength, 0, sizeof(cl_aheadlength));
+
+	MSG_WriteByte (&cls.netchan.message, clc_stringcmd);
+
+	if (cl_downloadrate->value > 0)
+		MSG_WriteString (&cls.netchan.message, va("download %s %i %i %i",
+		                 cls.downloadname, offset, (int)cl_downloadrate->value, cls.downloadid));
+	else if (offset)
+		MSG_WriteString (&cls.netchan.message,
+		                 va("download %s %i", cls.downloadname, offset));
+	else
+		MSG_WriteString (&cls.netchan.message,
+		                 va("download %s", cls.downloadname));
+
+	cls.downloadnumber++;
+}
+
 void CL_RequestNextDownload (void)
 {
 	unsigned	map_checksum; /* for detecting cheater maps */
@@ -436,19 +475,13 @@ qboolean	CL_CheckOrDownloadFile (char *filename) {
 
 		/* give the server an offset to start the download */
 		Com_Printf ("Resuming %s\n", cls.downloadname);
-		MSG_WriteByte (&cls.netchan.message, clc_stringcmd);
-		MSG_WriteString (&cls.netchan.message,
-		                 va("download %s %i", cls.downloadname, len));
+		CL_BeginDownload (len);
 
 	} else {
 		Com_Printf ("Downloading %s\n", cls.downloadname);
-		MSG_WriteByte (&cls.netchan.message, clc_stringcmd);
-		MSG_WriteString (&cls.netchan.message,
-		                 va("download %s", cls.downloadname));
+		CL_BeginDownload (0);
 	}
 
-	cls.downloadnumber++;
-
 	return false;
 }
 
@@ -485,11 +518,7 @@ void	CL_Download_f (void) {
 	COM_StripExtension (cls.downloadname, cls.downloadtempname);
 	strcat (cls.downloadtempname, ".tmp");
 
-	MSG_WriteByte (&cls.netchan.message, clc_stringcmd);
-	MSG_WriteString (&cls.netchan.message,
-	                 va("download %s", cls.downloadname));
-
-	cls.downloadnumber++;
+	CL_BeginDownload (0);
 }
 
 /*
@@ -504,6 +533,10 @@ void CL_ParseDownload (void) {
 	size = MSG_ReadShort (&net_message);
 	percent = MSG_ReadByte (&net_message);
 
+	/* the server doesn't stream this one */
+	cls.downloadid = 0;
+	cls.downloadstreaming = false;
+
 	if (size == -1) {
 		Com_Printf ("Server does not have this file.\n");
 
@@ -565,3 +598,152 @@ void CL_ParseDownload (void) {
 		CL_RequestNextDownload ();
 	}
 }
+
+/*
+ * A block of a streamed download. Blocks after
+ * a lost one are kept until the server sent it
+ * again.
+ */
+void CL_ParseDownloadBlock (void) {
+	int		id, size, offset, length;
+	int		block, i;
+	byte	*data;
+	char	name[MAX_OSPATH];
+	char	oldn[MAX_OSPATH];
+	char	newn[MAX_OSPATH];
+
+	id = MSG_ReadByte (&net_message);
+	size = MSG_ReadLong (&net_message);
+	offset = MSG_ReadLong (&net_message);
+	length = MSG_ReadShort (&net_message);
+
+	if (length < 0 || length > DOWNLOAD_BLOCKSIZE || net_message.readcount + length > net_message.cursize)
+		Com_Error (ERR_DROP, "CL_ParseDownloadBlock: bad length");
+
+	data = net_message.data + net_message.readcount;
+	net_message.readcount += length;
+
+	/* a late block of an earlier download */
+	if (id != cls.downloadid || offset < cls.downloadposition || offset + length > size ||
+	    (offset - cl_downloadbase) % DOWNLOAD_BLOCKSIZE)
+		return;
+
+	cls.downloadstreaming = true;
+	block = (offset - cl_downloadbase) / DOWNLOAD_BLOCKSIZE;
+
+	if (offset > cls.downloadposition) {
+		/* one got lost, keep this one */
+		if (offset - cls.downloadposition >= DOWNLOAD_WINDOW * DOWNLOAD_BLOCKSIZE)
+			return;
+
+		i = block % DOWNLOAD_WINDOW;
+		memcpy (cl_ahead[i], data, length);
+		cl_aheadlength[i] = length;
+		cl_aheadblock[i] = block;
+		cl_aheadchanged = true;
+		return;
+	}
+
+	/* open the file if not opened yet */
+	if (!cls.download) {
+		CL_DownloadFileName(name, sizeof(name), cls.downloadtempname);
+
+		FS_CreatePath (name);
+
+		cls.download = fopen (name, "wb");
+
+		if (!cls.download) {
+			Com_Printf ("Failed to open %s\n", cls.downloadtempname);
+			cls.downloadid = 0;
+			cls.downloadstreaming = false;
+			CL_RequestNextDownload ();
+			return;
+		}
+	}
+
+	fwrite (data, 1, length, cls.download);
+	cls.downloadposition += length;
+
+	/* and the kept ones that follow it */
+	for (i = ++block % DOWNLOAD_WINDOW; cl_aheadlength[i] && cl_aheadblock[i] == block;
+	     i = ++block % DOWNLOAD_WINDOW) {
+		fwrite (cl_ahead[i], 1, cl_aheadlength[i], cls.download);
+		cls.downloadposition += cl_aheadlength[i];
+		cl_aheadlength[i] = 0;
+	}
+
+	cls.downloadpercent = (int)(100.0f * cls.downloadposition / size);
+
+	if (cls.downloadposition < size)
+		return;
+
+	fclose (cls.download);
+	cls.download = NULL;
+	cls.downloadpercent = 0;
+	cls.downloadstreaming = false;
+
+	/* the last ack is reliable, the server
+	   lets go of the file when it has it */
+	MSG_WriteByte (&cls.netchan.message, clc_stringcmd);
+	MSG_WriteString (&cls.netchan.message, va("nextdl %i %i", size, cls.downloadid));
+	cls.downloadid = 0;
+
+	/* rename the temp file to it's final name */
+	CL_DownloadFileName(oldn, sizeof(oldn), cls.downloadtempname);
+	CL_DownloadFileName(newn, sizeof(newn), cls.downloadname);
+
+	if (rename (oldn, newn))
+		Com_Printf ("failed to rename.\n");
+
+	/* get another file if needed */
+	CL_RequestNextDownload ();
+}
+
+/*
+ * Acks a streamed download in the unreliable
+ * part of a packet. Every packet carries the
+ * bytes received since the last one, and the
+ * ack is repeated every 100 ms if it's lost.
+ * Kept blocks are listed as hex digits, bit n
+ * for the block n after the missing one, so
+ * the server can send the lost ones again.
+ */
+void CL_WriteDownloadAck (sizebuf_t *buf) {
+	char	received[DOWNLOAD_WINDOW / 4 + 2];
+	int		block, length;
+	int		i, n;
+
+	if (!cls.downloadstreaming)
+		return;
+
+	if (cls.downloadposition == cls.downloadacked && !cl_aheadchanged &&
+	    cls.realtime - cls.downloadacktime < 100)
+		return;
+
+	block = (cls.downloadposition - cl_downloadbase) / DOWNLOAD_BLOCKSIZE;
+	memset (received, 0, sizeof(received));
+	received[0] = ' ';
+	length = 0;
+
+	for (n = 1; n < DOWNLOAD_WINDOW; n++) {
+		i = (block + n) % DOWNLOAD_WINDOW;
+
+		if (cl_aheadlength[i] && cl_aheadblock[i] == block + n) {
+			received[1 + n / 4] |= 1 << (n % 4);
+			length = n / 4 + 1;
+		}
+	}
+
+	for (n = 1; n <= length; n++)
+		received[n] = "0123456789abcdef"[(int)received[n]];
+
+	received[length + 1] = 0;
+
+	MSG_WriteByte (buf, clc_stringcmd);
+	MSG_WriteString (buf, va("nextdl %i %i%s", cls.downloadposition, cls.downloadid,
+	                 length ? received : ""));
+
+	cls.downloadacked = cls.downloadposition;
+	cls.downloadacktime = cls.realtime;
+	cl_aheadchanged = false;
+}
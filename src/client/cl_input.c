@@ -479,7 +479,7 @@ void CL_InitInput (void) {
 
 void CL_SendCmd (void) {
 	sizebuf_t	buf;
-	byte		data[128];
+	byte		data[192];
 	int			i;
 	usercmd_t	*cmd, *oldcmd;
 	usercmd_t	nullcmd;
@@ -500,8 +500,11 @@ void CL_SendCmd (void) {
 		return;
 
 	if ( cls.state == ca_connected) {
-		if (cls.netchan.message.cursize	|| curtime - cls.netchan.last_sent > 100 )
-			Netchan_Transmit (&cls.netchan, 0, buf.data);
+		SZ_Init (&buf, data, sizeof(data));
+		CL_WriteDownloadAck (&buf);
+
+		if (buf.cursize || cls.netchan.message.cursize || curtime - cls.netchan.last_sent > 100 )
+			Netchan_Transmit (&cls.netchan, buf.cursize, buf.data);
 
 		return;
 	}
@@ -559,6 +562,9 @@ void CL_SendCmd (void) {
 	                              buf.data + checksumIndex + 1, buf.cursize - checksumIndex - 1,
 	                              cls.netchan.outgoing_sequence);
 
+	/* and the ack of a streamed download */
+	CL_WriteDownloadAck (&buf);
+
 	/* deliver the message */
 	Netchan_Transmit (&cls.netchan, buf.cursize, buf.data);
 }
@@ -55,6 +55,8 @@ cvar_t	*cl_noskins;
 cvar_t	*cl_autoskins;
 cvar_t	*cl_footsteps;
 cvar_t	*cl_timeout;
+cvar_t	*cl_fastconnect;
+cvar_t	*cl_downloadrate;
 cvar_t	*cl_predict;
 cvar_t	*cl_maxfps;
 cvar_t	*cl_drawfps;
@@ -118,6 +120,17 @@ void CL_WriteDemoMessage (void)
 
 	/* the first eight bytes are just packet sequencing stuff */
 	len = net_message.cursize-8;
+
+	/* .dm2 files can't hold longer messages, the server
+	   limits them after "msglen" but some may still be
+	   in flight. Skip to the next uncompressed frame. */
+	if (len > MAX_MSGLEN)
+	{
+		Com_Printf ("Demo message too long, skipped.\n");
+		cls.demowaiting = true;
+		return;
+	}
+
 	swlen = LittleLong(len);
 	fwrite (&swlen, 4, 1, cls.demofile);
 	fwrite (net_message.data+8,	len, 1, cls.demofile);
@@ -143,6 +156,13 @@ void CL_Stop_f (void)
 	cls.demofile = NULL;
 	cls.demorecording = false;
 	Com_Printf ("Stopped demo.\n");
+
+	/* lift the limit from CL_Record_f */
+	if (cls.netchan.fragments)
+	{
+		MSG_WriteByte (&cls.netchan.message, clc_stringcmd);
+		MSG_WriteString (&cls.netchan.message, va("msglen %i", MAX_BIGMSGLEN));
+	}
 }
 
 /*
@@ -194,6 +214,14 @@ void CL_Record_f (void)
 	/* don't start saving messages until a non-delta compressed message is received */
 	cls.demowaiting = true;
 
+	/* servers with fragments send messages up to
+	   MAX_BIGMSGLEN, the .dm2 format ends at MAX_MSGLEN */
+	if (cls.netchan.fragments)
+	{
+		MSG_WriteByte (&cls.netchan.message, clc_stringcmd);
+		MSG_WriteString (&cls.netchan.message, va("msglen %i", MAX_MSGLEN));
+	}
+
 	/* write out messages to hold the startup information */
 	SZ_Init (&buf, buf_data, sizeof(buf_data));
 
@@ -454,6 +482,8 @@ void CL_InitLocal (void)
 
 	CL_InitInput ();
 
+	CL_InitTimedemo ();
+
 	adr0 = Cvar_Get( "adr0", "", CVAR_ARCHIVE );
 	adr1 = Cvar_Get( "adr1", "", CVAR_ARCHIVE );
 	adr2 = Cvar_Get( "adr2", "", CVAR_ARCHIVE );
@@ -499,6 +529,8 @@ void CL_InitLocal (void)
 	cl_showmiss = Cvar_Get ("cl_showmiss", "0", 0);
 	cl_showclamp = Cvar_Get ("showclamp", "0", 0);
 	cl_timeout = Cvar_Get ("cl_timeout", "120", 0);
+	cl_fastconnect = Cvar_Get ("cl_fastconnect", "1", CVAR_ARCHIVE);
+	cl_downloadrate = Cvar_Get ("cl_downloadrate", "1000000", CVAR_ARCHIVE);
 	cl_paused = Cvar_Get ("paused", "0", 0);
 	cl_timedemo = Cvar_Get ("timedemo", "0", 0);
 
@@ -714,15 +746,23 @@ void CL_Frame (int msec)
 	if (msec > 5000)
 		cls.netchan.last_received = Sys_Milliseconds ();
 
+	CL_TimedemoBeginFrame ();
+
 	/* fetch results from server */
 	CL_ReadPackets ();
 
+	CL_TimedemoMark (TD_PARSE);
+
 	/* send a new command message to the server */
 	CL_SendCommand ();
 
+	CL_TimedemoMark (TD_OTHER);
+
 	/* predict all unacknowledged movements */
 	CL_PredictMovement ();
 
+	CL_TimedemoMark (TD_PREDICT);
+
 	/* allow renderer DLL change */
 	VID_CheckChanges ();
 
@@ -733,8 +773,12 @@ void CL_Frame (int msec)
 	if (host_speeds->value)
 		time_before_ref = Sys_Milliseconds ();
 
+	CL_TimedemoMark (TD_OTHER);
+
 	SCR_UpdateScreen ();
 
+	CL_TimedemoMark (TD_REFRESH);
+
 	if (host_speeds->value)
 		time_after_ref = Sys_Milliseconds ();
 
@@ -744,6 +788,8 @@ void CL_Frame (int msec)
 	CDAudio_Update();
 #endif
 
+	CL_TimedemoMark (TD_SOUND);
+
 	/* advance local effects for next frame */
 	CL_RunDLights ();
 
@@ -753,6 +799,8 @@ void CL_Frame (int msec)
 
 	SCR_RunConsole ();
 
+	CL_TimedemoEndFrame ();
+
 	cls.framecount++;
 
 	if ( log_stats->value )
@@ -32,6 +32,7 @@ extern cvar_t	*msg;
 extern cvar_t	*rcon_client_password;
 extern cvar_t	*rcon_address;
 extern cvar_t	*cl_timeout;
+extern cvar_t	*cl_fastconnect;
 
 /*
  * adds the current command line as a clc_stringcmd to the client
@@ -83,6 +84,8 @@ void CL_ForwardToServer_f (void)
  */
 void CL_Drop (void)
 {
+	CL_ClearGamestate ();
+
 	if (cls.state == ca_uninitialized)
 		return;
 
@@ -104,6 +107,7 @@ void CL_SendConnectPacket (void)
 {
 	netadr_t	adr;
 	int		port;
+	char	*fast;
 
 	memset(&adr, 0, sizeof(adr));
 
@@ -121,8 +125,16 @@ void CL_SendConnectPacket (void)
 
 	userinfo_modified = false;
 
-	Netchan_OutOfBandPrint (NS_CLIENT, adr, "connect %i %i %i \"%s\"\n",
-	                        PROTOCOL_VERSION, port, cls.challenge, Cvar_Userinfo() );
+	/* ask for the gamestate in one compressed piece and for
+	   fragmented messages, older servers ignore the extras */
+#ifdef ZIP
+	fast = cl_fastconnect->value ? " fast" : "";
+#else
+	fast = "";
+#endif
+
+	Netchan_OutOfBandPrint (NS_CLIENT, adr, "connect %i %i %i \"%s\"%s frag\n",
+	                        PROTOCOL_VERSION, port, cls.challenge, Cvar_Userinfo(), fast );
 }
 
 /*
@@ -280,6 +292,8 @@ void CL_Disconnect (void)
 		if (time > 0)
 			Com_Printf ("%i frames, %3.1f seconds: %3.1f fps\n", cl.timedemo_frames,
 			            time/1000.0, cl.timedemo_frames*1000.0 / time);
+
+		CL_TimedemoReport ();
 	}
 
 	VectorClear (cl.refdef.blend);
@@ -321,6 +335,9 @@ void CL_Disconnect (void)
 		cls.download = NULL;
 	}
 
+	cls.downloadid = 0;
+	cls.downloadstreaming = false;
+
 	cls.state = ca_disconnected;
 }
 
@@ -530,6 +547,9 @@ void CL_ConnectionlessPacket (void)
 
 		Netchan_Setup (NS_CLIENT, &cls.netchan, net_from, cls.quakePort);
 
+		if (!strcmp(Cmd_Argv(1), "frag"))
+			Netchan_EnableFragments (&cls.netchan);
+
 		MSG_WriteChar (&cls.netchan.message, clc_stringcmd);
 		MSG_WriteString (&cls.netchan.message, "new");
 		cls.state = ca_connected;
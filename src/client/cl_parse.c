@@ -26,8 +26,15 @@
 
 #include "header/client.h"
 
+#ifdef ZIP
+ #include <zlib.h>
+#endif
+
+#define MAX_GAMESTATE 0x100000 /* sanity limit for svc_gamestate */
+
 void CL_DownloadFileName(char *dest, int destlen, char *fn);
 void CL_ParseDownload (void);
+void CL_ParseDownloadBlock (void);
 
 int	bitcounts[32]; /* just for protocol profiling */
 
@@ -54,7 +61,9 @@ char *svc_strings[256] = {
 	"svc_playerinfo",
 	"svc_packetentities",
 	"svc_deltapacketentities",
-	"svc_frame"
+	"svc_frame",
+	"svc_gamestate",
+	"svc_downloadblock"
 };
 
 void CL_RegisterSounds (void) {
@@ -542,7 +551,9 @@ void CL_ParseFrame (void) {
 	if (cl.frame.deltaframe <= 0) {
 		cl.frame.valid = true; /* uncompressed frame */
 		old = NULL;
-		cls.demowaiting = false; /* we can start recording now */
+		/* we can start recording now */
+		if (net_message.cursize - 8 <= MAX_MSGLEN)
+			cls.demowaiting = false;
 
 	} else {
 		old = &cl.frames[cl.frame.deltaframe & UPDATE_MASK];
@@ -945,6 +956,113 @@ void SHOWNET(char *s) {
 		Com_Printf ("%3i:%s\n", net_message.readcount-1, s);
 }
 
+static byte		*cl_gamestate; /* compressed, as far as received */
+static int		cl_gamestatesize;
+static int		cl_gamestatecount;
+static byte		*cl_gamestatedata; /* uncompressed, while parsed */
+static sizebuf_t	cl_savedmessage;
+
+/*
+ * Throws away a partial gamestate. If an error
+ * hit while it was parsed, net_message still
+ * points to it and is put back.
+ */
+void CL_ClearGamestate (void) {
+	if (cl_gamestatedata) {
+		net_message = cl_savedmessage;
+		Z_Free (cl_gamestatedata);
+		cl_gamestatedata = NULL;
+	}
+
+	if (cl_gamestate) {
+		Z_Free (cl_gamestate);
+		cl_gamestate = NULL;
+	}
+
+	cl_gamestatesize = cl_gamestatecount = 0;
+}
+
+/*
+ * A part of the compressed configstrings and baselines,
+ * sent instead of the configstrings and baselines
+ * commands when we connected with "fast". Once all
+ * parts are there, the blob is parsed like the
+ * messages it was made of.
+ */
+void CL_ParseGamestate (void) {
+	int		total, length, offset, size;
+	int		cmd;
+
+	total = MSG_ReadLong (&net_message);
+	length = MSG_ReadLong (&net_message);
+	offset = MSG_ReadLong (&net_message);
+	size = MSG_ReadShort (&net_message);
+
+	if (total <= 0 || total > MAX_GAMESTATE || length <= 0 || length > MAX_GAMESTATE ||
+	    size < 0 || offset < 0 || offset + size > total ||
+	    net_message.readcount + size > net_message.cursize)
+		Com_Error (ERR_DROP, "CL_ParseGamestate: bad part");
+
+	if (offset == 0) {
+		CL_ClearGamestate ();
+		cl_gamestate = Z_Malloc (total);
+		cl_gamestatesize = total;
+
+	} else if (!cl_gamestate || total != cl_gamestatesize || offset != cl_gamestatecount)
+		Com_Error (ERR_DROP, "CL_ParseGamestate: part out of order");
+
+	memcpy (cl_gamestate + offset, net_message.data + net_message.readcount, size);
+	net_message.readcount += size;
+	cl_gamestatecount = offset + size;
+
+	/* the server sends the next part when it
+	   sees the ack, so send one right away */
+	MSG_WriteByte (&cls.netchan.message, clc_nop);
+
+	if (cl_gamestatecount < cl_gamestatesize)
+		return;
+
+#ifdef ZIP
+	{
+		uLongf	ulength;
+
+		byte	*data;
+
+		data = Z_Malloc (length);
+		ulength = length;
+
+		if (uncompress (data, &ulength, cl_gamestate, total) != Z_OK ||
+		    ulength != length) {
+			Z_Free (data);
+			Com_Error (ERR_DROP, "CL_ParseGamestate: bad data");
+		}
+
+		cl_savedmessage = net_message;
+		cl_gamestatedata = data;
+	}
+
+	SZ_Init (&net_message, cl_gamestatedata, length);
+	net_message.cursize = length;
+
+	while (net_message.readcount < net_message.cursize) {
+		cmd = MSG_ReadByte (&net_message);
+
+		if (cmd == svc_configstring)
+			CL_ParseConfigString ();
+
+		else if (cmd == svc_spawnbaseline)
+			CL_ParseBaseline ();
+
+		else
+			Com_Error (ERR_DROP, "CL_ParseGamestate: illegible message %i", cmd);
+	}
+
+	CL_ClearGamestate ();
+#else
+	Com_Error (ERR_DROP, "CL_ParseGamestate: no zlib");
+#endif
+}
+
 void CL_ParseServerMessage (void) {
 	int		cmd;
 	char	*s;
@@ -1001,6 +1119,9 @@ void CL_ParseServerMessage (void) {
 					cls.download = NULL;
 				}
 
+				cls.downloadid = 0;
+				cls.downloadstreaming = false;
+
 				cls.state = ca_connecting;
 				cls.connect_time = -99999; /* CL_CheckForResend() will fire immediately */
 				break;
@@ -1064,6 +1185,14 @@ void CL_ParseServerMessage (void) {
 				CL_ParseFrame ();
 				break;
 
+			case svc_gamestate:
+				CL_ParseGamestate ();
+				break;
+
+			case svc_downloadblock:
+				CL_ParseDownloadBlock ();
+				break;
+
 			case svc_inventory:
 				CL_ParseInventory ();
 				break;
@@ -112,6 +112,8 @@ void CL_ClipMoveToEntities ( vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end,
 		if (tr->allsolid)
 			return;
 
+		trace_stats[TRACE_PREDICTION].entities++;
+
 		trace = CM_TransformedBoxTrace (start, end,
 		                                mins, maxs, headnode,  MASK_PLAYERSOLID,
 		                                ent->origin, angles);
@@ -134,6 +136,11 @@ void CL_ClipMoveToEntities ( vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end,
 
 trace_t		CL_PMTrace (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end) {
 	trace_t	t;
+	int		caller;
+
+	caller = trace_caller;
+	trace_caller = TRACE_PREDICTION;
+	trace_stats[TRACE_PREDICTION].traces++;
 
 	/* check against world */
 	t = CM_BoxTrace (start, end, mins, maxs, 0, MASK_PLAYERSOLID);
@@ -144,6 +151,8 @@ trace_t		CL_PMTrace (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end) {
 	/* check all other solid models */
 	CL_ClipMoveToEntities (start, mins, maxs, end, &t);
 
+	trace_caller = caller;
+
 	return t;
 }
 
@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 1997-2001 Id Software, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * =======================================================================
+ *
+ * This file implements the timedemo benchmark. While "timedemo" is set
+ * every rendered frame is timed and split into its phases. When the
+ * demo ends the frame time distribution is printed and optionally
+ * written to a CSV file. "timedemo_loops" plays the demo several
+ * times in a row.
+ *
+ * =======================================================================
+ */
+
+#include "header/client.h"
+
+static const char *td_phasenames[TD_NUMPHASES] = {
+	"parse", "predict", "refresh", "sound", "server", "other"
+};
+
+typedef struct
+{
+	int		pass;
+	int		total;
+	int		phase[TD_NUMPHASES];
+} td_frame_t;
+
+static td_frame_t	*td_frames;
+static int			td_numframes;
+static int			td_maxframes;
+static int			td_passes;
+
+static td_frame_t	td_current;
+static long long	td_stamp;
+
+cvar_t	*timedemo_csv;
+cvar_t	*timedemo_loops;
+
+void CL_InitTimedemo (void)
+{
+	timedemo_csv = Cvar_Get ("timedemo_csv", "", 0);
+	timedemo_loops = Cvar_Get ("timedemo_loops", "1", 0);
+}
+
+/*
+ * Called at the start of each client
+ * frame. The server frame has already
+ * run at this point.
+ */
+void CL_TimedemoBeginFrame (void)
+{
+	if (!cl_timedemo->value)
+		return;
+
+	memset (&td_current, 0, sizeof(td_current));
+	td_current.phase[TD_SERVER] = time_server_usec;
+
+	td_stamp = Sys_Microseconds ();
+}
+
+/*
+ * Charges the time since the
+ * last mark to the given phase.
+ */
+void CL_TimedemoMark (int phase)
+{
+	long long	now;
+
+	if (!cl_timedemo->value)
+		return;
+
+	now = Sys_Microseconds ();
+	td_current.phase[phase] += (int)(now - td_stamp);
+	td_stamp = now;
+}
+
+void CL_TimedemoEndFrame (void)
+{
+	td_frame_t	*frames;
+	int			i;
+
+	if (!cl_timedemo->value)
+		return;
+
+	CL_TimedemoMark (TD_OTHER);
+
+	/* only frames that were actually
+	   rendered by V_RenderView count */
+	if (cls.state != ca_active || !cl.timedemo_start)
+		return;
+
+	/* first frame of a new pass */
+	if (cl.timedemo_frames == 1)
+	{
+		td_passes++;
+
+		/* let the server restart the
+		   demo when it's finished */
+		if (td_passes < timedemo_loops->value)
+			Cvar_Set ("nextserver", va("demomap \"%s\"", Cvar_VariableString ("mapname")));
+	}
+
+	if (td_numframes == td_maxframes)
+	{
+		td_maxframes = td_maxframes ? td_maxframes * 2 : 4096;
+		frames = Z_Malloc (td_maxframes * sizeof(td_frame_t));
+
+		if (td_frames)
+		{
+			memcpy (frames, td_frames, td_numframes * sizeof(td_frame_t));
+			Z_Free (td_frames);
+		}
+
+		td_frames = frames;
+	}
+
+	td_current.pass = td_passes;
+
+	for (i = 0; i < TD_NUMPHASES; i++)
+		td_current.total += td_current.phase[i];
+
+	td_frames[td_numframes++] = td_current;
+}
+
+static int CL_TimedemoCompare (const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+ * Prints min, median, p95, p99, max
+ * and mean of one column in ms.
+ */
+static void CL_TimedemoPrintColumn (const char *name, int *values)
+{
+	int			i;
+	long long	sum;
+
+	qsort (values, td_numframes, sizeof(int), CL_TimedemoCompare);
+
+	for (i = 0, sum = 0; i < td_numframes; i++)
+		sum += values[i];
+
+	Com_Printf ("%-8s %7.2f %7.2f %7.2f %7.2f %7.2f %7.2f\n", name,
+	            values[0] / 1000.0,
+	            values[td_numframes / 2] / 1000.0,
+	            values[(td_numframes * 95) / 100] / 1000.0,
+	            values[(td_numframes * 99) / 100] / 1000.0,
+	            values[td_numframes - 1] / 1000.0,
+	            (sum / td_numframes) / 1000.0);
+}
+
+static void CL_TimedemoWriteCSV (void)
+{
+	char		name[MAX_OSPATH];
+	FILE		*f;
+	td_frame_t	*fr;
+	int			i, j;
+
+	Com_sprintf (name, sizeof(name), "%s/%s", FS_Gamedir (), timedemo_csv->string);
+
+	f = fopen (name, "w");
+
+	if (!f)
+	{
+		Com_Printf ("Couldn't write %s.\n", name);
+		return;
+	}
+
+	fprintf (f, "frame,pass,total");
+
+	for (j = 0; j < TD_NUMPHASES; j++)
+		fprintf (f, ",%s", td_phasenames[j]);
+
+	fprintf (f, "\n");
+
+	for (i = 0; i < td_numframes; i++)
+	{
+		fr = &td_frames[i];
+
+		fprintf (f, "%i,%i,%i", i, fr->pass, fr->total);
+
+		for (j = 0; j < TD_NUMPHASES; j++)
+			fprintf (f, ",%i", fr->phase[j]);
+
+		fprintf (f, "\n");
+	}
+
+	fclose (f);
+
+	Com_Printf ("Wrote %s (times in usec).\n", name);
+}
+
+/*
+ * Called when the timedemo ends. Prints the
+ * frame time distribution of all passes.
+ */
+void CL_TimedemoReport (void)
+{
+	int		*values;
+	int		i, j;
+
+	if (td_numframes > 0)
+	{
+		values = Z_Malloc (td_numframes * sizeof(int));
+
+		Com_Printf ("%i frames in %i passes, times in ms:\n", td_numframes, td_passes);
+		Com_Printf ("%-8s %7s %7s %7s %7s %7s %7s\n", "", "min", "median", "p95", "p99", "max", "mean");
+
+		for (i = 0; i < td_numframes; i++)
+			values[i] = td_frames[i].total;
+
+		CL_TimedemoPrintColumn ("total", values);
+
+		for (j = 0; j < TD_NUMPHASES; j++)
+		{
+			for (i = 0; i < td_numframes; i++)
+				values[i] = td_frames[i].phase[j];
+
+			CL_TimedemoPrintColumn (td_phasenames[j], values);
+		}
+
+		Z_Free (values);
+
+		if (timedemo_csv->string[0])
+			CL_TimedemoWriteCSV ();
+	}
+
+	if (td_frames)
+		Z_Free (td_frames);
+
+	td_frames = NULL;
+	td_numframes = td_maxframes = 0;
+	td_passes = 0;
+}
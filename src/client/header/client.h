@@ -244,6 +244,11 @@ typedef struct
 	int			downloadnumber;
 	dltype_t	downloadtype;
 	int			downloadpercent;
+	int			downloadid; /* tags the blocks of a streamed download, 0 for none */
+	qboolean	downloadstreaming; /* the server streams the download */
+	int			downloadposition; /* bytes of the streamed download we have */
+	int			downloadacked;
+	int			downloadacktime;
 
 	/* demo recording info must be here, so it isn't cleared on level change */
 	qboolean	demorecording;
@@ -286,6 +291,8 @@ extern	cvar_t	*freelook;
 extern	cvar_t	*cl_lightlevel;
 extern	cvar_t	*cl_paused;
 extern	cvar_t	*cl_timedemo;
+extern	cvar_t	*timedemo_csv;
+extern	cvar_t	*timedemo_loops;
 extern	cvar_t	*cl_vwep;
 
 typedef struct
@@ -392,6 +399,8 @@ void CL_ParseFrame (void);
 
 void CL_ParseTEnt (void);
 void CL_ParseConfigString (void);
+void CL_ParseGamestate (void);
+void CL_ClearGamestate (void);
 void CL_AddMuzzleFlash (void);
 void CL_AddMuzzleFlash2 (void);
 void SmokeAndFlash(vec3_t origin);
@@ -427,6 +436,7 @@ void CL_GetChallengePacket (void);
 void CL_PingServers_f (void);
 void CL_Snd_Restart_f (void);
 void CL_RequestNextDownload (void);
+void CL_WriteDownloadAck (sizebuf_t *buf);
 
 typedef struct
 {
@@ -512,4 +522,22 @@ void CL_DrawInventory (void);
 
 void CL_PredictMovement (void);
 
+/* timedemo benchmark phases */
+enum
+{
+	TD_PARSE,
+	TD_PREDICT,
+	TD_REFRESH,
+	TD_SOUND,
+	TD_SERVER,
+	TD_OTHER,
+	TD_NUMPHASES
+};
+
+void CL_InitTimedemo (void);
+void CL_TimedemoBeginFrame (void);
+void CL_TimedemoMark (int phase);
+void CL_TimedemoEndFrame (void);
+void CL_TimedemoReport (void);
+
 #endif
@@ -39,6 +39,10 @@ static int cmd_argc;
 static char     *cmd_argv [ MAX_STRING_TOKENS ];
 static char     *cmd_null_string = "";
 static char cmd_args [ MAX_STRING_CHARS ];
+
+/* the argv strings of the current command, every
+   token fits, so tokenizing never allocates */
+static char cmd_tokens [ MAX_STRING_TOKENS * ( MAX_TOKEN_CHARS + 1 ) ];
 char retval [ 256 ];
 
 static cmd_function_t  *cmd_functions;  /* possible commands to execute */
@@ -69,6 +73,10 @@ Cmd_Args ( void )
 	return ( cmd_args );
 }
 
+/*
+ * Expands the macros in place in a static
+ * buffer. Text without a $ is returned as is.
+ */
 char *
 Cmd_MacroExpandString ( char *text )
 {
@@ -76,7 +84,6 @@ Cmd_MacroExpandString ( char *text )
 	qboolean inquote;
 	char    *scan;
 	static char expanded [ MAX_STRING_CHARS ];
-	char temporary [ MAX_STRING_CHARS ];
 	char    *token, *start;
 
 	inquote = false;
@@ -129,12 +136,18 @@ Cmd_MacroExpandString ( char *text )
 			return ( NULL );
 		}
 
-		strncpy( temporary, scan, i );
-		strcpy( temporary + i, token );
-		strcpy( temporary + i + j, start );
+		/* the first macro moves the line
+		   into the buffer, the rest is
+		   replaced in place */
+		if ( scan != expanded )
+		{
+			start = expanded + ( start - scan );
+			strcpy( expanded, scan );
+			scan = expanded;
+		}
 
-		strcpy( expanded, temporary );
-		scan = expanded;
+		memmove( scan + i + j, start, strlen( start ) + 1 );
+		memcpy( scan + i, token, j );
 		i--;
 
 		if ( ++count == 100 )
@@ -160,15 +173,12 @@ Cmd_MacroExpandString ( char *text )
 void
 Cmd_TokenizeString ( char *text, qboolean macroExpand )
 {
-	int i;
 	const char  *com_token;
+	char    *arena;
+	int l;
 
-	/* clear the args from the last string */
-	for ( i = 0; i < cmd_argc; i++ )
-	{
-		Z_Free( cmd_argv [ i ] );
-	}
-
+	/* the args from the last string are overwritten */
+	arena = cmd_tokens;
 	cmd_argc = 0;
 	cmd_args [ 0 ] = 0;
 
@@ -206,12 +216,18 @@ Cmd_TokenizeString ( char *text, qboolean macroExpand )
 		/* set cmd_args to everything after the first arg */
 		if ( cmd_argc == 1 )
 		{
-			int l;
+			l = strlen( text );
+
+			if ( l >= sizeof( cmd_args ) )
+			{
+				l = sizeof( cmd_args ) - 1;
+			}
 
-			strcpy( cmd_args, text );
+			memcpy( cmd_args, text, l );
+			cmd_args [ l ] = 0;
 
 			/* strip off any trailing whitespace */
-			l = strlen( cmd_args ) - 1;
+			l--;
 
 			for ( ; l >= 0; l-- )
 			{
@@ -234,10 +250,14 @@ Cmd_TokenizeString ( char *text, qboolean macroExpand )
 			return;
 		}
 
-		if ( cmd_argc < MAX_STRING_TOKENS )
+		l = strlen( com_token ) + 1;
+
+		if ( ( cmd_argc < MAX_STRING_TOKENS ) &&
+			 ( arena + l <= cmd_tokens + sizeof( cmd_tokens ) ) )
 		{
-			cmd_argv [ cmd_argc ] = Z_Malloc( strlen( com_token ) + 1 );
-			strcpy( cmd_argv [ cmd_argc ], com_token );
+			memcpy( arena, com_token, l );
+			cmd_argv [ cmd_argc ] = arena;
+			arena += l;
 			cmd_argc++;
 		}
 	}
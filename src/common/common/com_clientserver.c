@@ -30,8 +30,10 @@
 
 #define	MAXPRINTMSG	4096
 
-FILE	*logfile;
 cvar_t	*logfile_active; /* 1 = buffer log, 2 = flush after each print */
+cvar_t	*logfile_flush; /* ms the buffered log may lag behind */
+cvar_t	*logfile_buffer; /* kb of log waiting for the disk */
+static qboolean	logfile_open;
 jmp_buf abortframe; /* an ERR_DROP occured, exit the entire frame */
 int		server_state;
 
@@ -100,22 +102,21 @@ void Com_Printf (char *fmt, ...)
 	{
 		char	name[MAX_QPATH];
 
-		if (!logfile)
+		/* written by a thread, printing
+		   never waits for the disk */
+		if (!logfile_open)
 		{
 			Com_sprintf (name, sizeof(name), "%s/qconsole.log", FS_Gamedir ());
 
-			if (logfile_active->value > 2)
-				logfile = fopen (name, "a");
-
-			else
-				logfile = fopen (name, "w");
+			logfile_open = Sys_LogOpen (name, logfile_active->value > 2,
+					logfile_buffer ? (int)logfile_buffer->value * 1024 : 0);
 		}
 
-		if (logfile)
-			fprintf (logfile, "%s", msg);
-
 		if (logfile_active->value > 1)
-			fflush (logfile); /* force it to save every time */
+			Sys_LogWrite (msg, 0); /* force it to save every time */
+
+		else
+			Sys_LogWrite (msg, logfile_flush ? (int)logfile_flush->value : 1000);
 	}
 }
 
@@ -203,11 +204,7 @@ void Com_Error (int code, char *fmt, ...)
 #endif
 	}
 
-	if (logfile)
-	{
-		fclose (logfile);
-		logfile = NULL;
-	}
+	Sys_LogClose ();
 
 	Sys_Error ("%s", msg);
 	recursive = false;
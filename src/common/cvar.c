@@ -121,6 +121,9 @@ cvar_t *Cvar_Get (char *var_name, char *var_value, int flags)
 
 	if (var)
 	{
+		if (flags & ~var->flags & CVAR_SERVERINFO)
+			serverinfo_modified = true;
+
 		var->flags |= flags;
 		return var;
 	}
@@ -149,6 +152,9 @@ cvar_t *Cvar_Get (char *var_name, char *var_value, int flags)
 
 	var->flags = flags;
 
+	if (flags & CVAR_SERVERINFO)
+		serverinfo_modified = true;
+
 	return var;
 }
 
@@ -207,6 +213,9 @@ cvar_t *Cvar_Set2 (char *var_name, char *value, qboolean force)
 				var->string = CopyString(value);
 				var->value = (float)atof (var->string);
 
+				if (var->flags & CVAR_SERVERINFO)
+					serverinfo_modified = true;
+
 				if (!strcmp(var->name, "game"))
 				{
 					FS_SetGamedir (var->string);
@@ -235,6 +244,9 @@ cvar_t *Cvar_Set2 (char *var_name, char *value, qboolean force)
 	if (var->flags & CVAR_USERINFO)
 		userinfo_modified = true;
 
+	if (var->flags & CVAR_SERVERINFO)
+		serverinfo_modified = true;
+
 	Z_Free (var->string);
 
 	var->string = CopyString(value);
@@ -269,6 +281,9 @@ cvar_t *Cvar_FullSet (char *var_name, char *value, int flags)
 	if (var->flags & CVAR_USERINFO)
 		userinfo_modified = true;
 
+	if ((var->flags | flags) & CVAR_SERVERINFO)
+		serverinfo_modified = true;
+
 	Z_Free (var->string);
 
 	var->string = CopyString(value);
@@ -309,6 +324,9 @@ void Cvar_GetLatchedVars (void)
 		var->latched_string = NULL;
 		var->value = atof(var->string);
 
+		if (var->flags & CVAR_SERVERINFO)
+			serverinfo_modified = true;
+
 		if (!strcmp(var->name, "game"))
 		{
 			FS_SetGamedir (var->string);
@@ -445,6 +463,7 @@ void Cvar_List_f (void)
 }
 
 qboolean userinfo_modified;
+qboolean serverinfo_modified;
 
 char *Cvar_BitInfo (int bit)
 {
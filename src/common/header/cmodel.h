@@ -53,9 +53,19 @@ typedef struct
 	int			contents;
 	int			numsides;
 	int			firstbrushside;
-	int			checkcount;	/* to avoid repeated testings */
 } cbrush_t;
 
+/* node of the compact collision layout,
+   the plane is stored inline */
+typedef struct
+{
+	vec3_t		normal;
+	float		dist;
+	int			type;
+	int			children[2];
+	int			pad;		/* to 32 bytes */
+} ccnode_t;
+
 typedef struct
 {
 	int		numareaportals;
@@ -64,8 +74,6 @@ typedef struct
 	int		floodvalid;
 } carea_t;
 
-int			checkcount;
-
 char		map_name[MAX_QPATH];
 
 int			numbrushsides;
@@ -114,10 +122,32 @@ cvar_t		*map_noareas;
 void	CM_InitBoxHull (void);
 void	FloodAreaConnections (void);
 
-#ifndef DEDICATED_ONLY
 int		c_pointcontents;
-int		c_traces, c_brush_traces;
-#endif
+
+/* trace recordings of "tracerecord", a header with
+   TRACERECORD_IDENT, TRACERECORD_VERSION and the
+   map name followed by the traces, little endian */
+typedef struct
+{
+	float	start[3], end[3];
+	float	mins[3], maxs[3];
+	int		headnode;
+	int		brushmask;
+} recordedtrace_t;
+
+#define TRACERECORD_IDENT	(('R'<<24)+('T'<<16)+('M'<<8)+'C')
+#define TRACERECORD_VERSION	1
+
+/* compact collision layout, see cm_compact.c */
+extern ccnode_t	map_cnodes[MAX_MAP_NODES+6];
+extern cvar_t	*cm_compact;
+
+void	CM_BuildCompact (void);
+void	CM_UpdateCompactBox (void);
+void	CM_ClipBoxToBrushCompact (tracecontext_t *ctx, vec3_t mins, vec3_t maxs,
+                                  vec3_t p1, vec3_t p2, trace_t *trace, int brushnum);
+void	CM_TestBoxInBrushCompact (tracecontext_t *ctx, vec3_t mins, vec3_t maxs,
+                                  vec3_t p1, trace_t *trace, int brushnum);
 
 int CM_BoxLeafnums_headnode (vec3_t mins, vec3_t maxs, int *list, int listsize, int headnode, int *topnode);
 
@@ -185,9 +185,15 @@ enum svc_ops_e
 	svc_playerinfo,				/* variable */
 	svc_packetentities,			/* [...] */
 	svc_deltapacketentities,	/* [...] */
-	svc_frame
+	svc_frame,
+	svc_gamestate,			/* [long total] [long length] [long offset] [short size] [size bytes] */
+	svc_downloadblock		/* [byte id] [long size] [long offset] [short length] [length bytes] */
 };
 
+/* streamed downloads */
+#define DOWNLOAD_BLOCKSIZE 1280	/* one block fits into a packet */
+#define DOWNLOAD_WINDOW 64		/* most blocks in flight */
+
 /* ============================================== */
 
 /* client to server */
@@ -452,10 +458,15 @@ extern	qboolean	userinfo_modified;
 /* this is set each time a CVAR_USERINFO variable is changed */
 /* so that the client knows to send it to the server */
 
+extern	qboolean	serverinfo_modified;
+/* this is set each time a CVAR_SERVERINFO variable is changed */
+/* so that the server knows to rebuild its status string */
+
 /* NET */
 
 #define	PORT_ANY	-1
 #define	MAX_MSGLEN		1400		/* max length of a message */
+#define	MAX_BIGMSGLEN	0x4000		/* max length of a message sent in fragments */
 #define	PACKET_HEADER	10			/* two ints and a short */
 
 typedef enum
@@ -494,6 +505,7 @@ qboolean	NET_IsLocalAddress (netadr_t adr);
 char		*NET_AdrToString (netadr_t a);
 qboolean	NET_StringToAdr (char *s, netadr_t *a);
 void		NET_Sleep(int msec);
+void		NET_Stub (qboolean stub);
 
 /*=================================================================== */
 
@@ -527,19 +539,38 @@ typedef struct
 
 	/* reliable staging and holding areas */
 	sizebuf_t	message;		/* writing buffer to send to server */
-	byte		message_buf[MAX_MSGLEN-16];		/* leave space for header */
+	byte		message_buf[MAX_BIGMSGLEN-16];	/* leave space for header */
 
 	/* message is copied to this buffer when it is first transfered */
 	int			reliable_length;
-	byte		reliable_buf[MAX_MSGLEN-16];	/* unacked reliable message */
+	byte		reliable_buf[MAX_BIGMSGLEN-16];	/* unacked reliable message */
+
+	/* negotiated at connect, messages up to maxmsglen
+	   are split into fragments of at most MAX_MSGLEN */
+	qboolean	fragments;
+	int			maxmsglen;			/* MAX_MSGLEN or MAX_BIGMSGLEN */
+
+	int			fragment_sequence;	/* of the message being reassembled */
+	int			fragment_length;
+	byte		fragment_buf[MAX_BIGMSGLEN];
+
+	int			fragments_sent;
+	int			fragments_received;
+	int			fragments_dropped;
 } netchan_t;
 
 extern	netadr_t	net_from;
 extern	sizebuf_t	net_message;
-extern	byte		net_message_buffer[MAX_MSGLEN];
+extern	byte		net_message_buffer[MAX_BIGMSGLEN];
+
+extern	int			net_fragments_sent;
+extern	int			net_fragments_received;
+extern	int			net_fragments_dropped;
 
 void Netchan_Init (void);
 void Netchan_Setup (netsrc_t sock, netchan_t *chan, netadr_t adr, int qport);
+void Netchan_EnableFragments (netchan_t *chan);
+void Netchan_SetMaxMsgLen (netchan_t *chan, int maxmsglen);
 
 qboolean Netchan_NeedReliable (netchan_t *chan);
 void Netchan_Transmit (netchan_t *chan, int length, byte *data);
@@ -597,6 +628,72 @@ qboolean	CM_HeadnodeVisible (int headnode, byte *visbits);
 
 void		CM_WritePortalState (FILE *f);
 
+/* trace statistics, split by who traced */
+typedef enum
+{
+	TRACE_GAME,			/* gi.trace outside of pmove */
+	TRACE_PMOVE,		/* server side player movement */
+	TRACE_PREDICTION,	/* client side prediction */
+	TRACE_NUMCALLERS
+} tracecaller_t;
+
+#define	TRACE_NUMBUCKETS	10
+
+typedef struct
+{
+	int		traces;		/* SV_Trace or CL_PMTrace */
+	int		boxtraces;	/* CM_BoxTrace, world and entities */
+	int		nodes;		/* visited in CM_RecursiveHullCheck */
+	int		brushes;	/* clipped against */
+	int		entities;	/* clipped against */
+
+	/* nodes + brushes of each box trace,
+	   bucket n holds < 2^(n+1) */
+	int		cost[TRACE_NUMBUCKETS];
+} tracestats_t;
+
+extern	tracestats_t	trace_stats[TRACE_NUMCALLERS];
+extern	int				trace_caller;
+
+void		CM_ShowTrace (void);
+void		CM_TraceStats_f (void);
+void		CM_MergeTraceStats (tracestats_t *stats);
+void		CM_TraceRecord_f (void);
+void		CM_TraceBench_f (void);
+
+/* everything a trace needs, traces with their own context
+   may run in parallel as long as the map isn't changed and
+   CM_HeadnodeForBox isn't called at the same time */
+typedef struct
+{
+	vec3_t		start, end;
+	vec3_t		mins, maxs;
+	vec3_t		extents;
+	trace_t		trace;
+	int			contents;
+	qboolean	ispoint;		/* optimized case */
+	qboolean	compact;		/* use the compact layout */
+
+	int			caller;			/* tracecaller_t */
+	tracestats_t	*stats;		/* TRACE_NUMCALLERS of them */
+	tracestats_t	*curstats;
+
+	/* to avoid repeated testings */
+	int			checkcount;
+	int			brushchecks[MAX_MAP_BRUSHES];
+} tracecontext_t;
+
+void		CM_InitTraceContext (tracecontext_t *ctx, tracestats_t *stats);
+trace_t		CM_BoxTraceContext (tracecontext_t *ctx,
+                                vec3_t start, vec3_t end,
+                                vec3_t mins, vec3_t maxs,
+                                int headnode, int brushmask);
+trace_t		CM_TransformedBoxTraceContext (tracecontext_t *ctx,
+                                           vec3_t start, vec3_t end,
+                                           vec3_t mins, vec3_t maxs,
+                                           int headnode, int brushmask,
+                                           vec3_t origin, vec3_t angles);
+
 /* PLAYER MOVEMENT CODE */
 
 extern float pm_airaccelerate;
@@ -716,6 +813,9 @@ extern	int		time_after_game;
 extern	int		time_before_ref;
 extern	int		time_after_ref;
 
+/* timedemo benchmark times */
+extern	int		time_server_usec;
+
 void Z_Free (void *ptr);
 void *Z_Malloc (int size);			/* returns 0 filled memory */
 void *Z_TagMalloc (int size, int tag);
@@ -744,6 +844,17 @@ void	Sys_Quit (void);
 char	*Sys_GetClipboardData( void );
 void	Sys_CopyProtect (void);
 
+#define	MAX_THREADS	8
+
+qboolean	Sys_LogOpen (char *name, qboolean append, int buffersize);
+void	Sys_LogWrite (char *text, int flushtime);
+void	Sys_LogFlush (void);
+void	Sys_LogClose (void);
+
+int		Sys_NumThreads (void);
+void	Sys_ParallelFor (void (*func)(void *data, int index, int thread),
+                         void *data, int count);
+
 /* CLIENT / SERVER SYSTEMS */
 
 void CL_Init (void);
@@ -756,5 +867,8 @@ void SCR_BeginLoadingPlaque (void);
 void SV_Init (void);
 void SV_Shutdown (char *finalmsg, qboolean reconnect);
 void SV_Frame (int msec);
+void SV_JournalCommand (char *text);
+void SV_JournalCommands (void);
+qboolean SV_JournalReplaying (void);
 
 #endif
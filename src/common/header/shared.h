@@ -246,6 +246,7 @@ qboolean Info_Validate(char *s);
 extern int curtime; /* time returned by last Sys_Milliseconds */
 
 int Sys_Milliseconds(void);
+long long Sys_Microseconds(void); /* for profiling only */
 void Sys_Mkdir(char *path);
 void Sys_Rmdir(char *path);
 char *strlwr(char *s);
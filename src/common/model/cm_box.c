@@ -123,6 +123,8 @@ int	CM_HeadnodeForBox (vec3_t mins, vec3_t maxs)
 	box_planes[10].dist = mins[2];
 	box_planes[11].dist = -mins[2];
 
+	CM_UpdateCompactBox ();
+
 	return box_headnode;
 }
 
@@ -150,9 +152,7 @@ int CM_PointLeafnum_r (vec3_t p, int num)
 			num = node->children[0];
 	}
 
-#ifndef DEDICATED_ONLY
 	c_pointcontents++; /* optimize counter */
-#endif
 
 	return -1 - num;
 }
@@ -168,12 +168,15 @@ int CM_PointLeafnum (vec3_t p)
 /*
  * Fills in a list of all the leafs touched
  */
-int		leaf_count, leaf_maxcount;
-int		*leaf_list;
-float	*leaf_mins, *leaf_maxs;
-int		leaf_topnode;
+typedef struct
+{
+	int		count, maxcount;
+	int		*list;
+	float	*mins, *maxs;
+	int		topnode;
+} leafquery_t;
 
-void CM_BoxLeafnums_r (int nodenum)
+void CM_BoxLeafnums_r (leafquery_t *query, int nodenum)
 {
 	cplane_t	*plane;
 	cnode_t		*node;
@@ -183,18 +186,18 @@ void CM_BoxLeafnums_r (int nodenum)
 	{
 		if (nodenum < 0)
 		{
-			if (leaf_count >= leaf_maxcount)
+			if (query->count >= query->maxcount)
 			{
 				return;
 			}
 
-			leaf_list[leaf_count++] = -1 - nodenum;
+			query->list[query->count++] = -1 - nodenum;
 			return;
 		}
 
 		node = &map_nodes[nodenum];
 		plane = node->plane;
-		s = BOX_ON_PLANE_SIDE(leaf_mins, leaf_maxs, plane);
+		s = BOX_ON_PLANE_SIDE(query->mins, query->maxs, plane);
 
 		if (s == 1)
 			nodenum = node->children[0];
@@ -205,10 +208,10 @@ void CM_BoxLeafnums_r (int nodenum)
 		else
 		{
 			/* go down both */
-			if (leaf_topnode == -1)
-				leaf_topnode = nodenum;
+			if (query->topnode == -1)
+				query->topnode = nodenum;
 
-			CM_BoxLeafnums_r (node->children[0]);
+			CM_BoxLeafnums_r (query, node->children[0]);
 			nodenum = node->children[1];
 		}
 
@@ -217,20 +220,22 @@ void CM_BoxLeafnums_r (int nodenum)
 
 int CM_BoxLeafnums_headnode (vec3_t mins, vec3_t maxs, int *list, int listsize, int headnode, int *topnode)
 {
-	leaf_list = list;
-	leaf_count = 0;
-	leaf_maxcount = listsize;
-	leaf_mins = mins;
-	leaf_maxs = maxs;
+	leafquery_t	query;
+
+	query.list = list;
+	query.count = 0;
+	query.maxcount = listsize;
+	query.mins = mins;
+	query.maxs = maxs;
 
-	leaf_topnode = -1;
+	query.topnode = -1;
 
-	CM_BoxLeafnums_r (headnode);
+	CM_BoxLeafnums_r (&query, headnode);
 
 	if (topnode)
-		*topnode = leaf_topnode;
+		*topnode = query.topnode;
 
-	return leaf_count;
+	return query.count;
 }
 
 int CM_BoxLeafnums (vec3_t mins, vec3_t maxs, int *list, int listsize, int *topnode)
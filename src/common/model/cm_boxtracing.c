@@ -20,7 +20,9 @@
  * =======================================================================
  *
  * This file implements tracing of collision boxes through the world
- * model
+ * model. All state of a trace lives in a tracecontext_t, so traces
+ * with different contexts can run in parallel. CM_BoxTrace and
+ * CM_TransformedBoxTrace use a shared context and are not reentrant.
  *
  * =======================================================================
  */
@@ -33,16 +35,23 @@ extern int	box_headnode;
 /* 1/32 epsilon to keep floating point happy */
 #define	DIST_EPSILON	(0.03125f)
 
-vec3_t	trace_start, trace_end;
-vec3_t	trace_mins, trace_maxs;
-vec3_t	trace_extents;
+static tracecontext_t	cm_tracecontext; /* for the non reentrant API */
 
-trace_t	trace_trace;
-int		trace_contents;
-qboolean	trace_ispoint; /* optimized case */
+/* recording for the trace benchmark */
+static FILE		*cm_recording;
+static int		cm_recordleft;
+static int		cm_recorded;
 
-void CM_ClipBoxToBrush (vec3_t mins, vec3_t maxs, vec3_t p1, vec3_t p2,
-                        trace_t *trace, cbrush_t *brush)
+tracestats_t	trace_stats[TRACE_NUMCALLERS];
+int				trace_caller;
+
+static tracestats_t	trace_shown[TRACE_NUMCALLERS]; /* at the last showtrace */
+static const char	*trace_callernames[TRACE_NUMCALLERS] = {
+	"game", "pmove", "predict"
+};
+
+void CM_ClipBoxToBrush (tracecontext_t *ctx, vec3_t mins, vec3_t maxs,
+                        vec3_t p1, vec3_t p2, trace_t *trace, cbrush_t *brush)
 {
 	int			i, j;
 	cplane_t	*plane, *clipplane;
@@ -61,9 +70,7 @@ void CM_ClipBoxToBrush (vec3_t mins, vec3_t maxs, vec3_t p1, vec3_t p2,
 	if (!brush->numsides)
 		return;
 
-#ifndef DEDICATED_ONLY
-	c_brush_traces++;
-#endif
+	ctx->curstats->brushes++;
 
 	getout = false;
 	startout = false;
@@ -74,7 +81,7 @@ void CM_ClipBoxToBrush (vec3_t mins, vec3_t maxs, vec3_t p1, vec3_t p2,
 		side = &map_brushsides[brush->firstbrushside+i];
 		plane = side->plane;
 
-		if (!trace_ispoint)
+		if (!ctx->ispoint)
 		{
 			/* general box case
 			   push the plane out
@@ -164,8 +171,8 @@ void CM_ClipBoxToBrush (vec3_t mins, vec3_t maxs, vec3_t p1, vec3_t p2,
 	}
 }
 
-void CM_TestBoxInBrush (vec3_t mins, vec3_t maxs, vec3_t p1,
-                        trace_t *trace, cbrush_t *brush)
+void CM_TestBoxInBrush (tracecontext_t *ctx, vec3_t mins, vec3_t maxs,
+                        vec3_t p1, trace_t *trace, cbrush_t *brush)
 {
 	int			i, j;
 	cplane_t	*plane;
@@ -177,6 +184,8 @@ void CM_TestBoxInBrush (vec3_t mins, vec3_t maxs, vec3_t p1,
 	if (!brush->numsides)
 		return;
 
+	ctx->curstats->brushes++;
+
 	for (i=0 ; i<brush->numsides ; i++)
 	{
 		side = &map_brushsides[brush->firstbrushside+i];
@@ -211,7 +220,7 @@ void CM_TestBoxInBrush (vec3_t mins, vec3_t maxs, vec3_t p1,
 	trace->contents = brush->contents;
 }
 
-void CM_TraceToLeaf (int leafnum)
+void CM_TraceToLeaf (tracecontext_t *ctx, int leafnum)
 {
 	int			k;
 	int			brushnum;
@@ -220,7 +229,7 @@ void CM_TraceToLeaf (int leafnum)
 
 	leaf = &map_leafs[leafnum];
 
-	if ( !(leaf->contents & trace_contents))
+	if ( !(leaf->contents & ctx->contents))
 		return;
 
 	/* trace line against all brushes in the leaf */
@@ -229,23 +238,27 @@ void CM_TraceToLeaf (int leafnum)
 		brushnum = map_leafbrushes[leaf->firstleafbrush+k];
 		b = &map_brushes[brushnum];
 
-		if (b->checkcount == checkcount)
+		if (ctx->brushchecks[brushnum] == ctx->checkcount)
 			continue; /* already checked this brush in another leaf */
 
-		b->checkcount = checkcount;
+		ctx->brushchecks[brushnum] = ctx->checkcount;
 
-		if ( !(b->contents & trace_contents))
+		if ( !(b->contents & ctx->contents))
 			continue;
 
-		CM_ClipBoxToBrush (trace_mins, trace_maxs, trace_start, trace_end, &trace_trace, b);
+		if (ctx->compact)
+			CM_ClipBoxToBrushCompact (ctx, ctx->mins, ctx->maxs, ctx->start, ctx->end, &ctx->trace, brushnum);
 
-		if (!trace_trace.fraction)
+		else
+			CM_ClipBoxToBrush (ctx, ctx->mins, ctx->maxs, ctx->start, ctx->end, &ctx->trace, b);
+
+		if (!ctx->trace.fraction)
 			return;
 	}
 
 }
 
-void CM_TestInLeaf (int leafnum)
+void CM_TestInLeaf (tracecontext_t *ctx, int leafnum)
 {
 	int			k;
 	int			brushnum;
@@ -254,7 +267,7 @@ void CM_TestInLeaf (int leafnum)
 
 	leaf = &map_leafs[leafnum];
 
-	if ( !(leaf->contents & trace_contents))
+	if ( !(leaf->contents & ctx->contents))
 		return;
 
 	/* trace line against all brushes in the leaf */
@@ -263,26 +276,35 @@ void CM_TestInLeaf (int leafnum)
 		brushnum = map_leafbrushes[leaf->firstleafbrush+k];
 		b = &map_brushes[brushnum];
 
-		if (b->checkcount == checkcount)
+		if (ctx->brushchecks[brushnum] == ctx->checkcount)
 			continue; /* already checked this brush in another leaf */
 
-		b->checkcount = checkcount;
+		ctx->brushchecks[brushnum] = ctx->checkcount;
 
-		if ( !(b->contents & trace_contents))
+		if ( !(b->contents & ctx->contents))
 			continue;
 
-		CM_TestBoxInBrush (trace_mins, trace_maxs, trace_start, &trace_trace, b);
+		if (ctx->compact)
+			CM_TestBoxInBrushCompact (ctx, ctx->mins, ctx->maxs, ctx->start, &ctx->trace, brushnum);
+
+		else
+			CM_TestBoxInBrush (ctx, ctx->mins, ctx->maxs, ctx->start, &ctx->trace, b);
 
-		if (!trace_trace.fraction)
+		if (!ctx->trace.fraction)
 			return;
 	}
 
 }
 
-void CM_RecursiveHullCheck (int num, float p1f, float p2f, vec3_t p1, vec3_t p2)
+void CM_RecursiveHullCheck (tracecontext_t *ctx, int num, float p1f, float p2f,
+                            vec3_t p1, vec3_t p2)
 {
 	cnode_t		*node;
-	cplane_t	*plane;
+	ccnode_t	*cnode;
+	float		*normal;
+	float		dist;
+	int			type;
+	int			*children;
 	float		t1, t2, offset;
 	float		frac, frac2;
 	float		idist;
@@ -291,52 +313,69 @@ void CM_RecursiveHullCheck (int num, float p1f, float p2f, vec3_t p1, vec3_t p2)
 	int			side;
 	float		midf;
 
-	if (trace_trace.fraction <= p1f)
+	if (ctx->trace.fraction <= p1f)
 		return; /* already hit something nearer */
 
+	ctx->curstats->nodes++;
+
 	/* if < 0, we are in a leaf node */
 	if (num < 0)
 	{
-		CM_TraceToLeaf (-1-num);
+		CM_TraceToLeaf (ctx, -1-num);
 		return;
 	}
 
 	/* find the point distances to the seperating plane
 	   and the offset for the size of the box */
-	node = map_nodes + num;
-	plane = node->plane;
+	if (ctx->compact)
+	{
+		cnode = map_cnodes + num;
+		normal = cnode->normal;
+		dist = cnode->dist;
+		type = cnode->type;
+		children = cnode->children;
+	}
 
-	if (plane->type < 3)
+	else
 	{
-		t1 = p1[plane->type] - plane->dist;
-		t2 = p2[plane->type] - plane->dist;
-		offset = trace_extents[plane->type];
+		node = map_nodes + num;
+		normal = node->plane->normal;
+		dist = node->plane->dist;
+		type = node->plane->type;
+		children = node->children;
+	}
+
+	if (type < 3)
+	{
+		t1 = p1[type] - dist;
+		t2 = p2[type] - dist;
+		offset = ctx->extents[type];
 	}
 
 	else
 	{
-		t1 = DotProduct (plane->normal, p1) - plane->dist;
-		t2 = DotProduct (plane->normal, p2) - plane->dist;
+		t1 = DotProduct (normal, p1) - dist;
+		t2 = DotProduct (normal, p2) - dist;
 
-		if (trace_ispoint)
+		if (ctx->ispoint)
 			offset = 0;
 
 		else
-			offset = (float)fabs(trace_extents[0]*plane->normal[0]) +
-			         (float)fabs(trace_extents[1]*plane->normal[1]) +
-			         (float)fabs(trace_extents[2]*plane->normal[2]);
+			offset = (float)fabs(ctx->extents[0]*normal[0]) +
+			         (float)fabs(ctx->extents[1]*normal[1]) +
+			         (float)fabs(ctx->extents[2]*normal[2]);
 	}
 
 	/* see which sides we need to consider */
 	if (t1 >= offset && t2 >= offset)
 	{
-		CM_RecursiveHullCheck (node->children[0], p1f, p2f, p1, p2);
+		CM_RecursiveHullCheck (ctx, children[0], p1f, p2f, p1, p2);
 		return;
 	}
 
 	if (t1 < -offset && t2 < -offset)
 	{
-		CM_RecursiveHullCheck (node->children[1], p1f, p2f, p1, p2);
+		CM_RecursiveHullCheck (ctx, children[1], p1f, p2f, p1, p2);
 		return;
 	}
 
@@ -376,7 +415,7 @@ void CM_RecursiveHullCheck (int num, float p1f, float p2f, vec3_t p1, vec3_t p2)
 	for (i=0 ; i<3 ; i++)
 		mid[i] = p1[i] + frac*(p2[i] - p1[i]);
 
-	CM_RecursiveHullCheck (node->children[side], p1f, midf, p1, mid);
+	CM_RecursiveHullCheck (ctx, children[side], p1f, midf, p1, mid);
 
 
 	/* go past the node */
@@ -391,34 +430,107 @@ void CM_RecursiveHullCheck (int num, float p1f, float p2f, vec3_t p1, vec3_t p2)
 	for (i=0 ; i<3 ; i++)
 		mid[i] = p1[i] + frac2*(p2[i] - p1[i]);
 
-	CM_RecursiveHullCheck (node->children[side^1], midf, p2f, mid, p2);
+	CM_RecursiveHullCheck (ctx, children[side^1], midf, p2f, mid, p2);
 }
 
-trace_t		CM_BoxTrace (vec3_t start, vec3_t end,
-                         vec3_t mins, vec3_t maxs,
-                         int headnode, int brushmask)
+/*
+ * Writes a box trace done through the
+ * non reentrant API to the recording.
+ */
+static void CM_RecordTrace (vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs,
+                            int headnode, int brushmask)
+{
+	recordedtrace_t	rt;
+	int				i;
+
+	/* the box hull changes all the time */
+	if (headnode == box_headnode)
+		return;
+
+	for (i = 0; i < 3; i++)
+	{
+		rt.start[i] = LittleFloat (start[i]);
+		rt.end[i] = LittleFloat (end[i]);
+		rt.mins[i] = LittleFloat (mins[i]);
+		rt.maxs[i] = LittleFloat (maxs[i]);
+	}
+
+	rt.headnode = LittleLong (headnode);
+	rt.brushmask = LittleLong (brushmask);
+
+	fwrite (&rt, sizeof(rt), 1, cm_recording);
+	cm_recorded++;
+
+	if (--cm_recordleft <= 0)
+	{
+		fclose (cm_recording);
+		cm_recording = NULL;
+		Com_Printf ("Recorded %i traces.\n", cm_recorded);
+	}
+}
+
+/*
+ * Sorts the cost of a finished box
+ * trace into the histogram.
+ */
+static void CM_CountTraceCost (tracestats_t *stats, int cost)
+{
+	int		bucket;
+
+	for (bucket = 0; cost > 1 && bucket < TRACE_NUMBUCKETS - 1; bucket++)
+		cost >>= 1;
+
+	stats->cost[bucket]++;
+}
+
+/*
+ * Prepares a context for tracing. stats
+ * points to TRACE_NUMCALLERS counters,
+ * contexts that never trace at the same
+ * time may share them.
+ */
+void CM_InitTraceContext (tracecontext_t *ctx, tracestats_t *stats)
+{
+	memset (ctx, 0, sizeof(*ctx));
+
+	ctx->stats = stats;
+	ctx->curstats = stats;
+}
+
+trace_t		CM_BoxTraceContext (tracecontext_t *ctx,
+                                vec3_t start, vec3_t end,
+                                vec3_t mins, vec3_t maxs,
+                                int headnode, int brushmask)
 {
 	int		i;
+	tracestats_t	*stats;
+	int		cost;
 
-	checkcount++; /* for multi-check avoidance */
+	ctx->checkcount++; /* for multi-check avoidance */
 
-#ifndef DEDICATED_ONLY
-	c_traces++; /* for statistics, may be zeroed */
-#endif
+	/* for statistics */
+	stats = ctx->curstats = &ctx->stats[ctx->caller];
+	stats->boxtraces++;
+	cost = stats->nodes + stats->brushes;
 
 	/* fill in a default trace */
-	memset (&trace_trace, 0, sizeof(trace_trace));
-	trace_trace.fraction = 1;
-	trace_trace.surface = &(nullsurface.c);
+	memset (&ctx->trace, 0, sizeof(ctx->trace));
+	ctx->trace.fraction = 1;
+	ctx->trace.surface = &(nullsurface.c);
 
 	if (!numnodes)	/* map not loaded */
-		return trace_trace;
+		return ctx->trace;
 
-	trace_contents = brushmask;
-	VectorCopy (start, trace_start);
-	VectorCopy (end, trace_end);
-	VectorCopy (mins, trace_mins);
-	VectorCopy (maxs, trace_maxs);
+	ctx->compact = (cm_compact->value != 0);
+
+	if (cm_recording && ctx == &cm_tracecontext)
+		CM_RecordTrace (start, end, mins, maxs, headnode, brushmask);
+
+	ctx->contents = brushmask;
+	VectorCopy (start, ctx->start);
+	VectorCopy (end, ctx->end);
+	VectorCopy (mins, ctx->mins);
+	VectorCopy (maxs, ctx->maxs);
 
 	/* check for position test special case */
 	if (start[0] == end[0] && start[1] == end[1] && start[2] == end[2])
@@ -441,57 +553,60 @@ trace_t		CM_BoxTrace (vec3_t start, vec3_t end,
 
 		for (i=0 ; i<numleafs ; i++)
 		{
-			CM_TestInLeaf (leafs[i]);
+			CM_TestInLeaf (ctx, leafs[i]);
 
-			if (trace_trace.allsolid)
+			if (ctx->trace.allsolid)
 				break;
 		}
 
-		VectorCopy (start, trace_trace.endpos);
-		return trace_trace;
+		VectorCopy (start, ctx->trace.endpos);
+		CM_CountTraceCost (stats, stats->nodes + stats->brushes - cost);
+		return ctx->trace;
 	}
 
 	/* check for point special case */
 	if (mins[0] == 0 && mins[1] == 0 && mins[2] == 0
 	        && maxs[0] == 0 && maxs[1] == 0 && maxs[2] == 0)
 	{
-		trace_ispoint = true;
-		VectorClear (trace_extents);
+		ctx->ispoint = true;
+		VectorClear (ctx->extents);
 	}
 
 	else
 	{
-		trace_ispoint = false;
-		trace_extents[0] = -mins[0] > maxs[0] ? -mins[0] : maxs[0];
-		trace_extents[1] = -mins[1] > maxs[1] ? -mins[1] : maxs[1];
-		trace_extents[2] = -mins[2] > maxs[2] ? -mins[2] : maxs[2];
+		ctx->ispoint = false;
+		ctx->extents[0] = -mins[0] > maxs[0] ? -mins[0] : maxs[0];
+		ctx->extents[1] = -mins[1] > maxs[1] ? -mins[1] : maxs[1];
+		ctx->extents[2] = -mins[2] > maxs[2] ? -mins[2] : maxs[2];
 	}
 
 	/* general sweeping through world */
-	CM_RecursiveHullCheck (headnode, 0, 1, start, end);
+	CM_RecursiveHullCheck (ctx, headnode, 0, 1, start, end);
 
-	if (trace_trace.fraction == 1)
+	if (ctx->trace.fraction == 1)
 	{
-		VectorCopy (end, trace_trace.endpos);
+		VectorCopy (end, ctx->trace.endpos);
 	}
 
 	else
 	{
 		for (i=0 ; i<3 ; i++)
-			trace_trace.endpos[i] = start[i] + trace_trace.fraction * (end[i] - start[i]);
+			ctx->trace.endpos[i] = start[i] + ctx->trace.fraction * (end[i] - start[i]);
 	}
 
-	return trace_trace;
+	CM_CountTraceCost (stats, stats->nodes + stats->brushes - cost);
+	return ctx->trace;
 }
 
 /*
  * Handles offseting and rotation of the end points for moving and
  * rotating entities
  */
-trace_t CM_TransformedBoxTrace (vec3_t start, vec3_t end,
-                                    vec3_t mins, vec3_t maxs,
-                                    int headnode, int brushmask,
-                                    vec3_t origin, vec3_t angles)
+trace_t CM_TransformedBoxTraceContext (tracecontext_t *ctx,
+                                       vec3_t start, vec3_t end,
+                                       vec3_t mins, vec3_t maxs,
+                                       int headnode, int brushmask,
+                                       vec3_t origin, vec3_t angles)
 {
 	trace_t		trace;
 	vec3_t		start_l, end_l;
@@ -528,7 +643,7 @@ trace_t CM_TransformedBoxTrace (vec3_t start, vec3_t end,
 	}
 
 	/* sweep the box through the model */
-	trace = CM_BoxTrace (start_l, end_l, mins, maxs, headnode, brushmask);
+	trace = CM_BoxTraceContext (ctx, start_l, end_l, mins, maxs, headnode, brushmask);
 
 	if (rotated && trace.fraction != 1.0)
 	{
@@ -547,3 +662,362 @@ trace_t CM_TransformedBoxTrace (vec3_t start, vec3_t end,
 
 	return trace;
 }
+
+/*
+ * The traditional API, traces
+ * with a shared context
+ */
+trace_t		CM_BoxTrace (vec3_t start, vec3_t end,
+                         vec3_t mins, vec3_t maxs,
+                         int headnode, int brushmask)
+{
+	cm_tracecontext.stats = trace_stats;
+	cm_tracecontext.caller = trace_caller;
+
+	return CM_BoxTraceContext (&cm_tracecontext, start, end, mins, maxs,
+	                           headnode, brushmask);
+}
+
+trace_t CM_TransformedBoxTrace (vec3_t start, vec3_t end,
+                                    vec3_t mins, vec3_t maxs,
+                                    int headnode, int brushmask,
+                                    vec3_t origin, vec3_t angles)
+{
+	cm_tracecontext.stats = trace_stats;
+	cm_tracecontext.caller = trace_caller;
+
+	return CM_TransformedBoxTraceContext (&cm_tracecontext, start, end,
+	                                      mins, maxs, headnode, brushmask,
+	                                      origin, angles);
+}
+
+/*
+ * Adds TRACE_NUMCALLERS counters collected
+ * in a private context to the global ones
+ * and clears them.
+ */
+void CM_MergeTraceStats (tracestats_t *stats)
+{
+	int		i, j;
+
+	for (i = 0; i < TRACE_NUMCALLERS; i++)
+	{
+		trace_stats[i].traces += stats[i].traces;
+		trace_stats[i].boxtraces += stats[i].boxtraces;
+		trace_stats[i].nodes += stats[i].nodes;
+		trace_stats[i].brushes += stats[i].brushes;
+		trace_stats[i].entities += stats[i].entities;
+
+		for (j = 0; j < TRACE_NUMBUCKETS; j++)
+			trace_stats[i].cost[j] += stats[i].cost[j];
+	}
+
+	memset (stats, 0, TRACE_NUMCALLERS * sizeof(tracestats_t));
+}
+
+/*
+ * Prints the traces since the last call,
+ * called each frame while "showtrace" is set.
+ */
+void CM_ShowTrace (void)
+{
+	tracestats_t	*now, *last;
+	int				i;
+
+	Com_Printf ("%4i points", c_pointcontents);
+	c_pointcontents = 0;
+
+	for (i = 0; i < TRACE_NUMCALLERS; i++)
+	{
+		now = &trace_stats[i];
+		last = &trace_shown[i];
+
+		Com_Printf ("  %s %i/%i/%i/%i/%i", trace_callernames[i],
+		            now->traces - last->traces,
+		            now->boxtraces - last->boxtraces,
+		            now->nodes - last->nodes,
+		            now->brushes - last->brushes,
+		            now->entities - last->entities);
+
+		*last = *now;
+	}
+
+	Com_Printf ("\n");
+}
+
+/*
+ * Prints the traces since the last reset and
+ * a histogram of the box trace cost.
+ */
+void CM_TraceStats_f (void)
+{
+	tracestats_t	*stats;
+	int				i, j;
+
+	if (Cmd_Argc () > 1 && !Q_stricmp (Cmd_Argv (1), "reset"))
+	{
+		memset (trace_stats, 0, sizeof(trace_stats));
+		memset (trace_shown, 0, sizeof(trace_shown));
+		return;
+	}
+
+	Com_Printf ("%-8s %9s %9s %10s %10s %9s\n", "", "traces", "box",
+	            "nodes", "brushes", "entities");
+
+	for (i = 0; i < TRACE_NUMCALLERS; i++)
+	{
+		stats = &trace_stats[i];
+
+		Com_Printf ("%-8s %9i %9i %10i %10i %9i\n", trace_callernames[i],
+		            stats->traces, stats->boxtraces, stats->nodes,
+		            stats->brushes, stats->entities);
+	}
+
+	Com_Printf ("Nodes and brushes per box trace:\n");
+	Com_Printf ("%-8s", "");
+
+	for (i = 0; i < TRACE_NUMCALLERS; i++)
+		Com_Printf (" %9s", trace_callernames[i]);
+
+	Com_Printf ("\n");
+
+	for (j = 0; j < TRACE_NUMBUCKETS; j++)
+	{
+		if (j < TRACE_NUMBUCKETS - 1)
+			Com_Printf ("  < %-4i", 2 << j);
+		else
+			Com_Printf (" >= %-4i", 1 << j);
+
+		for (i = 0; i < TRACE_NUMCALLERS; i++)
+			Com_Printf (" %9i", trace_stats[i].cost[j]);
+
+		Com_Printf ("\n");
+	}
+}
+
+/*
+ * Records the next box traces against the map
+ * into a file for "tracebench".
+ * tracerecord <file> [count] or tracerecord stop
+ */
+void CM_TraceRecord_f (void)
+{
+	char	name[MAX_OSPATH];
+	int		header[2];
+
+	if (Cmd_Argc () < 2)
+	{
+		Com_Printf ("Usage: tracerecord <file> [count] or tracerecord stop\n");
+		return;
+	}
+
+	if (cm_recording)
+	{
+		fclose (cm_recording);
+		cm_recording = NULL;
+		Com_Printf ("Recorded %i traces.\n", cm_recorded);
+	}
+
+	if (!Q_stricmp (Cmd_Argv (1), "stop"))
+		return;
+
+	if (!numnodes || !map_name[0])
+	{
+		Com_Printf ("No map loaded.\n");
+		return;
+	}
+
+	Com_sprintf (name, sizeof(name), "%s/%s", FS_Gamedir (), Cmd_Argv (1));
+	FS_CreatePath (name);
+
+	cm_recording = fopen (name, "wb");
+
+	if (!cm_recording)
+	{
+		Com_Printf ("Couldn't write %s.\n", name);
+		return;
+	}
+
+	header[0] = LittleLong (TRACERECORD_IDENT);
+	header[1] = LittleLong (TRACERECORD_VERSION);
+	fwrite (header, sizeof(header), 1, cm_recording);
+	fwrite (map_name, sizeof(map_name), 1, cm_recording);
+
+	cm_recordleft = Cmd_Argc () > 2 ? atoi (Cmd_Argv (2)) : 10000;
+	cm_recorded = 0;
+
+	Com_Printf ("Recording traces to %s.\n", name);
+}
+
+/*
+ * Replays all traces of the recording with the given
+ * layout. Returns the time taken in microseconds.
+ */
+static long long CM_TraceBenchPass (tracecontext_t *ctx, recordedtrace_t *rt,
+                                    int count, trace_t *results, int compact)
+{
+	long long	start;
+	int			i;
+
+	Cvar_SetValue ("cm_compact", compact);
+
+	start = Sys_Microseconds ();
+
+	for (i = 0; i < count; i++, rt++)
+		results[i] = CM_BoxTraceContext (ctx, rt->start, rt->end, rt->mins,
+		                                 rt->maxs, rt->headnode, rt->brushmask);
+
+	return Sys_Microseconds () - start;
+}
+
+static qboolean CM_SameTrace (trace_t *a, trace_t *b)
+{
+	return a->fraction == b->fraction && VectorCompare (a->endpos, b->endpos)
+	       && VectorCompare (a->plane.normal, b->plane.normal)
+	       && a->plane.dist == b->plane.dist && a->contents == b->contents
+	       && a->surface == b->surface && a->startsolid == b->startsolid
+	       && a->allsolid == b->allsolid;
+}
+
+/*
+ * Replays a recording with the normal and the
+ * compact layout, compares speed and results.
+ * tracebench <file> [passes]
+ */
+void CM_TraceBench_f (void)
+{
+	char			name[MAX_OSPATH];
+	char			mapname[MAX_QPATH];
+	char			compact[16];
+	int				header[2];
+	FILE			*f;
+	recordedtrace_t	*rt;
+	trace_t			*results[2];
+	tracecontext_t	*ctx;
+	tracestats_t	stats[TRACE_NUMCALLERS];
+	long long		usec[2];
+	int				count, maxcount;
+	int				passes;
+	int				i, j, differ;
+
+	if (Cmd_Argc () < 2)
+	{
+		Com_Printf ("Usage: tracebench <file> [passes]\n");
+		return;
+	}
+
+	Com_sprintf (name, sizeof(name), "%s/%s", FS_Gamedir (), Cmd_Argv (1));
+
+	f = fopen (name, "rb");
+
+	if (!f)
+	{
+		Com_Printf ("Couldn't open %s.\n", name);
+		return;
+	}
+
+	if (fread (header, sizeof(header), 1, f) != 1
+	        || LittleLong (header[0]) != TRACERECORD_IDENT
+	        || LittleLong (header[1]) != TRACERECORD_VERSION
+	        || fread (mapname, sizeof(mapname), 1, f) != 1)
+	{
+		Com_Printf ("%s is not a trace recording.\n", name);
+		fclose (f);
+		return;
+	}
+
+	mapname[sizeof(mapname)-1] = 0;
+
+	if (strcmp (mapname, map_name))
+	{
+		Com_Printf ("%s was recorded on %s, load that map first.\n", name, mapname);
+		fclose (f);
+		return;
+	}
+
+	/* read all traces */
+	rt = NULL;
+	count = maxcount = 0;
+
+	while (1)
+	{
+		if (count == maxcount)
+		{
+			recordedtrace_t	*grown;
+
+			maxcount = maxcount ? maxcount * 2 : 4096;
+			grown = Z_Malloc (maxcount * sizeof(recordedtrace_t));
+
+			if (rt)
+			{
+				memcpy (grown, rt, count * sizeof(recordedtrace_t));
+				Z_Free (rt);
+			}
+
+			rt = grown;
+		}
+
+		if (fread (&rt[count], sizeof(recordedtrace_t), 1, f) != 1)
+			break;
+
+		for (i = 0; i < 3; i++)
+		{
+			rt[count].start[i] = LittleFloat (rt[count].start[i]);
+			rt[count].end[i] = LittleFloat (rt[count].end[i]);
+			rt[count].mins[i] = LittleFloat (rt[count].mins[i]);
+			rt[count].maxs[i] = LittleFloat (rt[count].maxs[i]);
+		}
+
+		rt[count].headnode = LittleLong (rt[count].headnode);
+		rt[count].brushmask = LittleLong (rt[count].brushmask);
+
+		if (rt[count].headnode < 0 || rt[count].headnode >= numnodes)
+			continue;
+
+		count++;
+	}
+
+	fclose (f);
+
+	if (!count)
+	{
+		Com_Printf ("No traces in %s.\n", name);
+		Z_Free (rt);
+		return;
+	}
+
+	passes = Cmd_Argc () > 2 ? atoi (Cmd_Argv (2)) : 10;
+
+	if (passes < 1)
+		passes = 1;
+
+	ctx = Z_Malloc (sizeof(tracecontext_t));
+	CM_InitTraceContext (ctx, stats);
+	results[0] = Z_Malloc (count * sizeof(trace_t));
+	results[1] = Z_Malloc (count * sizeof(trace_t));
+
+	Com_sprintf (compact, sizeof(compact), "%s", cm_compact->string);
+	usec[0] = usec[1] = 0;
+
+	/* alternate to be fair to the caches */
+	for (i = 0; i < passes; i++)
+		for (j = 0; j < 2; j++)
+			usec[j] += CM_TraceBenchPass (ctx, rt, count, results[j], j);
+
+	Cvar_Set ("cm_compact", compact);
+
+	for (i = 0, differ = 0; i < count; i++)
+		if (!CM_SameTrace (&results[0][i], &results[1][i]))
+			differ++;
+
+	Com_Printf ("%i traces on %s, %i passes:\n", count, map_name, passes);
+	Com_Printf ("normal  %8.3f usec per trace\n", usec[0] / (double)(count * passes));
+	Com_Printf ("compact %8.3f usec per trace, %.2fx\n", usec[1] / (double)(count * passes),
+	            usec[1] ? usec[0] / (double)usec[1] : 0.0);
+	Com_Printf ("%i results differ.\n", differ);
+
+	Z_Free (results[0]);
+	Z_Free (results[1]);
+	Z_Free (ctx);
+	Z_Free (rt);
+}
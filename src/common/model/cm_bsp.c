@@ -485,6 +485,7 @@ cmodel_t *CM_LoadMap (char *name, qboolean clientload, unsigned *checksum)
 	FS_FreeFile (buf);
 
 	CM_InitBoxHull ();
+	CM_BuildCompact ();
 
 	memset (portalopen, 0, sizeof(portalopen));
 	FloodAreaConnections ();
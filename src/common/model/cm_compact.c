@@ -0,0 +1,388 @@
+/*
+ * Copyright (C) 1997-2001 Id Software, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * =======================================================================
+ *
+ * The compact collision layout. It's built from the normal map data
+ * after a map was loaded. Nodes carry their plane inline, the planes
+ * of the brush sides are stored as one array per component and each
+ * brush starts at a multiple of 4. That way the brush clipping can
+ * test 4 sides at once with SSE2 or NEON. The results are the same
+ * as with the normal layout, "cm_compact 0" switches back to it.
+ *
+ * =======================================================================
+ */
+
+#include "../header/common.h"
+#include "../header/cmodel.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CM_NEON
+#endif
+
+extern int		box_headnode;
+
+/* each brush may waste up to 3 sides for padding */
+#define MAX_COMPACT_SIDES (MAX_MAP_BRUSHSIDES + 3 * MAX_MAP_BRUSHES + 4)
+
+/* padding sides are far behind everything */
+#define PAD_DIST	1e30f
+
+/* 1/32 epsilon to keep floating point happy */
+#define	DIST_EPSILON	(0.03125f)
+
+ccnode_t	map_cnodes[MAX_MAP_NODES+6];
+cvar_t		*cm_compact;
+
+static float	cside_normal[3][MAX_COMPACT_SIDES];
+static float	cside_dist[MAX_COMPACT_SIDES];
+static int		cbrush_firstside[MAX_MAP_BRUSHES];
+
+static void CM_CompactNode (int num)
+{
+	ccnode_t	*out;
+	cnode_t		*in;
+
+	in = &map_nodes[num];
+	out = &map_cnodes[num];
+
+	VectorCopy (in->plane->normal, out->normal);
+	out->dist = in->plane->dist;
+	out->type = in->plane->type;
+	out->children[0] = in->children[0];
+	out->children[1] = in->children[1];
+	out->pad = 0;
+}
+
+static void CM_CompactBrush (int num, int first)
+{
+	cbrush_t	*brush;
+	cplane_t	*plane;
+	int			i;
+
+	brush = &map_brushes[num];
+	cbrush_firstside[num] = first;
+
+	for (i = 0; i < brush->numsides; i++)
+	{
+		plane = map_brushsides[brush->firstbrushside + i].plane;
+
+		cside_normal[0][first + i] = plane->normal[0];
+		cside_normal[1][first + i] = plane->normal[1];
+		cside_normal[2][first + i] = plane->normal[2];
+		cside_dist[first + i] = plane->dist;
+	}
+
+	for ( ; i & 3; i++)
+	{
+		cside_normal[0][first + i] = 0;
+		cside_normal[1][first + i] = 0;
+		cside_normal[2][first + i] = 0;
+		cside_dist[first + i] = PAD_DIST;
+	}
+}
+
+/*
+ * Called by CM_LoadMap after the box
+ * hull was set up, it's included.
+ */
+void CM_BuildCompact (void)
+{
+	int		i;
+	int		first;
+
+	cm_compact = Cvar_Get ("cm_compact", "1", 0);
+
+	for (i = 0; i < numnodes + 6; i++)
+		CM_CompactNode (i);
+
+	for (i = 0, first = 0; i < numbrushes + 1; i++)
+	{
+		CM_CompactBrush (i, first);
+		first += (map_brushes[i].numsides + 3) & ~3;
+	}
+}
+
+/*
+ * The box hull planes change with every
+ * CM_HeadnodeForBox, copy them over.
+ */
+void CM_UpdateCompactBox (void)
+{
+	int		i;
+
+	if (!cm_compact)
+		return; /* no map loaded yet */
+
+	for (i = 0; i < 6; i++)
+		CM_CompactNode (box_headnode + i);
+
+	CM_CompactBrush (numbrushes, cbrush_firstside[numbrushes]);
+}
+
+/*
+ * Distances of p1 and p2 to the 4 sides starting
+ * at side, with the planes pushed out for the box.
+ * Calculated in the same order as DotProduct, so
+ * the results match the scalar code bit by bit.
+ */
+static void CM_SideDistances4 (int side, vec3_t mins, vec3_t maxs,
+                               qboolean ispoint, vec3_t p1, vec3_t p2,
+                               float *d1, float *d2)
+{
+#if defined(__SSE2__)
+	__m128	nx, ny, nz, dist;
+	__m128	neg, ox, oy, oz;
+	__m128	zero;
+
+	nx = _mm_loadu_ps (&cside_normal[0][side]);
+	ny = _mm_loadu_ps (&cside_normal[1][side]);
+	nz = _mm_loadu_ps (&cside_normal[2][side]);
+	dist = _mm_loadu_ps (&cside_dist[side]);
+
+	if (!ispoint)
+	{
+		zero = _mm_setzero_ps ();
+
+		neg = _mm_cmplt_ps (nx, zero);
+		ox = _mm_or_ps (_mm_and_ps (neg, _mm_set1_ps (maxs[0])),
+		                _mm_andnot_ps (neg, _mm_set1_ps (mins[0])));
+		neg = _mm_cmplt_ps (ny, zero);
+		oy = _mm_or_ps (_mm_and_ps (neg, _mm_set1_ps (maxs[1])),
+		                _mm_andnot_ps (neg, _mm_set1_ps (mins[1])));
+		neg = _mm_cmplt_ps (nz, zero);
+		oz = _mm_or_ps (_mm_and_ps (neg, _mm_set1_ps (maxs[2])),
+		                _mm_andnot_ps (neg, _mm_set1_ps (mins[2])));
+
+		dist = _mm_sub_ps (dist, _mm_add_ps (_mm_add_ps (_mm_mul_ps (ox, nx),
+		                                                 _mm_mul_ps (oy, ny)), _mm_mul_ps (oz, nz)));
+	}
+
+	_mm_storeu_ps (d1, _mm_sub_ps (_mm_add_ps (_mm_add_ps (
+	                   _mm_mul_ps (_mm_set1_ps (p1[0]), nx),
+	                   _mm_mul_ps (_mm_set1_ps (p1[1]), ny)),
+	                   _mm_mul_ps (_mm_set1_ps (p1[2]), nz)), dist));
+	_mm_storeu_ps (d2, _mm_sub_ps (_mm_add_ps (_mm_add_ps (
+	                   _mm_mul_ps (_mm_set1_ps (p2[0]), nx),
+	                   _mm_mul_ps (_mm_set1_ps (p2[1]), ny)),
+	                   _mm_mul_ps (_mm_set1_ps (p2[2]), nz)), dist));
+#elif defined(CM_NEON)
+	float32x4_t	nx, ny, nz, dist;
+	float32x4_t	ox, oy, oz;
+	float32x4_t	zero;
+
+	nx = vld1q_f32 (&cside_normal[0][side]);
+	ny = vld1q_f32 (&cside_normal[1][side]);
+	nz = vld1q_f32 (&cside_normal[2][side]);
+	dist = vld1q_f32 (&cside_dist[side]);
+
+	if (!ispoint)
+	{
+		zero = vdupq_n_f32 (0);
+
+		ox = vbslq_f32 (vcltq_f32 (nx, zero), vdupq_n_f32 (maxs[0]), vdupq_n_f32 (mins[0]));
+		oy = vbslq_f32 (vcltq_f32 (ny, zero), vdupq_n_f32 (maxs[1]), vdupq_n_f32 (mins[1]));
+		oz = vbslq_f32 (vcltq_f32 (nz, zero), vdupq_n_f32 (maxs[2]), vdupq_n_f32 (mins[2]));
+
+		dist = vsubq_f32 (dist, vaddq_f32 (vaddq_f32 (vmulq_f32 (ox, nx),
+		                                              vmulq_f32 (oy, ny)), vmulq_f32 (oz, nz)));
+	}
+
+	vst1q_f32 (d1, vsubq_f32 (vaddq_f32 (vaddq_f32 (
+	               vmulq_n_f32 (nx, p1[0]), vmulq_n_f32 (ny, p1[1])),
+	               vmulq_n_f32 (nz, p1[2])), dist));
+	vst1q_f32 (d2, vsubq_f32 (vaddq_f32 (vaddq_f32 (
+	               vmulq_n_f32 (nx, p2[0]), vmulq_n_f32 (ny, p2[1])),
+	               vmulq_n_f32 (nz, p2[2])), dist));
+#else
+	int		i, j;
+	vec3_t	normal, ofs;
+	float	dist;
+
+	for (i = 0; i < 4; i++)
+	{
+		for (j = 0; j < 3; j++)
+			normal[j] = cside_normal[j][side + i];
+
+		dist = cside_dist[side + i];
+
+		if (!ispoint)
+		{
+			for (j = 0; j < 3; j++)
+			{
+				if (normal[j] < 0)
+					ofs[j] = maxs[j];
+
+				else
+					ofs[j] = mins[j];
+			}
+
+			dist = dist - DotProduct (ofs, normal);
+		}
+
+		d1[i] = DotProduct (p1, normal) - dist;
+		d2[i] = DotProduct (p2, normal) - dist;
+	}
+#endif
+}
+
+/*
+ * CM_ClipBoxToBrush on the compact layout
+ */
+void CM_ClipBoxToBrushCompact (tracecontext_t *ctx, vec3_t mins, vec3_t maxs,
+                               vec3_t p1, vec3_t p2, trace_t *trace, int brushnum)
+{
+	int			i, j, n;
+	int			first;
+	float		enterfrac, leavefrac;
+	float		d1[4], d2[4];
+	qboolean	getout, startout;
+	float		f;
+	cbrush_t	*brush;
+	int			leadside;
+
+	brush = &map_brushes[brushnum];
+
+	if (!brush->numsides)
+		return;
+
+	ctx->curstats->brushes++;
+
+	enterfrac = -1;
+	leavefrac = 1;
+	leadside = -1;
+	getout = false;
+	startout = false;
+	first = cbrush_firstside[brushnum];
+
+	for (i = 0; i < brush->numsides; i += 4)
+	{
+		CM_SideDistances4 (first + i, mins, maxs, ctx->ispoint, p1, p2, d1, d2);
+
+		n = brush->numsides - i;
+
+		if (n > 4)
+			n = 4;
+
+		for (j = 0; j < n; j++)
+		{
+			if (d2[j] > 0)
+				getout = true; /* endpoint is not in solid */
+
+			if (d1[j] > 0)
+				startout = true;
+
+			/* if completely in front of face, no intersection */
+			if (d1[j] > 0 && d2[j] >= d1[j])
+				return;
+
+			if (d1[j] <= 0 && d2[j] <= 0)
+				continue;
+
+			/* crosses face */
+			if (d1[j] > d2[j])
+			{
+				/* enter */
+				f = (d1[j]-DIST_EPSILON) / (d1[j]-d2[j]);
+
+				if (f > enterfrac)
+				{
+					enterfrac = f;
+					leadside = brush->firstbrushside + i + j;
+				}
+			}
+
+			else
+			{
+				/* leave */
+				f = (d1[j]+DIST_EPSILON) / (d1[j]-d2[j]);
+
+				if (f < leavefrac)
+					leavefrac = f;
+			}
+		}
+	}
+
+	if (!startout)
+	{
+		/* original point was inside brush */
+		trace->startsolid = true;
+
+		if (!getout)
+			trace->allsolid = true;
+
+		return;
+	}
+
+	if (enterfrac < leavefrac)
+	{
+		if (enterfrac > -1 && enterfrac < trace->fraction)
+		{
+			if (enterfrac < 0)
+				enterfrac = 0;
+
+			trace->fraction = enterfrac;
+			trace->plane = *map_brushsides[leadside].plane;
+			trace->surface = &(map_brushsides[leadside].surface->c);
+			trace->contents = brush->contents;
+		}
+	}
+}
+
+/*
+ * CM_TestBoxInBrush on the compact layout
+ */
+void CM_TestBoxInBrushCompact (tracecontext_t *ctx, vec3_t mins, vec3_t maxs,
+                               vec3_t p1, trace_t *trace, int brushnum)
+{
+	int			i, j;
+	int			first;
+	float		d1[4], d2[4];
+	cbrush_t	*brush;
+
+	brush = &map_brushes[brushnum];
+
+	if (!brush->numsides)
+		return;
+
+	ctx->curstats->brushes++;
+
+	first = cbrush_firstside[brushnum];
+
+	for (i = 0; i < brush->numsides; i += 4)
+	{
+		CM_SideDistances4 (first + i, mins, maxs, false, p1, p1, d1, d2);
+
+		/* padding sides never are in front */
+		for (j = 0; j < 4; j++)
+		{
+			/* if completely in front of face, no intersection */
+			if (d1[j] > 0)
+				return;
+		}
+	}
+
+	/* inside this brush */
+	trace->startsolid = trace->allsolid = true;
+	trace->fraction = 0;
+	trace->contents = brush->contents;
+}
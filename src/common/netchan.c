@@ -79,15 +79,38 @@
  * frame, such as during the connection stage while waiting for the
  * client to load, then a packet only needs to be delivered if there is
  * something in the unacknowledged reliable
+ *
+ * If both sides agreed on it at connect, a message up to MAX_BIGMSGLEN
+ * is sent as fragments that all carry the same sequence number, with
+ * the fragment bit set and the offset and length of the fragment after
+ * the header. A fragment shorter than FRAGMENT_SIZE is the last one.
+ * If a fragment is lost, the whole message is lost like a dropped
+ * packet, a reliable part is retransmitted as usual.
  */
 
+#define	FRAGMENT_BIT	(1<<30)
+#define	FRAGMENT_SIZE	(MAX_MSGLEN - PACKET_HEADER - 4)
+
 cvar_t		*showpackets;
 cvar_t		*showdrop;
 cvar_t		*qport;
+cvar_t		*net_fakeloss;
 
 netadr_t	net_from;
 sizebuf_t	net_message;
-byte		net_message_buffer[MAX_MSGLEN];
+byte		net_message_buffer[MAX_BIGMSGLEN];
+
+int			net_fragments_sent;
+int			net_fragments_received;
+int			net_fragments_dropped;
+
+static void Netchan_FragStats_f (void)
+{
+	Com_Printf ("fragments: %i sent, %i received, %i dropped\n"
+	            , net_fragments_sent
+	            , net_fragments_received
+	            , net_fragments_dropped);
+}
 
 void Netchan_Init (void)
 {
@@ -99,6 +122,127 @@ void Netchan_Init (void)
 	showpackets = Cvar_Get ("showpackets", "0", 0);
 	showdrop = Cvar_Get ("showdrop", "0", 0);
 	qport = Cvar_Get ("qport", va("%i", port), CVAR_NOSET);
+	net_fakeloss = Cvar_Get ("net_fakeloss", "0", 0);
+
+	Cmd_AddCommand ("fragstats", Netchan_FragStats_f);
+}
+
+/*
+ * Sends a datagram of a channel. net_fakeloss
+ * drops that percentage of them, to see how the
+ * game and the fragments cope with packet loss.
+ */
+static void Netchan_SendPacket (netchan_t *chan, int length, byte *data)
+{
+	if (net_fakeloss->value > 0 && (rand() % 100) < net_fakeloss->value)
+		return;
+
+	NET_SendPacket (chan->sock, length, data, chan->remote_address);
+}
+
+/*
+ * Splits a message that is too large for one
+ * datagram into fragments. The header is
+ * repeated in front of every fragment.
+ */
+static void Netchan_SendFragments (netchan_t *chan, sizebuf_t *send, int headerlen)
+{
+	sizebuf_t	frag;
+	byte		frag_buf[MAX_MSGLEN];
+	int			offset, length;
+
+	for (offset = headerlen; ; offset += length)
+	{
+		length = send->cursize - offset;
+
+		if (length > FRAGMENT_SIZE)
+			length = FRAGMENT_SIZE;
+
+		SZ_Init (&frag, frag_buf, sizeof(frag_buf));
+
+		SZ_Write (&frag, send->data, headerlen);
+		frag.data[3] |= FRAGMENT_BIT >> 24;
+		MSG_WriteShort (&frag, offset - headerlen);
+		MSG_WriteShort (&frag, length);
+		SZ_Write (&frag, send->data + offset, length);
+
+		Netchan_SendPacket (chan, frag.cursize, frag.data);
+
+		chan->fragments_sent++;
+		net_fragments_sent++;
+
+		/* a message of whole fragments
+		   ends with an empty one */
+		if (length < FRAGMENT_SIZE)
+			break;
+	}
+}
+
+/*
+ * Collects the fragments of a message. Once the
+ * last one is there, msg is rewritten into the
+ * packet it would have been without fragments.
+ * Returns false until then.
+ */
+static qboolean Netchan_Reassemble (netchan_t *chan, sizebuf_t *msg, int sequence)
+{
+	int		headerlen;
+	int		offset, length;
+
+	headerlen = msg->readcount;
+
+	offset = MSG_ReadShort (msg);
+	length = MSG_ReadShort (msg);
+
+	/* a late fragment of an older message */
+	if (sequence < chan->fragment_sequence)
+	{
+		chan->fragments_dropped++;
+		net_fragments_dropped++;
+		return false;
+	}
+
+	/* a new message, the rest of an
+	   unfinished one was lost */
+	if (sequence != chan->fragment_sequence)
+	{
+		chan->fragment_sequence = sequence;
+		chan->fragment_length = 0;
+	}
+
+	if (offset != chan->fragment_length || length < 0 || length > FRAGMENT_SIZE
+	        || msg->readcount + length > msg->cursize
+	        || headerlen + offset + length > msg->maxsize)
+	{
+		if (showdrop->value)
+			Com_Printf ("%s:Dropped fragment at %i of %i\n"
+			            , NET_AdrToString (chan->remote_address)
+			            , offset
+			            , sequence);
+
+		chan->fragments_dropped++;
+		net_fragments_dropped++;
+		return false;
+	}
+
+	memcpy (chan->fragment_buf + offset, msg->data + msg->readcount, length);
+	chan->fragment_length += length;
+
+	chan->fragments_received++;
+	net_fragments_received++;
+
+	if (length == FRAGMENT_SIZE)
+		return false;
+
+	/* the header stays, without the fragment bit */
+	msg->data[3] &= ~(FRAGMENT_BIT >> 24);
+	memcpy (msg->data + headerlen, chan->fragment_buf, chan->fragment_length);
+	msg->cursize = headerlen + chan->fragment_length;
+	msg->readcount = headerlen;
+
+	chan->fragment_length = 0;
+
+	return true;
 }
 
 /*
@@ -148,10 +292,50 @@ void Netchan_Setup (netsrc_t sock, netchan_t *chan, netadr_t adr, int qport)
 	chan->incoming_sequence = 0;
 	chan->outgoing_sequence = 1;
 
-	SZ_Init (&chan->message, chan->message_buf, sizeof(chan->message_buf));
+	chan->maxmsglen = MAX_MSGLEN;
+
+	SZ_Init (&chan->message, chan->message_buf, chan->maxmsglen - 16);
 	chan->message.allowoverflow = true;
 }
 
+/*
+ * Called after Netchan_Setup if both sides
+ * agreed on fragments. Messages can be
+ * MAX_BIGMSGLEN long from now on.
+ */
+void Netchan_EnableFragments (netchan_t *chan)
+{
+	chan->fragments = true;
+	chan->maxmsglen = MAX_BIGMSGLEN;
+	chan->fragment_sequence = -1;
+
+	chan->message.maxsize = chan->maxmsglen - 16;
+}
+
+/*
+ * Limits the messages sent on a channel with
+ * fragments to maxmsglen. A client recording
+ * a demo asks for MAX_MSGLEN, .dm2 files can't
+ * hold bigger messages.
+ */
+void Netchan_SetMaxMsgLen (netchan_t *chan, int maxmsglen)
+{
+	if (!chan->fragments)
+		return;
+
+	if (maxmsglen < MAX_MSGLEN)
+		maxmsglen = MAX_MSGLEN;
+	else if (maxmsglen > MAX_BIGMSGLEN)
+		maxmsglen = MAX_BIGMSGLEN;
+
+	chan->maxmsglen = maxmsglen;
+
+	/* a longer pending reliable message is still sent,
+	   the limit applies once it's moved out */
+	if (chan->message.cursize <= chan->maxmsglen - 16)
+		chan->message.maxsize = chan->maxmsglen - 16;
+}
+
 /*
  * Returns true if the last reliable message has acked
  */
@@ -192,9 +376,10 @@ qboolean Netchan_NeedReliable (netchan_t *chan)
 void Netchan_Transmit (netchan_t *chan, int length, byte *data)
 {
 	sizebuf_t	send;
-	byte		send_buf[MAX_MSGLEN];
+	byte		send_buf[MAX_BIGMSGLEN];
 	qboolean	send_reliable;
 	unsigned	w1, w2;
+	int			headerlen;
 
 	/* check for message overflow */
 	if (chan->message.overflowed)
@@ -212,10 +397,12 @@ void Netchan_Transmit (netchan_t *chan, int length, byte *data)
 		memcpy (chan->reliable_buf, chan->message_buf, chan->message.cursize);
 		chan->reliable_length = chan->message.cursize;
 		chan->message.cursize = 0;
+		chan->message.maxsize = chan->maxmsglen - 16;
 		chan->reliable_sequence ^= 1;
 	}
 
-	/* write the packet header */
+	/* write the packet header, a reliable message from
+	   before Netchan_SetMaxMsgLen may still be longer */
 	SZ_Init (&send, send_buf, sizeof(send_buf));
 
 	w1 = ( chan->outgoing_sequence & ~(1<<31) ) | (send_reliable<<31);
@@ -231,6 +418,8 @@ void Netchan_Transmit (netchan_t *chan, int length, byte *data)
 	if (chan->sock == NS_CLIENT)
 		MSG_WriteShort (&send, qport->value);
 
+	headerlen = send.cursize;
+
 	/* copy the reliable message to the packet first */
 	if (send_reliable)
 	{
@@ -239,13 +428,16 @@ void Netchan_Transmit (netchan_t *chan, int length, byte *data)
 	}
 
 	/* add the unreliable part if space is available */
-	if (send.maxsize - send.cursize >= length)
+	if (chan->maxmsglen - send.cursize >= length)
 		SZ_Write (&send, data, length);
 	else
 		Com_Printf ("Netchan_Transmit: dumped unreliable\n");
 
 	/* send the datagram */
-	NET_SendPacket (chan->sock, send.cursize, send.data, chan->remote_address);
+	if (send.cursize > MAX_MSGLEN)
+		Netchan_SendFragments (chan, &send, headerlen);
+	else
+		Netchan_SendPacket (chan, send.cursize, send.data);
 
 	if (showpackets->value)
 	{
@@ -273,6 +465,7 @@ qboolean Netchan_Process (netchan_t *chan, sizebuf_t *msg)
 {
 	unsigned	sequence, sequence_ack;
 	unsigned	reliable_ack, reliable_message;
+	qboolean	fragment;
 
 	/* get sequence numbers */
 	MSG_BeginReading (msg);
@@ -289,6 +482,14 @@ qboolean Netchan_Process (netchan_t *chan, sizebuf_t *msg)
 	sequence &= ~(1<<31);
 	sequence_ack &= ~(1<<31);
 
+	fragment = false;
+
+	if (chan->fragments && (sequence & FRAGMENT_BIT))
+	{
+		fragment = true;
+		sequence &= ~FRAGMENT_BIT;
+	}
+
 	if (showpackets->value)
 	{
 		if (reliable_message)
@@ -318,6 +519,9 @@ qboolean Netchan_Process (netchan_t *chan, sizebuf_t *msg)
 		return false;
 	}
 
+	if (fragment && !Netchan_Reassemble (chan, msg, sequence))
+		return false;
+
 	/* dropped packets don't keep the message from being used */
 	chan->dropped = sequence - (chan->incoming_sequence+1);
 
@@ -327,6 +327,114 @@ range(edict_t *self, edict_t *other)
 	return RANGE_FAR;
 }
 
+/*
+ * Sight cache. FindTarget, the attack checks
+ * and the pain code ask visible() for the same
+ * pairs over and over. Only brush models block
+ * MASK_OPAQUE traces, so an answer is reused as
+ * long as both eyes are at the same spot and no
+ * brush model was linked or unlinked since.
+ */
+
+#define SIGHT_HASHSIZE 1024 /* must be a power of two */
+
+typedef struct
+{
+	int self;
+	int other;
+	int epoch;
+	vec3_t spot1;
+	vec3_t spot2;
+	qboolean visible;
+} sightpair_t;
+
+static sightpair_t sight_pairs[SIGHT_HASHSIZE];
+
+static int sight_worldepoch = 1; /* bumped on brush models */
+
+static struct
+{
+	int calls;
+	int cached;
+	int traces;
+	int visible;
+} sight_stats;
+
+static void (*sight_linkentity)(edict_t *ent);
+static void (*sight_unlinkentity)(edict_t *ent);
+static void (*sight_setareaportalstate)(int portalnum, qboolean open);
+
+static void
+G_SightLinkEntity(edict_t *ent)
+{
+	if (ent && ent->model && (ent->model[0] == '*'))
+	{
+		sight_worldepoch++;
+	}
+
+	sight_linkentity(ent);
+}
+
+static void
+G_SightUnlinkEntity(edict_t *ent)
+{
+	if (ent && ent->model && (ent->model[0] == '*'))
+	{
+		sight_worldepoch++;
+	}
+
+	sight_unlinkentity(ent);
+}
+
+static void
+G_SightSetAreaPortalState(int portalnum, qboolean open)
+{
+	sight_worldepoch++;
+	sight_setareaportalstate(portalnum, open);
+}
+
+/*
+ * Called from GetGameAPI, watches
+ * for brush models moving.
+ */
+void
+G_SightInit(void)
+{
+	sight_linkentity = gi.linkentity;
+	gi.linkentity = G_SightLinkEntity;
+
+	sight_unlinkentity = gi.unlinkentity;
+	gi.unlinkentity = G_SightUnlinkEntity;
+
+	sight_setareaportalstate = gi.SetAreaPortalState;
+	gi.SetAreaPortalState = G_SightSetAreaPortalState;
+}
+
+/*
+ * Forgets everything, called when
+ * a map or a savegame is loaded.
+ */
+void
+G_ResetSight(void)
+{
+	sight_worldepoch++;
+}
+
+void
+Svcmd_SightStats_f(void)
+{
+	if (Q_stricmp(gi.argv(2), "reset") == 0)
+	{
+		memset(&sight_stats, 0, sizeof(sight_stats));
+		return;
+	}
+
+	gi.cprintf(NULL, PRINT_HIGH, "%i sight checks, %i visible:\n",
+			sight_stats.calls, sight_stats.visible);
+	gi.cprintf(NULL, PRINT_HIGH, "%8i cached\n", sight_stats.cached);
+	gi.cprintf(NULL, PRINT_HIGH, "%8i traced\n", sight_stats.traces);
+}
+
 /*
  * returns 1 if the entity is visible
  * to self, even if not infront
@@ -337,6 +445,8 @@ visible(edict_t *self, edict_t *other)
 	vec3_t spot1;
 	vec3_t spot2;
 	trace_t trace;
+	sightpair_t *pair;
+	int num1, num2;
 
 	if (!self || !other)
 	{
@@ -347,10 +457,36 @@ visible(edict_t *self, edict_t *other)
 	spot1[2] += self->viewheight;
 	VectorCopy(other->s.origin, spot2);
 	spot2[2] += other->viewheight;
+
+	sight_stats.calls++;
+
+	num1 = self - g_edicts;
+	num2 = other - g_edicts;
+	pair = &sight_pairs[(num1 * 61 + num2) & (SIGHT_HASHSIZE - 1)];
+
+	if ((pair->epoch == sight_worldepoch) && (pair->self == num1) &&
+		(pair->other == num2) && VectorCompare(pair->spot1, spot1) &&
+		VectorCompare(pair->spot2, spot2))
+	{
+		sight_stats.cached++;
+		sight_stats.visible += pair->visible;
+		return pair->visible;
+	}
+
+	pair->epoch = sight_worldepoch;
+	pair->self = num1;
+	pair->other = num2;
+	VectorCopy(spot1, pair->spot1);
+	VectorCopy(spot2, pair->spot2);
+	pair->visible = false;
+
+	sight_stats.traces++;
 	trace = gi.trace(spot1, vec3_origin, vec3_origin, spot2, self, MASK_OPAQUE);
 
 	if (trace.fraction == 1.0)
 	{
+		pair->visible = true;
+		sight_stats.visible++;
 		return true;
 	}
 
@@ -132,6 +132,12 @@ Killed(edict_t *targ, edict_t *inflictor, edict_t *attacker,
 		targ->health = -999;
 	}
 
+	G_WakeEntity(targ);
+
+	/* the die functions change solid,
+	   svflags and the bbox */
+	g_worldchanges++;
+
 	targ->enemy = attacker;
 
 	if ((targ->svflags & SVF_MONSTER) && (targ->deadflag != DEAD_DEAD))
@@ -713,6 +719,7 @@ T_Damage(edict_t *targ, edict_t *inflictor, edict_t *attacker,
 	{
 		if (targ->pain)
 		{
+			G_WakeEntity(targ);
 			targ->pain(targ, attacker, knockback, take);
 		}
 	}
@@ -730,45 +737,185 @@ T_Damage(edict_t *targ, edict_t *inflictor, edict_t *attacker,
 	}
 }
 
+#define MAX_RADIUS_TARGETS 16
+
+static const float radius_corners[4][2] = {
+	{15, 15}, {15, -15}, {-15, 15}, {-15, -15}
+};
+
+/*
+ * Does the CanDamage checks of several targets
+ * with two trace batches: the centers first, then
+ * the corners of the targets not seen by that.
+ */
+static void
+T_RadiusDamageSeen(edict_t *inflictor, edict_t **targets, qboolean *seen,
+		int count)
+{
+	tracerequest_t req[MAX_RADIUS_TARGETS * 4];
+	int owner[MAX_RADIUS_TARGETS * 4];
+	edict_t *ent;
+	int i, j, n;
+
+	for (i = 0; i < count; i++)
+	{
+		ent = targets[i];
+
+		VectorCopy(inflictor->s.origin, req[i].start);
+		VectorClear(req[i].mins);
+		VectorClear(req[i].maxs);
+		req[i].passent = inflictor;
+		req[i].contentmask = MASK_SOLID;
+
+		/* bmodels need special checking because their origin is 0,0,0 */
+		if (ent->movetype == MOVETYPE_PUSH)
+		{
+			VectorAdd(ent->absmin, ent->absmax, req[i].end);
+			VectorScale(req[i].end, 0.5, req[i].end);
+		}
+		else
+		{
+			VectorCopy(ent->s.origin, req[i].end);
+		}
+	}
+
+	gi.TraceBatch(req, count);
+
+	for (i = 0; i < count; i++)
+	{
+		seen[i] = (req[i].trace.fraction == 1.0) ||
+				  ((targets[i]->movetype == MOVETYPE_PUSH) &&
+				   (req[i].trace.ent == targets[i]));
+	}
+
+	n = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		if (seen[i] || (targets[i]->movetype == MOVETYPE_PUSH))
+		{
+			continue;
+		}
+
+		for (j = 0; j < 4; j++, n++)
+		{
+			VectorCopy(inflictor->s.origin, req[n].start);
+			VectorClear(req[n].mins);
+			VectorClear(req[n].maxs);
+			VectorCopy(targets[i]->s.origin, req[n].end);
+			req[n].end[0] += radius_corners[j][0];
+			req[n].end[1] += radius_corners[j][1];
+			req[n].passent = inflictor;
+			req[n].contentmask = MASK_SOLID;
+			owner[n] = i;
+		}
+	}
+
+	if (n)
+	{
+		gi.TraceBatch(req, n);
+
+		for (j = 0; j < n; j++)
+		{
+			if (req[j].trace.fraction == 1.0)
+			{
+				seen[owner[j]] = true;
+			}
+		}
+	}
+}
+
+static float
+T_RadiusDamagePoints(edict_t *inflictor, edict_t *attacker, float damage,
+		edict_t *ignore, edict_t *ent)
+{
+	float points;
+	vec3_t v;
+
+	if (ent == ignore)
+	{
+		return 0;
+	}
+
+	if (!ent->takedamage)
+	{
+		return 0;
+	}
+
+	VectorAdd(ent->mins, ent->maxs, v);
+	VectorMA(ent->s.origin, 0.5, v, v);
+	VectorSubtract(inflictor->s.origin, v, v);
+	points = damage - 0.5 * VectorLength(v);
+
+	if (ent == attacker)
+	{
+		points = points * 0.5;
+	}
+
+	return points;
+}
+
+/*
+ * The CanDamage checks of the next targets are
+ * traced as one batch, the damage is still dealt
+ * one target after the other. Once a target
+ * changed the world the batch is stale, and the
+ * targets after it are searched and checked again.
+ */
 void
 T_RadiusDamage(edict_t *inflictor, edict_t *attacker, float damage,
 		edict_t *ignore, float radius, int mod)
 {
+	edict_t *targets[MAX_RADIUS_TARGETS];
+	qboolean seen[MAX_RADIUS_TARGETS];
+	unsigned int changes;
 	float points;
 	edict_t *ent = NULL;
-	vec3_t v;
+	edict_t *next;
 	vec3_t dir;
+	int count;
+	int i;
 
 	if (!inflictor || !attacker)
 	{
 		return;
 	}
 
-	while ((ent = findradius(ent, inflictor->s.origin, radius)) != NULL)
+	while (1)
 	{
-		if (ent == ignore)
+		count = 0;
+		next = ent;
+
+		while ((count < MAX_RADIUS_TARGETS) &&
+			   ((next = findradius(next, inflictor->s.origin, radius)) != NULL))
 		{
-			continue;
+			if (T_RadiusDamagePoints(inflictor, attacker, damage,
+						ignore, next) > 0)
+			{
+				targets[count++] = next;
+			}
 		}
 
-		if (!ent->takedamage)
+		if (!count)
 		{
-			continue;
+			break;
 		}
 
-		VectorAdd(ent->mins, ent->maxs, v);
-		VectorMA(ent->s.origin, 0.5, v, v);
-		VectorSubtract(inflictor->s.origin, v, v);
-		points = damage - 0.5 * VectorLength(v);
+		changes = g_worldchanges;
+		T_RadiusDamageSeen(inflictor, targets, seen, count);
 
-		if (ent == attacker)
+		for (i = 0; i < count; i++)
 		{
-			points = points * 0.5;
-		}
+			if (g_worldchanges != changes)
+			{
+				break;
+			}
 
-		if (points > 0)
-		{
-			if (CanDamage(ent, inflictor))
+			ent = targets[i];
+			points = T_RadiusDamagePoints(inflictor, attacker, damage,
+					ignore, ent);
+
+			if ((points > 0) && seen[i])
 			{
 				VectorSubtract(ent->s.origin, inflictor->s.origin, dir);
 				T_Damage(ent, inflictor, attacker, dir, inflictor->s.origin,
@@ -776,5 +923,10 @@ T_RadiusDamage(edict_t *inflictor, edict_t *attacker, float damage,
 						mod);
 			}
 		}
+
+		if ((i == count) && !next)
+		{
+			break;
+		}
 	}
 }
@@ -24,11 +24,15 @@
  * =======================================================================
  */
 
+#include <ctype.h>
+
 #include "header/local.h"
 
 #define HEALTH_IGNORE_MAX 1
 #define HEALTH_TIMED 2
 
+#define ITEM_HASHSIZE 256 /* must be a power of two */
+
 qboolean Pickup_Weapon(edict_t *ent, edict_t *other);
 void Use_Weapon(edict_t *ent, gitem_t *inv);
 void Drop_Weapon(edict_t *ent, gitem_t *inv);
@@ -58,8 +62,49 @@ static int power_shield_index;
 void Use_Quad(edict_t *ent, gitem_t *item);
 static int quad_drop_timeout_hack;
 
+/* itemlist index + 1 of each name, 0 if empty */
+static int item_classnames[ITEM_HASHSIZE];
+static int item_pickupnames[ITEM_HASHSIZE];
+
 /* ====================================================================== */
 
+/*
+ * Returns the slot of the item with the
+ * classname or pickup name, or the free
+ * slot it would go into. Names are case
+ * insensitive.
+ */
+static int *
+ItemHashSlot(const char *name, qboolean pickup)
+{
+	unsigned hash;
+	const char *s;
+	char *key;
+	int *table;
+	int i;
+
+	table = pickup ? item_pickupnames : item_classnames;
+
+	for (hash = 0, s = name; *s; s++)
+	{
+		hash = hash * 31 + tolower((unsigned char)*s);
+	}
+
+	for (i = hash & (ITEM_HASHSIZE - 1); table[i];
+		 i = (i + 1) & (ITEM_HASHSIZE - 1))
+	{
+		key = pickup ? itemlist[table[i] - 1].pickup_name :
+			  itemlist[table[i] - 1].classname;
+
+		if (!Q_stricmp(key, name))
+		{
+			break;
+		}
+	}
+
+	return &table[i];
+}
+
 gitem_t *
 GetItemByIndex(int index)
 {
@@ -74,59 +119,31 @@ GetItemByIndex(int index)
 gitem_t *
 FindItemByClassname(char *classname)
 {
-	int i;
-	gitem_t *it;
+	int *slot;
 
 	if (!classname)
 	{
 		return NULL;
 	}
 
-	it = itemlist;
+	slot = ItemHashSlot(classname, false);
 
-	for (i = 0; i < game.num_items; i++, it++)
-	{
-		if (!it->classname)
-		{
-			continue;
-		}
-
-		if (!Q_stricmp(it->classname, classname))
-		{
-			return it;
-		}
-	}
-
-	return NULL;
+	return *slot ? &itemlist[*slot - 1] : NULL;
 }
 
 gitem_t *
 FindItem(char *pickup_name)
 {
-	int i;
-	gitem_t *it;
+	int *slot;
 
 	if (!pickup_name)
 	{
 		return NULL;
 	}
 
-	it = itemlist;
-
-	for (i = 0; i < game.num_items; i++, it++)
-	{
-		if (!it->pickup_name)
-		{
-			continue;
-		}
+	slot = ItemHashSlot(pickup_name, true);
 
-		if (!Q_stricmp(it->pickup_name, pickup_name))
-		{
-			return it;
-		}
-	}
-
-	return NULL;
+	return *slot ? &itemlist[*slot - 1] : NULL;
 }
 
 /* ====================================================================== */
@@ -2673,7 +2690,43 @@ SP_item_health_mega(edict_t *self)
 void
 InitItems(void)
 {
+	int i;
+	int *slot;
+
 	game.num_items = sizeof(itemlist) / sizeof(itemlist[0]) - 1;
+
+	if (game.num_items >= ITEM_HASHSIZE)
+	{
+		gi.error("InitItems: too many items");
+	}
+
+	memset(item_classnames, 0, sizeof(item_classnames));
+	memset(item_pickupnames, 0, sizeof(item_pickupnames));
+
+	/* on duplicates the first one wins,
+	   like with a linear search */
+	for (i = 0; i < game.num_items; i++)
+	{
+		if (itemlist[i].classname)
+		{
+			slot = ItemHashSlot(itemlist[i].classname, false);
+
+			if (!*slot)
+			{
+				*slot = i + 1;
+			}
+		}
+
+		if (itemlist[i].pickup_name)
+		{
+			slot = ItemHashSlot(itemlist[i].pickup_name, true);
+
+			if (!*slot)
+			{
+				*slot = i + 1;
+			}
+		}
+	}
 }
 
 /*
@@ -24,6 +24,7 @@
  * =======================================================================
  */
 
+#include <stddef.h>
 #include "header/local.h"
 
 game_locals_t game;
@@ -78,6 +79,8 @@ cvar_t *flood_waitdelay;
 
 cvar_t *sv_maplist;
 
+cvar_t *sv_profile;
+
 cvar_t *gib_on;
 
 void SpawnEntities(char *mapname, char *entities, char *spawnpoint);
@@ -114,7 +117,27 @@ ShutdownGame(void)
 game_export_t *
 GetGameAPI(game_import_t *import)
 {
-	gi = *import;
+	/* older engines end game_import_t
+	   at DebugGraph, don't read past it */
+	if (import->cvar(GAME_IMPORTS_CVAR, "0", CVAR_NOSET)->value >=
+		GAME_IMPORTS_TRACEBATCH)
+	{
+		gi = *import;
+	}
+	else
+	{
+		memcpy(&gi, import, offsetof(game_import_t, TraceBatch));
+		gi.TraceBatch = G_TraceBatch;
+	}
+
+	/* lets trace batches notice when they are stale */
+	G_WorldChangesInit();
+
+	/* count traces per entity class */
+	G_ProfileInit();
+
+	/* cache monster sight checks */
+	G_SightInit();
 
 	globals.apiversion = GAME_API_VERSION;
 	globals.Init = InitGame;
@@ -410,6 +433,8 @@ G_RunFrame(void)
 	level.framenum++;
 	level.time = level.framenum * FRAMETIME;
 
+	G_ProfileBeginFrame();
+
 	/* choose a client for monsters to target this frame */
 	AI_SetSightClient();
 
@@ -417,18 +442,23 @@ G_RunFrame(void)
 	if (level.exitintermission)
 	{
 		ExitLevel();
+		G_ProfileEndFrame();
 		return;
 	}
 
+	G_RunThinkWheel();
+
 	/* treat each object in turn
 	   even the world gets a chance
-	   to think */
-	ent = &g_edicts[0];
-
-	for (i = 0; i < globals.num_edicts; i++, ent++)
+	   to think. Sleeping ones have
+	   nothing to do */
+	for (i = G_NextAwakeEntity(-1); i >= 0; i = G_NextAwakeEntity(i))
 	{
+		ent = &g_edicts[i];
+
 		if (!ent->inuse)
 		{
+			G_ScheduleEntity(ent);
 			continue;
 		}
 
@@ -451,11 +481,14 @@ G_RunFrame(void)
 
 		if ((i > 0) && (i <= maxclients->value))
 		{
+			G_ProfilePush(GP_CLIENTS, NULL);
 			ClientBeginServerFrame(ent);
+			G_ProfilePop();
 			continue;
 		}
 
 		G_RunEntity(ent);
+		G_ScheduleEntity(ent);
 	}
 
 	/* see if it is time to end a deathmatch */
@@ -465,5 +498,9 @@ G_RunFrame(void)
 	CheckNeedPass();
 
 	/* build the playerstate_t structures for all players */
+	G_ProfilePush(GP_CLIENTS, NULL);
 	ClientEndServerFrames();
+	G_ProfilePop();
+
+	G_ProfileEndFrame();
 }
@@ -135,7 +135,9 @@ SV_RunThink(edict_t *ent)
 		gi.error("NULL ent->think");
 	}
 
+	G_ProfilePush(GP_THINK, ent);
 	ent->think(ent);
+	G_ProfilePop();
 
 	return false;
 }
@@ -158,11 +160,13 @@ SV_Impact(edict_t *e1, trace_t *trace)
 
 	if (e1->touch && (e1->solid != SOLID_NOT))
 	{
+		G_WakeEntity(e1);
 		e1->touch(e1, e2, &trace->plane, trace->surface);
 	}
 
 	if (e2->touch && (e2->solid != SOLID_NOT))
 	{
+		G_WakeEntity(e2);
 		e2->touch(e2, e1, NULL, NULL);
 	}
 }
@@ -569,6 +573,15 @@ typedef struct
 pushed_t pushed[MAX_EDICTS], *pushed_p;
 edict_t *obstacle;
 
+static int
+SV_CompareEdicts(const void *a, const void *b)
+{
+	edict_t *ea = *(edict_t **)a;
+	edict_t *eb = *(edict_t **)b;
+
+	return (int)(ea - eb);
+}
+
 /*
  * Objects need to be moved back on a failed push,
  * otherwise riders would continue to slide.
@@ -578,9 +591,13 @@ SV_Push(edict_t *pusher, vec3_t move, vec3_t amove)
 {
 	int i, e;
 	edict_t *check, *block;
+	edict_t *candidates[MAX_EDICTS];
+	int numcandidates;
 	pushed_t *p;
 	vec3_t org, org2, move2, forward, right, up;
 	vec3_t realmins, realmaxs;
+	vec3_t mins, maxs, extent;
+	float radius;
 
 	if (!pusher)
 	{
@@ -631,12 +648,77 @@ SV_Push(edict_t *pusher, vec3_t move, vec3_t amove)
 	   rotating brush models. */
 	RealBoundingBox(pusher,realmins,realmaxs);
 
+	/* only entities touching the old or the
+	   new position can be inside it or ride
+	   on the pusher, ask the area tree for
+	   them. The slack covers riders. A
+	   rotating pusher can reach everything
+	   in the sphere around its origin.
+	   SOLID_NOT entities aren't in the
+	   area tree, but they never were
+	   pushed: they aren't linked into
+	   an area node, the area.prev check
+	   below has always skipped them */
+	if (pusher->s.angles[0] || pusher->s.angles[1] || pusher->s.angles[2] ||
+		amove[0] || amove[1] || amove[2])
+	{
+		for (i = 0; i < 3; i++)
+		{
+			extent[i] = fabs(pusher->mins[i]) > fabs(pusher->maxs[i]) ?
+					 fabs(pusher->mins[i]) : fabs(pusher->maxs[i]);
+		}
+
+		radius = VectorLength(extent);
+
+		for (i = 0; i < 3; i++)
+		{
+			mins[i] = pusher->s.origin[i] - radius;
+			maxs[i] = pusher->s.origin[i] + radius;
+		}
+	}
+	else
+	{
+		VectorCopy(pusher->absmin, mins);
+		VectorCopy(pusher->absmax, maxs);
+	}
+
+	for (i = 0; i < 3; i++)
+	{
+		mins[i] -= 8;
+		maxs[i] += 8;
+
+		if (move[i] > 0)
+		{
+			mins[i] -= move[i];
+		}
+		else
+		{
+			maxs[i] -= move[i];
+		}
+	}
+
+	numcandidates = gi.BoxEdicts(mins, maxs, candidates,
+			MAX_EDICTS, AREA_SOLID);
+	numcandidates += gi.BoxEdicts(mins, maxs, candidates + numcandidates,
+			MAX_EDICTS - numcandidates, AREA_TRIGGERS);
+
+	/* push them in edict order, like a
+	   loop over all edicts would */
+	qsort(candidates, numcandidates, sizeof(candidates[0]), SV_CompareEdicts);
+
+	G_ProfilePushChecks(numcandidates);
+
 	/* see if any solid entities
 	   are inside the final position */
-	check = g_edicts + 1;
-
-	for (e = 1; e < globals.num_edicts; e++, check++)
+	for (e = 0; e < numcandidates; e++)
 	{
+		check = candidates[e];
+
+		if ((check == pusher) || (check == g_edicts))
+		{
+			continue;
+		}
+
 		if (!check->inuse)
 		{
 			continue;
@@ -828,6 +910,7 @@ SV_Physics_Pusher(edict_t *ent)
 		   is gone */
 		if (part->blocked)
 		{
+			G_WakeEntity(part);
 			part->blocked(part, obstacle);
 		}
 	}
@@ -1238,6 +1321,8 @@ G_RunEntity(edict_t *ent)
 		return;
 	}
 
+	G_ProfilePush(GP_PHYSICS, ent);
+
 	if (ent->prethink)
 	{
 		ent->prethink(ent);
@@ -1267,4 +1352,6 @@ G_RunEntity(edict_t *ent)
 		default:
 			gi.error("SV_Physics: bad movetype %i", (int)ent->movetype);
 	}
+
+	G_ProfilePop();
 }
@@ -0,0 +1,628 @@
+/*
+ * Copyright (C) 1997-2001 Id Software, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * =======================================================================
+ *
+ * Game side of the server tick profiler. While "sv_profile" is set
+ * G_RunFrame is split into physics, think functions and client frames.
+ * Phases nest, a think function called from the physics code is only
+ * charged to think. The time, the number of calls and the traces are
+ * also accounted to the classname of the entity that caused them.
+ * "sv profile" prints the last frames, "sv profile classes" the most
+ * expensive classes. "sv spawnbench" measures edict allocation.
+ *
+ * =======================================================================
+ */
+
+#include <sys/time.h>
+
+#include "header/local.h"
+
+#define GP_WINDOW 600 /* one minute of frames */
+#define GP_MAXDEPTH 8
+#define GP_MAXCLASSES 128
+#define GP_HASHSIZE 256 /* must be a power of two */
+#define GP_NAMELEN 32
+
+static const char *gp_phasenames[GP_NUMPHASES] = {
+	"physics", "think", "clients", "other"
+};
+
+typedef struct
+{
+	int total;
+	int phase[GP_NUMPHASES];
+} gp_frame_t;
+
+typedef struct
+{
+	int physics; /* usec */
+	int think;   /* usec */
+	int runs;
+	int thinks;
+	int traces;
+	int pushchecks; /* entities a pusher had to check */
+} gp_cost_t;
+
+typedef struct
+{
+	char name[GP_NAMELEN];
+	gp_cost_t current;
+	gp_cost_t frames[GP_WINDOW];
+} gp_class_t;
+
+typedef struct
+{
+	int class;
+	gp_cost_t cost;
+} gp_sum_t;
+
+typedef struct
+{
+	int phase;
+	int class; /* -1 if not caused by an entity */
+} gp_level_t;
+
+static gp_frame_t gp_frames[GP_WINDOW];
+static int gp_numframes;
+
+static gp_frame_t gp_current;
+static long long gp_stamp;
+static qboolean gp_active;
+
+static gp_level_t gp_stack[GP_MAXDEPTH];
+static int gp_depth;
+
+/* allocated when profiling starts, the
+   last slot takes all classes that
+   don't fit into the table */
+static gp_class_t *gp_classes;
+static int gp_numclasses;
+static int gp_hash[GP_HASHSIZE];
+
+static trace_t (*gp_trace)(vec3_t start, vec3_t mins, vec3_t maxs,
+		vec3_t end, edict_t *passent, int contentmask);
+
+static long long
+G_ProfileTime(void)
+{
+	struct timeval tp;
+
+	gettimeofday(&tp, NULL);
+
+	return (long long)tp.tv_sec * 1000000 + tp.tv_usec;
+}
+
+/*
+ * Returns the slot of the entities
+ * class, adding it if necessary.
+ * Only as much of the classname as
+ * fits into a slot counts, longer
+ * names share the slot of their
+ * truncated form.
+ */
+static int
+G_ProfileClass(edict_t *ent)
+{
+	unsigned hash;
+	char *s;
+	int i;
+
+	if (!ent || !ent->classname)
+	{
+		return -1;
+	}
+
+	for (hash = 0, s = ent->classname;
+		 *s && (s - ent->classname < GP_NAMELEN - 1); s++)
+	{
+		hash = hash * 31 + *s;
+	}
+
+	for (i = hash & (GP_HASHSIZE - 1); gp_hash[i];
+		 i = (i + 1) & (GP_HASHSIZE - 1))
+	{
+		if (!strncmp(gp_classes[gp_hash[i] - 1].name, ent->classname,
+				GP_NAMELEN - 1))
+		{
+			return gp_hash[i] - 1;
+		}
+	}
+
+	if (gp_numclasses == GP_MAXCLASSES - 1)
+	{
+		return GP_MAXCLASSES - 1;
+	}
+
+	strncpy(gp_classes[gp_numclasses].name, ent->classname,
+			GP_NAMELEN - 1);
+	gp_hash[i] = ++gp_numclasses;
+
+	return gp_numclasses - 1;
+}
+
+/*
+ * Charges the time since the last switch
+ * to the running phase and class.
+ */
+static void
+G_ProfileSwitch(void)
+{
+	gp_level_t *level;
+	long long now;
+	int usec;
+
+	now = G_ProfileTime();
+	usec = (int)(now - gp_stamp);
+	gp_stamp = now;
+
+	level = &gp_stack[gp_depth];
+	gp_current.phase[level->phase] += usec;
+
+	if (level->class < 0)
+	{
+		return;
+	}
+
+	if (level->phase == GP_THINK)
+	{
+		gp_classes[level->class].current.think += usec;
+	}
+	else
+	{
+		gp_classes[level->class].current.physics += usec;
+	}
+}
+
+/*
+ * Counts the traces of the class
+ * running on top of the stack.
+ */
+static trace_t
+G_ProfileTrace(vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end,
+		edict_t *passent, int contentmask)
+{
+	if (gp_active && (gp_stack[gp_depth].class >= 0))
+	{
+		gp_classes[gp_stack[gp_depth].class].current.traces++;
+	}
+
+	return gp_trace(start, mins, maxs, end, passent, contentmask);
+}
+
+/*
+ * Counts the entities SV_Push had
+ * to check for the class running
+ * on top of the stack.
+ */
+void
+G_ProfilePushChecks(int count)
+{
+	if (gp_active && (gp_stack[gp_depth].class >= 0))
+	{
+		gp_classes[gp_stack[gp_depth].class].current.pushchecks += count;
+	}
+}
+
+static void (*gp_tracebatch)(tracerequest_t *requests, int count);
+
+static void
+G_ProfileTraceBatch(tracerequest_t *requests, int count)
+{
+	if (gp_active && (gp_stack[gp_depth].class >= 0))
+	{
+		gp_classes[gp_stack[gp_depth].class].current.traces += count;
+	}
+
+	gp_tracebatch(requests, count);
+}
+
+/*
+ * Called from GetGameAPI,
+ * routes gi.trace and gi.TraceBatch
+ * through the profiler.
+ */
+void
+G_ProfileInit(void)
+{
+	gp_trace = gi.trace;
+	gi.trace = G_ProfileTrace;
+
+	/* the fallback counts through gi.trace */
+	if (gi.TraceBatch != G_TraceBatch)
+	{
+		gp_tracebatch = gi.TraceBatch;
+		gi.TraceBatch = G_ProfileTraceBatch;
+	}
+}
+
+void
+G_ProfileBeginFrame(void)
+{
+	gp_active = sv_profile->value != 0;
+
+	if (!gp_active)
+	{
+		return;
+	}
+
+	if (!gp_classes)
+	{
+		gp_classes = gi.TagMalloc(GP_MAXCLASSES * sizeof(gp_class_t), TAG_GAME);
+		memset(gp_classes, 0, GP_MAXCLASSES * sizeof(gp_class_t));
+		strcpy(gp_classes[GP_MAXCLASSES - 1].name, "(overflow)");
+	}
+
+	memset(&gp_current, 0, sizeof(gp_current));
+
+	gp_depth = 0;
+	gp_stack[0].phase = GP_OTHER;
+	gp_stack[0].class = -1;
+	gp_stamp = G_ProfileTime();
+}
+
+/*
+ * Enters a phase. If ent is set the
+ * phase is charged to its class.
+ */
+void
+G_ProfilePush(int phase, edict_t *ent)
+{
+	int class;
+
+	if (!gp_active)
+	{
+		return;
+	}
+
+	G_ProfileSwitch();
+
+	class = G_ProfileClass(ent);
+
+	if (class >= 0)
+	{
+		if (phase == GP_THINK)
+		{
+			gp_classes[class].current.thinks++;
+		}
+		else
+		{
+			gp_classes[class].current.runs++;
+		}
+	}
+
+	if (gp_depth < GP_MAXDEPTH - 1)
+	{
+		gp_depth++;
+	}
+
+	gp_stack[gp_depth].phase = phase;
+	gp_stack[gp_depth].class = class;
+}
+
+void
+G_ProfilePop(void)
+{
+	if (!gp_active)
+	{
+		return;
+	}
+
+	G_ProfileSwitch();
+
+	if (gp_depth > 0)
+	{
+		gp_depth--;
+	}
+}
+
+void
+G_ProfileEndFrame(void)
+{
+	gp_frame_t *frame;
+	gp_class_t *class;
+	int slot;
+	int i;
+
+	if (!gp_active)
+	{
+		return;
+	}
+
+	G_ProfileSwitch();
+
+	slot = gp_numframes % GP_WINDOW;
+
+	frame = &gp_frames[slot];
+	*frame = gp_current;
+
+	for (i = 0; i < GP_NUMPHASES; i++)
+	{
+		frame->total += frame->phase[i];
+	}
+
+	for (i = 0; i < GP_MAXCLASSES; i++)
+	{
+		class = &gp_classes[i];
+
+		if ((i >= gp_numclasses) && (i != GP_MAXCLASSES - 1))
+		{
+			continue;
+		}
+
+		class->frames[slot] = class->current;
+		memset(&class->current, 0, sizeof(class->current));
+	}
+
+	gp_numframes++;
+}
+
+static int
+G_ProfileCompare(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+static int
+G_ProfileCompareSum(const void *a, const void *b)
+{
+	const gp_sum_t *sa = a;
+	const gp_sum_t *sb = b;
+
+	return (sb->cost.physics + sb->cost.think) -
+		   (sa->cost.physics + sa->cost.think);
+}
+
+static void
+G_ProfilePrintColumn(const char *name, int *values, int count)
+{
+	int i;
+	long long sum;
+
+	qsort(values, count, sizeof(int), G_ProfileCompare);
+
+	for (i = 0, sum = 0; i < count; i++)
+	{
+		sum += values[i];
+	}
+
+	gi.cprintf(NULL, PRINT_HIGH, "%-8s %7.2f %7.2f %7.2f\n", name,
+			(sum / count) / 1000.0,
+			values[(count * 99) / 100] / 1000.0,
+			values[count - 1] / 1000.0);
+}
+
+/*
+ * Prints the most expensive
+ * classes over the last frames.
+ */
+static void
+G_ProfilePrintClasses(int top, int frames)
+{
+	gp_sum_t sums[GP_MAXCLASSES];
+	gp_cost_t *cost, *frame;
+	int numsums;
+	int i, j;
+
+	if (frames > gp_numframes)
+	{
+		frames = gp_numframes;
+	}
+
+	if (frames > GP_WINDOW)
+	{
+		frames = GP_WINDOW;
+	}
+
+	if (!gp_classes || (frames <= 0))
+	{
+		gi.cprintf(NULL, PRINT_HIGH, "No game frames profiled.\n");
+		return;
+	}
+
+	numsums = 0;
+
+	for (i = 0; i < GP_MAXCLASSES; i++)
+	{
+		if ((i >= gp_numclasses) && (i != GP_MAXCLASSES - 1))
+		{
+			continue;
+		}
+
+		sums[numsums].class = i;
+		cost = &sums[numsums].cost;
+		memset(cost, 0, sizeof(*cost));
+
+		for (j = 0; j < frames; j++)
+		{
+			frame = &gp_classes[i].frames[(gp_numframes - 1 - j) % GP_WINDOW];
+
+			cost->physics += frame->physics;
+			cost->think += frame->think;
+			cost->runs += frame->runs;
+			cost->thinks += frame->thinks;
+			cost->traces += frame->traces;
+			cost->pushchecks += frame->pushchecks;
+		}
+
+		numsums++;
+	}
+
+	qsort(sums, numsums, sizeof(gp_sum_t), G_ProfileCompareSum);
+
+	gi.cprintf(NULL, PRINT_HIGH, "Top classes over the last %i frames, times in ms:\n", frames);
+	gi.cprintf(NULL, PRINT_HIGH, "%-24s %8s %7s %8s %8s %7s %7s %8s %8s\n", "class",
+			"total", "/frame", "physics", "think", "runs", "thinks", "traces",
+			"pushchk");
+
+	for (i = 0; (i < numsums) && (i < top); i++)
+	{
+		cost = &sums[i].cost;
+
+		if (!cost->runs && !cost->thinks)
+		{
+			break;
+		}
+
+		gi.cprintf(NULL, PRINT_HIGH, "%-24s %8.2f %7.3f %8.2f %8.2f %7i %7i %8i %8i\n",
+				gp_classes[sums[i].class].name,
+				(cost->physics + cost->think) / 1000.0,
+				(cost->physics + cost->think) / 1000.0 / frames,
+				cost->physics / 1000.0, cost->think / 1000.0,
+				cost->runs, cost->thinks, cost->traces, cost->pushchecks);
+	}
+}
+
+void
+Svcmd_Profile_f(void)
+{
+	int values[GP_WINDOW];
+	int count;
+	int i, j;
+
+	if (Q_stricmp(gi.argv(2), "reset") == 0)
+	{
+		gp_numframes = 0;
+		return;
+	}
+
+	if (Q_stricmp(gi.argv(2), "classes") == 0)
+	{
+		G_ProfilePrintClasses(gi.argc() > 3 ? atoi(gi.argv(3)) : 10,
+				gi.argc() > 4 ? atoi(gi.argv(4)) : GP_WINDOW);
+		return;
+	}
+
+	count = gp_numframes < GP_WINDOW ? gp_numframes : GP_WINDOW;
+
+	if (!count)
+	{
+		gi.cprintf(NULL, PRINT_HIGH, "No game frames profiled.\n");
+		return;
+	}
+
+	gi.cprintf(NULL, PRINT_HIGH, "Last %i game frames, times in ms:\n", count);
+	gi.cprintf(NULL, PRINT_HIGH, "%-8s %7s %7s %7s\n", "", "mean", "p99", "max");
+
+	for (i = 0; i < count; i++)
+	{
+		values[i] = gp_frames[i].total;
+	}
+
+	G_ProfilePrintColumn("game", values, count);
+
+	for (j = 0; j < GP_NUMPHASES; j++)
+	{
+		for (i = 0; i < count; i++)
+		{
+			values[i] = gp_frames[i].phase[j];
+		}
+
+		G_ProfilePrintColumn(gp_phasenames[j], values, count);
+	}
+}
+
+/*
+ * Spawn churn benchmark, "sv spawnbench [frames] [perframe]".
+ * Simulates projectiles: every frame perframe edicts are spawned
+ * and freed again a second later. Game time is advanced for the
+ * run and restored afterwards.
+ */
+void
+Svcmd_SpawnBench_f(void)
+{
+	edict_t *live[1024];
+	int frames, perframe, lifetime;
+	int numlive, first;
+	int startedicts;
+	float oldtime;
+	long long start, elapsed;
+	int i, j;
+
+	frames = gi.argc() > 2 ? atoi(gi.argv(2)) : 1000;
+	perframe = gi.argc() > 3 ? atoi(gi.argv(3)) : 20;
+	lifetime = 10;
+
+	/* live ones plus the ones waiting out their freetime */
+	if ((frames < 1) || (perframe < 1) ||
+		(perframe * (lifetime + 6) > 1024) ||
+		(globals.num_edicts + perframe * (lifetime + 6) > game.maxentities))
+	{
+		gi.cprintf(NULL, PRINT_HIGH, "Not enough free edicts for %i per frame.\n",
+				perframe);
+		return;
+	}
+
+	oldtime = level.time;
+	startedicts = globals.num_edicts;
+	numlive = 0;
+	first = 0;
+
+	start = G_ProfileTime();
+
+	for (i = 0; i < frames; i++)
+	{
+		level.time += FRAMETIME;
+
+		/* free the ones spawned a lifetime ago */
+		if (i >= lifetime)
+		{
+			for (j = 0; j < perframe; j++)
+			{
+				G_FreeEdict(live[first]);
+				first = (first + 1) % 1024;
+				numlive--;
+			}
+		}
+
+		for (j = 0; j < perframe; j++)
+		{
+			live[(first + numlive) % 1024] = G_Spawn();
+			numlive++;
+		}
+	}
+
+	while (numlive)
+	{
+		G_FreeEdict(live[first]);
+		first = (first + 1) % 1024;
+		numlive--;
+	}
+
+	elapsed = G_ProfileTime() - start;
+
+	/* nothing of this was ever sent, but
+	   keep the reuse delay for the real time */
+	level.time = oldtime;
+
+	for (i = maxclients->value + 1; i < globals.num_edicts; i++)
+	{
+		if (!g_edicts[i].inuse && (g_edicts[i].freetime > oldtime))
+		{
+			g_edicts[i].freetime = oldtime;
+		}
+	}
+
+	G_ResetFreeEdicts();
+
+	gi.cprintf(NULL, PRINT_HIGH, "%i spawns in %i usec, %.1f usec per spawn and free, "
+			"num_edicts %i -> %i\n", frames * perframe, (int)elapsed,
+			(float)elapsed / (frames * perframe), startedicts,
+			globals.num_edicts);
+}
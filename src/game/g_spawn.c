@@ -26,6 +26,8 @@
 
 #include "header/local.h"
 
+#define SPAWN_HASHSIZE 512 /* must be a power of two */
+
 typedef struct
 {
 	char *name;
@@ -268,6 +270,67 @@ spawn_t spawns[] = {
 	{NULL, NULL}
 };
 
+/* spawns index + 1 of each name, 0 if empty */
+static int spawn_hash[SPAWN_HASHSIZE];
+
+/*
+ * Returns the slot of the spawn function
+ * with the name, or the free slot it would
+ * go into. Names are case sensitive.
+ */
+static int *
+ED_SpawnSlot(const char *name)
+{
+	unsigned hash;
+	const char *s;
+	int i;
+
+	for (hash = 0, s = name; *s; s++)
+	{
+		hash = hash * 31 + *s;
+	}
+
+	for (i = hash & (SPAWN_HASHSIZE - 1); spawn_hash[i];
+		 i = (i + 1) & (SPAWN_HASHSIZE - 1))
+	{
+		if (!strcmp(spawns[spawn_hash[i] - 1].name, name))
+		{
+			break;
+		}
+	}
+
+	return &spawn_hash[i];
+}
+
+/*
+ * Builds the hash table of the spawn
+ * functions. Called by InitGame.
+ */
+void
+ED_InitSpawns(void)
+{
+	spawn_t *s;
+	int *slot;
+
+	if (sizeof(spawns) / sizeof(spawns[0]) >= SPAWN_HASHSIZE)
+	{
+		gi.error("ED_InitSpawns: too many spawn functions");
+	}
+
+	memset(spawn_hash, 0, sizeof(spawn_hash));
+
+	for (s = spawns; s->name; s++)
+	{
+		slot = ED_SpawnSlot(s->name);
+
+		/* the first one wins */
+		if (!*slot)
+		{
+			*slot = s - spawns + 1;
+		}
+	}
+}
+
 /*
  * Finds the spawn function for
  * the entity and calls it
@@ -275,9 +338,8 @@ spawn_t spawns[] = {
 void
 ED_CallSpawn(edict_t *ent)
 {
-	spawn_t *s;
 	gitem_t *item;
-	int i;
+	int *slot;
 
 	if (!ent)
 	{
@@ -292,30 +354,23 @@ ED_CallSpawn(edict_t *ent)
 	}
 
 	/* check item spawn functions */
-	for (i = 0, item = itemlist; i < game.num_items; i++, item++)
-	{
-		if (!item->classname)
-		{
-			continue;
-		}
+	item = FindItemByClassname(ent->classname);
 
-		if (!strcmp(item->classname, ent->classname))
-		{
-			/* found it */
-			SpawnItem(ent, item);
-			return;
-		}
+	if (item && !strcmp(item->classname, ent->classname))
+	{
+		/* found it */
+		SpawnItem(ent, item);
+		return;
 	}
 
 	/* check normal spawn functions */
-	for (s = spawns; s->name; s++)
+	slot = ED_SpawnSlot(ent->classname);
+
+	if (*slot)
 	{
-		if (!strcmp(s->name, ent->classname))
-		{
-			/* found it */
-			s->spawn(ent);
-			return;
-		}
+		/* found it */
+		spawns[*slot - 1].spawn(ent);
+		return;
 	}
 
 	gi.dprintf("%s doesn't have a spawn function\n", ent->classname);
@@ -611,6 +666,10 @@ SpawnEntities(const char *mapname, char *entities, const char *spawnpoint)
 		g_edicts[i + 1].client = game.clients + i;
 	}
 
+	G_ResetFreeEdicts();
+	G_ResetThinks();
+	G_ResetSight();
+
 	ent = NULL;
 	inhibit = 0;
 
@@ -344,6 +344,18 @@ ServerCommand(void)
 	{
 		SVCmd_WriteIP_f();
 	}
+	else if (Q_stricmp(cmd, "profile") == 0)
+	{
+		Svcmd_Profile_f();
+	}
+	else if (Q_stricmp(cmd, "spawnbench") == 0)
+	{
+		Svcmd_SpawnBench_f();
+	}
+	else if (Q_stricmp(cmd, "sightstats") == 0)
+	{
+		Svcmd_SightStats_f();
+	}
 	else
 	{
 		gi.cprintf(NULL, PRINT_HIGH, "Unknown server command \"%s\"\n", cmd);
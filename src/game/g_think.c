@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 1997-2001 Id Software, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * =======================================================================
+ *
+ * Think scheduler. Most entities on a map don't move and think rarely
+ * or never, G_RunFrame only visits the awake ones. An entity without
+ * physics falls asleep after its frame and is put into a timer wheel
+ * slot for the frame its nextthink becomes due, or nowhere if it has
+ * none. Every entity whose use, touch, pain, die or blocked function
+ * is called is woken up, and so is every newly spawned one. Awake
+ * entities are still run in edict order, so nothing changes for the
+ * game logic.
+ *
+ * =======================================================================
+ */
+
+#include "header/local.h"
+
+#define TH_WHEELSIZE 512 /* must be a power of two */
+
+/* sized for game.maxentities by G_InitThinks */
+static unsigned int *th_awake;
+
+static int th_wheel[TH_WHEELSIZE];
+static int *th_next;
+static int *th_prev;
+static int *th_due; /* -1 if not in the wheel */
+
+static void
+G_UnscheduleEntity(int num)
+{
+	if (th_due[num] < 0)
+	{
+		return;
+	}
+
+	if (th_prev[num] >= 0)
+	{
+		th_next[th_prev[num]] = th_next[num];
+	}
+	else
+	{
+		th_wheel[th_due[num] & (TH_WHEELSIZE - 1)] = th_next[num];
+	}
+
+	if (th_next[num] >= 0)
+	{
+		th_prev[th_next[num]] = th_prev[num];
+	}
+
+	th_due[num] = -1;
+}
+
+static void
+G_ScheduleAt(int num, int frame)
+{
+	int slot;
+
+	slot = frame & (TH_WHEELSIZE - 1);
+
+	th_due[num] = frame;
+	th_prev[num] = -1;
+	th_next[num] = th_wheel[slot];
+
+	if (th_wheel[slot] >= 0)
+	{
+		th_prev[th_wheel[slot]] = num;
+	}
+
+	th_wheel[slot] = num;
+}
+
+/*
+ * Allocates the scheduler for
+ * game.maxentities edicts. Called
+ * whenever the edicts are allocated,
+ * it's freed together with them.
+ */
+void
+G_InitThinks(void)
+{
+	th_awake = gi.TagMalloc(((game.maxentities + 31) / 32) * sizeof(th_awake[0]),
+			TAG_GAME);
+	th_next = gi.TagMalloc(game.maxentities * sizeof(th_next[0]), TAG_GAME);
+	th_prev = gi.TagMalloc(game.maxentities * sizeof(th_prev[0]), TAG_GAME);
+	th_due = gi.TagMalloc(game.maxentities * sizeof(th_due[0]), TAG_GAME);
+}
+
+/*
+ * Wakes up all entities. Called
+ * whenever the edicts were replaced
+ * as a whole, by a new map or a
+ * savegame.
+ */
+void
+G_ResetThinks(void)
+{
+	int i;
+
+	memset(th_awake, 0xff, ((game.maxentities + 31) / 32) * sizeof(th_awake[0]));
+
+	for (i = 0; i < TH_WHEELSIZE; i++)
+	{
+		th_wheel[i] = -1;
+	}
+
+	for (i = 0; i < game.maxentities; i++)
+	{
+		th_due[i] = -1;
+	}
+}
+
+/*
+ * The entity is run again from the
+ * next time G_RunFrame gets to it,
+ * that's still this frame if it
+ * comes after the current one.
+ */
+void
+G_WakeEntity(edict_t *ent)
+{
+	int num;
+
+	if (!ent)
+	{
+		return;
+	}
+
+	num = ent - g_edicts;
+
+	if ((num < 0) || (num >= game.maxentities))
+	{
+		return;
+	}
+
+	G_UnscheduleEntity(num);
+	th_awake[num >> 5] |= 1u << (num & 31);
+}
+
+/*
+ * Called after the entity had its
+ * frame. Puts it to sleep if only
+ * its think function can change it.
+ */
+void
+G_ScheduleEntity(edict_t *ent)
+{
+	int num;
+	int frame;
+
+	num = ent - g_edicts;
+
+	if ((num <= maxclients->value) && (num != 0))
+	{
+		return; /* clients are always run */
+	}
+
+	if (ent->inuse)
+	{
+		if ((ent->movetype != MOVETYPE_NONE) || ent->prethink ||
+			ent->groundentity || (ent->s.renderfx & (RF_BEAM | RF_FRAMELERP)))
+		{
+			return;
+		}
+
+		if (ent->nextthink > 0)
+		{
+			/* SV_RunThink runs it if nextthink <= level.time + 0.001,
+			   an early wakeup just puts it back */
+			frame = (int)((ent->nextthink - 0.001) / FRAMETIME);
+
+			if (frame <= level.framenum)
+			{
+				frame = level.framenum + 1;
+			}
+
+			G_ScheduleAt(num, frame);
+		}
+	}
+
+	th_awake[num >> 5] &= ~(1u << (num & 31));
+}
+
+/*
+ * Wakes up the entities that are due
+ * in this frame. Entities due one
+ * or more turns of the wheel later
+ * stay in their slot.
+ */
+void
+G_RunThinkWheel(void)
+{
+	int num, next;
+
+	num = th_wheel[level.framenum & (TH_WHEELSIZE - 1)];
+
+	while (num >= 0)
+	{
+		next = th_next[num];
+
+		if (th_due[num] <= level.framenum)
+		{
+			G_WakeEntity(&g_edicts[num]);
+		}
+
+		num = next;
+	}
+}
+
+/*
+ * Returns the first awake entity
+ * after num, or -1. Entities can
+ * be woken up while G_RunFrame
+ * loops over them.
+ */
+int
+G_NextAwakeEntity(int num)
+{
+	unsigned int bits;
+	int end;
+
+	end = globals.num_edicts;
+
+	for (num++; num < end; num = (num | 31) + 1)
+	{
+		bits = th_awake[num >> 5] >> (num & 31);
+
+		if (bits)
+		{
+			while (!(bits & 1))
+			{
+				bits >>= 1;
+				num++;
+			}
+
+			return num < end ? num : -1;
+		}
+	}
+
+	return -1;
+}
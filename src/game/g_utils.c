@@ -314,6 +314,7 @@ G_UseTargets(edict_t *ent, edict_t *activator)
 			{
 				if (t->use)
 				{
+					G_WakeEntity(t);
 					t->use(t, ent, activator);
 				}
 			}
@@ -496,6 +497,82 @@ G_InitEdict(edict_t *e)
 	e->classname = "noclass";
 	e->gravity = 1.0;
 	e->s.number = e - g_edicts;
+
+	G_WakeEntity(e);
+}
+
+/*
+ * The free edicts in the order they were
+ * freed, oldest first. Since level.time
+ * never goes back the first one is always
+ * the first to become reusable.
+ */
+static int *g_freeedicts; /* game.maxentities */
+static int g_freehead;
+static int g_freecount;
+
+static void
+G_PushFreeEdict(edict_t *e)
+{
+	if (g_freecount == game.maxentities)
+	{
+		return; /* picked up by G_ResetFreeEdicts */
+	}
+
+	g_freeedicts[(g_freehead + g_freecount) % game.maxentities] = e - g_edicts;
+	g_freecount++;
+}
+
+static int
+G_CompareFreeEdicts(const void *a, const void *b)
+{
+	edict_t *ea, *eb;
+
+	ea = &g_edicts[*(const int *)a];
+	eb = &g_edicts[*(const int *)b];
+
+	if (ea->freetime != eb->freetime)
+	{
+		return ea->freetime < eb->freetime ? -1 : 1;
+	}
+
+	return ea - eb;
+}
+
+/*
+ * Allocates the free list for game.maxentities
+ * edicts, together with the edicts.
+ */
+void
+G_InitFreeEdicts(void)
+{
+	g_freeedicts = gi.TagMalloc(game.maxentities * sizeof(g_freeedicts[0]),
+			TAG_GAME);
+}
+
+/*
+ * Rebuilds the free list from the edicts.
+ * Called whenever they were replaced as a
+ * whole, by a new map or a savegame.
+ */
+void
+G_ResetFreeEdicts(void)
+{
+	int i;
+
+	g_freehead = 0;
+	g_freecount = 0;
+
+	for (i = maxclients->value + 1; i < globals.num_edicts; i++)
+	{
+		if (!g_edicts[i].inuse)
+		{
+			G_PushFreeEdict(&g_edicts[i]);
+		}
+	}
+
+	qsort(g_freeedicts, g_freecount, sizeof(g_freeedicts[0]),
+			G_CompareFreeEdicts);
 }
 
 /*
@@ -510,30 +587,38 @@ G_InitEdict(edict_t *e)
 edict_t *
 G_Spawn(void)
 {
-	int i;
 	edict_t *e;
 
-	e = &g_edicts[(int)maxclients->value + 1];
-
-	for (i = maxclients->value + 1; i < globals.num_edicts; i++, e++)
+	while (g_freecount)
 	{
+		e = &g_edicts[g_freeedicts[g_freehead]];
+
 		/* the first couple seconds of
 		   server time can involve a lot of
 		   freeing and allocating, so relax
 		   the replacement policy */
-		if (!e->inuse && ((e->freetime < 2) || (level.time - e->freetime > 0.5)))
+		if (!e->inuse && (e->freetime >= 2) &&
+			(level.time - e->freetime <= 0.5))
+		{
+			break; /* the oldest is too young, so are all others */
+		}
+
+		g_freehead = (g_freehead + 1) % game.maxentities;
+		g_freecount--;
+
+		if (!e->inuse)
 		{
 			G_InitEdict(e);
 			return e;
 		}
 	}
 
-	if (i == game.maxentities)
+	if (globals.num_edicts == game.maxentities)
 	{
 		gi.error("ED_Alloc: no free edicts");
 	}
 
-	globals.num_edicts++;
+	e = &g_edicts[globals.num_edicts++];
 	G_InitEdict(e);
 	return e;
 }
@@ -544,7 +629,10 @@ G_Spawn(void)
 void
 G_FreeEdict(edict_t *ed)
 {
+	qboolean inuse;
+
 	gi.unlinkentity(ed); /* unlink from world */
+	G_WakeEntity(ed); /* take it out of the think wheel */
 
 	if (deathmatch->value || coop->value)
 	{
@@ -561,10 +649,19 @@ G_FreeEdict(edict_t *ed)
 		}
 	}
 
+	inuse = ed->inuse;
+
 	memset(ed, 0, sizeof(*ed));
 	ed->classname = "freed";
 	ed->freetime = level.time;
 	ed->inuse = false;
+
+	/* freeing twice must not put it
+	   into the free list twice */
+	if (inuse)
+	{
+		G_PushFreeEdict(ed);
+	}
 }
 
 void
@@ -603,6 +700,7 @@ G_TouchTriggers(edict_t *ent)
 			continue;
 		}
 
+		G_WakeEntity(hit);
 		hit->touch(hit, ent, NULL, NULL);
 	}
 }
@@ -640,6 +738,7 @@ G_TouchSolids(edict_t *ent)
 
 		if (ent->touch)
 		{
+			G_WakeEntity(hit);
 			ent->touch(hit, ent, NULL, NULL);
 		}
 
@@ -688,3 +787,59 @@ KillBox(edict_t *ent)
 
 	return true; /* all clear */
 }
+
+/*
+ * gi.TraceBatch for engines that
+ * don't have it, one trace after
+ * the other.
+ */
+void
+G_TraceBatch(tracerequest_t *requests, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		requests[i].trace = gi.trace(requests[i].start, requests[i].mins,
+				requests[i].maxs, requests[i].end, requests[i].passent,
+				requests[i].contentmask);
+	}
+}
+
+/*
+ * Counts links, unlinks and kills. A
+ * trace gives the same result as long
+ * as this doesn't change, the trace
+ * batches are checked against it.
+ */
+unsigned int g_worldchanges;
+
+static void (*wc_linkentity)(edict_t *ent);
+static void (*wc_unlinkentity)(edict_t *ent);
+
+static void
+G_CountLinkEntity(edict_t *ent)
+{
+	g_worldchanges++;
+	wc_linkentity(ent);
+}
+
+static void
+G_CountUnlinkEntity(edict_t *ent)
+{
+	g_worldchanges++;
+	wc_unlinkentity(ent);
+}
+
+/*
+ * Called from GetGameAPI
+ */
+void
+G_WorldChangesInit(void)
+{
+	wc_linkentity = gi.linkentity;
+	gi.linkentity = G_CountLinkEntity;
+
+	wc_unlinkentity = gi.unlinkentity;
+	gi.unlinkentity = G_CountUnlinkEntity;
+}
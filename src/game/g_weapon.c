@@ -1052,17 +1052,107 @@ bfg_touch(edict_t *self, edict_t *other, cplane_t *plane, csurface_t *surf)
 	gi.multicast(self->s.origin, MULTICAST_PVS);
 }
 
+#define MAX_BFG_LASERS 64
+
+static qboolean
+bfg_target(edict_t *self, edict_t *ent)
+{
+	if (ent == self)
+	{
+		return false;
+	}
+
+	if (ent == self->owner)
+	{
+		return false;
+	}
+
+	if (!ent->takedamage)
+	{
+		return false;
+	}
+
+	if (!(ent->svflags & SVF_MONSTER) && (!ent->client) &&
+		(strcmp(ent->classname, "misc_explobox") != 0))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * A laser goes through monsters and players,
+ * tr is its first hop.
+ */
+static void
+bfg_laser(edict_t *self, vec3_t dir, vec3_t end, trace_t tr, int dmg)
+{
+	edict_t *ignore;
+	vec3_t start;
+
+	while (1)
+	{
+		if (!tr.ent)
+		{
+			break;
+		}
+
+		/* hurt it if we can */
+		if ((tr.ent->takedamage) && !(tr.ent->flags & FL_IMMUNE_LASER) &&
+			(tr.ent != self->owner))
+		{
+			T_Damage(tr.ent, self, self->owner, dir, tr.endpos, vec3_origin,
+					dmg, 1, DAMAGE_ENERGY, MOD_BFG_LASER);
+		}
+
+		/* if we hit something that's not a monster or player we're done */
+		if (!(tr.ent->svflags & SVF_MONSTER) && (!tr.ent->client))
+		{
+			gi.WriteByte(svc_temp_entity);
+			gi.WriteByte(TE_LASER_SPARKS);
+			gi.WriteByte(4);
+			gi.WritePosition(tr.endpos);
+			gi.WriteDir(tr.plane.normal);
+			gi.WriteByte(self->s.skinnum);
+			gi.multicast(tr.endpos, MULTICAST_PVS);
+			break;
+		}
+
+		ignore = tr.ent;
+		VectorCopy(tr.endpos, start);
+
+		tr = gi.trace(start, NULL, NULL, end, ignore,
+				CONTENTS_SOLID | CONTENTS_MONSTER | CONTENTS_DEADMONSTER);
+	}
+
+	gi.WriteByte(svc_temp_entity);
+	gi.WriteByte(TE_BFG_LASER);
+	gi.WritePosition(self->s.origin);
+	gi.WritePosition(tr.endpos);
+	gi.multicast(self->s.origin, MULTICAST_PHS);
+}
+
+/*
+ * The first hops of the lasers are traced as
+ * one batch. The lasers still fire one after
+ * the other. Once one of them changed the world
+ * the batch is stale, and the targets after it
+ * are searched and traced again.
+ */
 void
 bfg_think(edict_t *self)
 {
+	tracerequest_t req[MAX_BFG_LASERS];
+	edict_t *targets[MAX_BFG_LASERS];
+	vec3_t dirs[MAX_BFG_LASERS];
+	unsigned int changes;
 	edict_t *ent;
-	edict_t *ignore;
+	edict_t *next;
 	vec3_t point;
-	vec3_t dir;
-	vec3_t start;
-	vec3_t end;
+	int count;
 	int dmg;
-	trace_t tr;
+	int i;
 
 	if (!self)
 	{
@@ -1080,78 +1170,62 @@ bfg_think(edict_t *self)
 
 	ent = NULL;
 
-	while ((ent = findradius(ent, self->s.origin, 256)) != NULL)
+	while (1)
 	{
-		if (ent == self)
-		{
-			continue;
-		}
+		count = 0;
+		next = ent;
 
-		if (ent == self->owner)
+		while ((count < MAX_BFG_LASERS) &&
+			   ((next = findradius(next, self->s.origin, 256)) != NULL))
 		{
-			continue;
-		}
+			if (!bfg_target(self, next))
+			{
+				continue;
+			}
 
-		if (!ent->takedamage)
-		{
-			continue;
+			VectorMA(next->absmin, 0.5, next->size, point);
+
+			VectorSubtract(point, self->s.origin, dirs[count]);
+			VectorNormalize(dirs[count]);
+
+			VectorCopy(self->s.origin, req[count].start);
+			VectorMA(req[count].start, 2048, dirs[count], req[count].end);
+			VectorClear(req[count].mins);
+			VectorClear(req[count].maxs);
+			req[count].passent = self;
+			req[count].contentmask = CONTENTS_SOLID | CONTENTS_MONSTER |
+				CONTENTS_DEADMONSTER;
+
+			targets[count++] = next;
 		}
 
-		if (!(ent->svflags & SVF_MONSTER) && (!ent->client) &&
-			(strcmp(ent->classname, "misc_explobox") != 0))
+		if (!count)
 		{
-			continue;
+			break;
 		}
 
-		VectorMA(ent->absmin, 0.5, ent->size, point);
-
-		VectorSubtract(point, self->s.origin, dir);
-		VectorNormalize(dir);
+		changes = g_worldchanges;
+		gi.TraceBatch(req, count);
 
-		ignore = self;
-		VectorCopy(self->s.origin, start);
-		VectorMA(start, 2048, dir, end);
-
-		while (1)
+		for (i = 0; i < count; i++)
 		{
-			tr = gi.trace(start, NULL, NULL, end, ignore,
-					CONTENTS_SOLID | CONTENTS_MONSTER | CONTENTS_DEADMONSTER);
-
-			if (!tr.ent)
+			if (g_worldchanges != changes)
 			{
 				break;
 			}
 
-			/* hurt it if we can */
-			if ((tr.ent->takedamage) && !(tr.ent->flags & FL_IMMUNE_LASER) &&
-				(tr.ent != self->owner))
-			{
-				T_Damage(tr.ent, self, self->owner, dir, tr.endpos, vec3_origin,
-						dmg, 1, DAMAGE_ENERGY, MOD_BFG_LASER);
-			}
+			ent = targets[i];
 
-			/* if we hit something that's not a monster or player we're done */
-			if (!(tr.ent->svflags & SVF_MONSTER) && (!tr.ent->client))
+			if (bfg_target(self, ent))
 			{
-				gi.WriteByte(svc_temp_entity);
-				gi.WriteByte(TE_LASER_SPARKS);
-				gi.WriteByte(4);
-				gi.WritePosition(tr.endpos);
-				gi.WriteDir(tr.plane.normal);
-				gi.WriteByte(self->s.skinnum);
-				gi.multicast(tr.endpos, MULTICAST_PVS);
-				break;
+				bfg_laser(self, dirs[i], req[i].end, req[i].trace, dmg);
 			}
-
-			ignore = tr.ent;
-			VectorCopy(tr.endpos, start);
 		}
 
-		gi.WriteByte(svc_temp_entity);
-		gi.WriteByte(TE_BFG_LASER);
-		gi.WritePosition(self->s.origin);
-		gi.WritePosition(tr.endpos);
-		gi.multicast(self->s.origin, MULTICAST_PHS);
+		if ((i == count) && !next)
+		{
+			break;
+		}
 	}
 
 	self->nextthink = level.time + FRAMETIME;
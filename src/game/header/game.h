@@ -36,6 +36,13 @@
 
 #define GAME_API_VERSION 3
 
+/* Functions appended to game_import_t after DebugGraph. The
+   engine sets GAME_IMPORTS_CVAR to how many of them it fills
+   in, older engines don't know the cvar and have none. The
+   game must not read them from a shorter structure. */
+#define GAME_IMPORTS_CVAR "sv_gameimports"
+#define GAME_IMPORTS_TRACEBATCH 1
+
 #define SVF_NOCLIENT 0x00000001 /* don't send entity to clients, even if it has effects */
 #define SVF_DEADMONSTER 0x00000002 /* treat as CONTENTS_DEADMONSTER for collision */
 #define SVF_MONSTER 0x00000004 /* treat as CONTENTS_MONSTER for collision */
@@ -101,6 +108,18 @@ struct edict_s
 
 /* =============================================================== */
 
+/* one trace of a batch, see TraceBatch */
+typedef struct
+{
+	vec3_t start;
+	vec3_t mins, maxs;
+	vec3_t end;
+	edict_t *passent;
+	int contentmask;
+
+	trace_t trace;              /* filled in by the server */
+} tracerequest_t;
+
 /* functions provided by the main engine */
 typedef struct
 {
@@ -181,6 +200,11 @@ typedef struct
 	void (*AddCommandString)(char *text);
 
 	void (*DebugGraph)(float value, int color);
+
+	/* resolves count independent traces at once, possibly in
+	   parallel. Same result as calling trace for each of them.
+	   Since GAME_IMPORTS_TRACEBATCH */
+	void (*TraceBatch)(tracerequest_t *requests, int count);
 } game_import_t;
 
 /* functions exported by the game subsystem */
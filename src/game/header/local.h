@@ -481,6 +481,7 @@ extern int snd_fry;
 extern int meansOfDeath;
 
 extern edict_t *g_edicts;
+extern unsigned int g_worldchanges;
 
 #define FOFS(x) (size_t)&(((edict_t *)NULL)->x)
 #define STOFS(x) (size_t)&(((spawn_temp_t *)NULL)->x)
@@ -528,6 +529,8 @@ extern cvar_t *flood_waitdelay;
 
 extern cvar_t *sv_maplist;
 
+extern cvar_t *sv_profile;
+
 #define world (&g_edicts[0])
 
 /* item spawnflags */
@@ -595,6 +598,9 @@ gitem_t *GetItemByIndex(int index);
 qboolean Add_Ammo(edict_t *ent, gitem_t *item, int count);
 void Touch_Item(edict_t *ent, edict_t *other, cplane_t *plane, csurface_t *surf);
 
+/* g_spawn.c */
+void ED_InitSpawns(void);
+
 /* g_utils.c */
 qboolean KillBox(edict_t *ent);
 void G_ProjectSource(vec3_t point, vec3_t distance, vec3_t forward,
@@ -608,9 +614,13 @@ void G_SetMovedir(vec3_t angles, vec3_t movedir);
 void G_InitEdict(edict_t *e);
 edict_t *G_Spawn(void);
 void G_FreeEdict(edict_t *e);
+void G_InitFreeEdicts(void);
+void G_ResetFreeEdicts(void);
 
 void G_TouchTriggers(edict_t *ent);
 void G_TouchSolids(edict_t *ent);
+void G_TraceBatch(tracerequest_t *requests, int count);
+void G_WorldChangesInit(void);
 
 char *G_CopyString(char *in);
 
@@ -683,6 +693,9 @@ void BecomeExplosion1(edict_t *self);
 
 /* g_ai.c */
 void AI_SetSightClient(void);
+void G_SightInit(void);
+void G_ResetSight(void);
+void Svcmd_SightStats_f(void);
 
 void ai_stand(edict_t *self, float dist);
 void ai_move(edict_t *self, float dist);
@@ -765,6 +778,33 @@ void M_ChangeYaw(edict_t *ent);
 /* g_phys.c */
 void G_RunEntity(edict_t *ent);
 
+/* g_profile.c */
+typedef enum
+{
+	GP_PHYSICS,
+	GP_THINK,
+	GP_CLIENTS,
+	GP_OTHER,
+	GP_NUMPHASES
+} gp_phase_t;
+
+void G_ProfileBeginFrame(void);
+void G_ProfileInit(void);
+void G_ProfilePush(int phase, edict_t *ent);
+void G_ProfilePop(void);
+void G_ProfilePushChecks(int count);
+void G_ProfileEndFrame(void);
+void Svcmd_Profile_f(void);
+void Svcmd_SpawnBench_f(void);
+
+/* g_think.c */
+void G_InitThinks(void);
+void G_ResetThinks(void);
+void G_WakeEntity(edict_t *ent);
+void G_ScheduleEntity(edict_t *ent);
+void G_RunThinkWheel(void);
+int G_NextAwakeEntity(int num);
+
 /* g_main.c */
 void SaveClientData(void);
 void FetchClientEntData(edict_t *ent);
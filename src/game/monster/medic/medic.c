@@ -853,6 +853,7 @@ medic_cable_attack(edict_t *self)
 
 		if (self->enemy->think)
 		{
+			G_WakeEntity(self->enemy);
 			self->enemy->nextthink = level.time;
 			self->enemy->think(self->enemy);
 		}
@@ -2360,6 +2360,7 @@ ClientThink(edict_t *ent, usercmd_t *ucmd)
 				continue;
 			}
 
+			G_WakeEntity(other);
 			other->touch(other, ent, NULL, NULL);
 		}
 	}
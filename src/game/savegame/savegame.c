@@ -237,12 +237,18 @@ InitGame(void)
 	flood_persecond = gi.cvar("flood_persecond", "4", 0);
 	flood_waitdelay = gi.cvar("flood_waitdelay", "10", 0);
 
+	/* profiling, owned by the server */
+	sv_profile = gi.cvar("sv_profile", "0", 0);
+
 	/* dm map list */
 	sv_maplist = gi.cvar("sv_maplist", "", 0);
 
 	/* items */
 	InitItems();
 
+	/* spawn functions */
+	ED_InitSpawns();
+
 	Com_sprintf(game.helpmessage1, sizeof(game.helpmessage1), "");
 	Com_sprintf(game.helpmessage2, sizeof(game.helpmessage2), "");
 
@@ -251,11 +257,16 @@ InitGame(void)
 	g_edicts = gi.TagMalloc(game.maxentities * sizeof(g_edicts[0]), TAG_GAME);
 	globals.edicts = g_edicts;
 	globals.max_edicts = game.maxentities;
+	G_InitFreeEdicts();
+	G_InitThinks();
 
 	/* initialize all clients for this game */
 	game.maxclients = maxclients->value;
 	game.clients = gi.TagMalloc(game.maxclients * sizeof(game.clients[0]), TAG_GAME);
 	globals.num_edicts = game.maxclients + 1;
+	G_ResetFreeEdicts();
+	G_ResetThinks();
+	G_ResetSight();
 }
 
 /* ========================================================= */
@@ -841,10 +852,15 @@ ReadGame(const char *filename)
 		gi.error("Savegame from an other architecure.\n");
 	}
 
+	fread(&game, sizeof(game), 1, f);
+
+	/* sized for the maxentities of the savegame */
 	g_edicts = gi.TagMalloc(game.maxentities * sizeof(g_edicts[0]), TAG_GAME);
 	globals.edicts = g_edicts;
+	globals.max_edicts = game.maxentities;
+	G_InitFreeEdicts();
+	G_InitThinks();
 
-	fread(&game, sizeof(game), 1, f);
 	game.clients = gi.TagMalloc(game.maxclients * sizeof(game.clients[0]),
 			TAG_GAME);
 
@@ -1076,6 +1092,10 @@ ReadLevel(const char *filename)
 
 	fclose(f);
 
+	G_ResetFreeEdicts();
+	G_ResetThinks();
+	G_ResetSight();
+
 	/* mark all clients as unconnected */
 	for (i = 0; i < maxclients->value; i++)
 	{
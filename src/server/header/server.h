@@ -54,6 +54,14 @@ typedef enum
 	ss_pic
 } server_state_t;
 
+/* where a client is, for SV_Multicast */
+typedef struct
+{
+	int cluster;
+	int area;
+	struct client_s *client;
+} clientcluster_t;
+
 typedef struct
 {
 	server_state_t state;           /* precache commands are only valid during load */
@@ -70,11 +78,29 @@ typedef struct
 	char configstrings [ MAX_CONFIGSTRINGS ] [ MAX_QPATH ];
 	entity_state_t baselines [ MAX_EDICTS ];
 
+	/* every configstring change after loading bumps
+	   csgeneration and stamps the string with it */
+	int csgeneration;
+	int csversion [ MAX_CONFIGSTRINGS ];
+
+	/* the configstrings and baselines as one zlib
+	   compressed blob for fast connecting clients */
+	byte            *gamestate;
+	int gamestatesize;                  /* compressed */
+	int gamestatelength;                /* uncompressed */
+	int gamestategeneration;            /* csgeneration it was built at */
+
 	/* the multicast buffer is used to send a message to a set of clients
 	   it is only used to marshall data until SV_Multicast is called */
 	sizebuf_t multicast;
 	byte multicast_buf [ MAX_MSGLEN ];
 
+	/* the connected clients sorted by cluster, rebuilt on the
+	   first multicast of a frame or after one of them was linked */
+	qboolean clusters_valid;
+	int num_clientclusters;
+	clientcluster_t clientclusters [ MAX_CLIENTS ];
+
 	/* demo server information */
 	FILE        *demofile;
 	qboolean timedemo; /* don't time sync */
@@ -95,7 +121,8 @@ typedef struct
 	byte areabits [ MAX_MAP_AREAS / 8 ];    /* portalarea visibility bits */
 	player_state_t ps;
 	int num_entities;
-	int first_entity;                       /* into the circular sv_packet_entities[] */
+	int first_entity;                       /* into the circular svs.client_entities[] */
+	int snapshot;                           /* svs.snapshots[] the indexes point into */
 	int senttime;                           /* for ping calculations */
 } client_frame_t;
 
@@ -132,9 +159,24 @@ typedef struct client_s
 	byte            *download;          /* file being downloaded */
 	int downloadsize;                   /* total bytes (can't use EOF because of paks) */
 	int downloadcount;                  /* bytes sent */
+	int downloadacked;                  /* bytes the client has, when streaming */
+	int downloadrate;                   /* bytes/s when streaming, 0 for one block per nextdl */
+	int downloadid;                     /* the client's tag for the blocks */
+	int downloadtime;                   /* curtime of the last progress */
+	int downloadretries;                /* go backs since then */
+	int downloadresent;                 /* end of the lost blocks sent again */
+	int downloadresenttime;
+	int downloadcache;                  /* slot in the download cache, -1 for none */
 
 	int lastmessage;                    /* sv.framenum when packet was last received */
 	int lastconnect;
+	int connecttime;                    /* Sys_Milliseconds() of connect or new */
+
+	qboolean fastconnect;               /* gets the gamestate as one blob */
+	qboolean recording;                 /* limited to MAX_MSGLEN by "msglen" */
+	qboolean gamestatesending;
+	int gamestatecount;                 /* bytes of sv.gamestate sent */
+	int gamestatecs;                    /* next configstring to check after it */
 
 	int challenge;                      /* challenge of this user, randomly generated */
 
@@ -148,6 +190,20 @@ typedef struct
 	int time;
 } challenge_t;
 
+/* the entity states of one server frame, shared by all clients.
+   client frames only keep indexes into it */
+typedef struct
+{
+	int framenum;
+	int spawncount;
+	int num_entities;
+	entity_state_t  *entities;          /* [ge->max_edicts], sorted by number */
+} snapshot_t;
+
+/* set in a client_entities index if the entity
+   is owned by the client and must not be solid */
+#define SNAP_NOTSOLID 0x8000
+
 typedef struct
 {
 	qboolean initialized;               /* sv_init has completed */
@@ -161,7 +217,8 @@ typedef struct
 	client_t    *clients;               /* [maxclients->value]; */
 	int num_client_entities;            /* maxclients->value*UPDATE_BACKUP*MAX_PACKET_ENTITIES */
 	int next_client_entities;           /* next client_entity to use */
-	entity_state_t  *client_entities;   /* [num_client_entities] */
+	unsigned short  *client_entities;   /* [num_client_entities], into snapshots[] */
+	snapshot_t snapshots [ UPDATE_BACKUP ];
 
 	int last_heartbeat;
 
@@ -187,6 +244,16 @@ extern cvar_t      *sv_noreload;            /* don't reload level state when ree
 extern cvar_t      *sv_airaccelerate;       /* don't reload level state when reentering */
 											/* development tool */
 extern cvar_t      *sv_enforcetime;
+extern cvar_t      *sv_reconnect_limit;
+extern cvar_t      *sv_querylimit;
+extern cvar_t      *sv_querylimit_total;
+
+extern int sv_statusbuilds;
+extern int sv_statusreuses;
+
+extern cvar_t      *sv_profile;
+extern cvar_t      *sv_paralleltraces;
+extern cvar_t      *sv_downloadrate;
 
 extern client_t    *sv_client;
 extern edict_t     *sv_player;
@@ -202,6 +269,28 @@ void SV_WriteClientdataToMessage ( client_t *client, sizebuf_t *msg );
 
 void SV_ExecuteUserCommand ( char *s );
 void SV_InitOperatorCommands ( void );
+void SV_QueryStats_f ( void );
+
+typedef enum
+{
+	SVP_PACKETS,
+	SVP_GAME,
+	SVP_SEND,
+	SVP_DEMO,
+	SVP_OTHER,
+	SVP_NUMPHASES
+} svp_phase_t;
+
+void SV_InitProfile ( void );
+void SV_ProfileBegin ( void );
+void SV_ProfileMark ( int phase );
+void SV_ProfileEnd ( void );
+
+void SV_InitJournal ( void );
+void SV_JournalStart ( qboolean attractloop, char *levelstring, qboolean loadgame );
+qboolean SV_JournalFrame ( int *msec );
+qboolean SV_JournalGetPacket ( netadr_t *from, sizebuf_t *message );
+void SV_JournalStop ( void );
 
 void SV_SendServerinfo ( client_t *client );
 void SV_UserinfoChanged ( client_t *cl );
@@ -222,6 +311,7 @@ void SV_FlushRedirect ( int sv_redirected, char *outputbuf );
 
 void SV_DemoCompleted ( void );
 void SV_SendClientMessages ( void );
+int SV_RateLeft ( client_t *c, int rate );
 
 void SV_Multicast ( vec3_t origin, multicast_t to );
 void SV_StartSound ( vec3_t origin, edict_t *entity, int channel, int soundindex, float volume, float attenuation, float timeofs );
@@ -231,6 +321,12 @@ void SV_BroadcastCommand ( char *fmt, ... );
 
 void SV_Nextserver ( void );
 void SV_ExecuteClientMessage ( client_t *cl );
+void SV_SendGamestate ( client_t *cl );
+void SV_ClearGamestate ( void );
+void SV_JoinStats_f ( void );
+void SV_SendDownload ( client_t *cl );
+void SV_CloseDownload ( client_t *cl );
+void SV_FlushDownloads ( qboolean all );
 
 void SV_ReadLevelFile ( void );
 void SV_Status_f ( void );
@@ -274,5 +370,6 @@ int SV_AreaEdicts ( vec3_t mins, vec3_t maxs, edict_t **list, int maxcount, int
 int SV_PointContents ( vec3_t p );
 
 trace_t SV_Trace ( vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t *passedict, int contentmask );
+void SV_TraceBatch ( tracerequest_t *requests, int count );
 
 #endif
@@ -617,6 +617,8 @@ SV_InitOperatorCommands ( void )
 	Cmd_AddCommand( "status", SV_Status_f );
 	Cmd_AddCommand( "serverinfo", SV_Serverinfo_f );
 	Cmd_AddCommand( "dumpuser", SV_DumpUser_f );
+	Cmd_AddCommand( "querystats", SV_QueryStats_f );
+	Cmd_AddCommand( "joinstats", SV_JoinStats_f );
 
 	Cmd_AddCommand( "map", SV_Map_f );
 	Cmd_AddCommand( "demomap", SV_DemoMap_f );
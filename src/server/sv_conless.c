@@ -30,6 +30,26 @@ extern cvar_t  *hostname;
 extern cvar_t  *rcon_password;
 
 cvar_t  *sv_reconnect_limit;    /* minimum seconds between connect messages */
+cvar_t  *sv_querylimit;         /* queries per second from one address */
+cvar_t  *sv_querylimit_total;   /* status and info replies per second */
+
+#define QUERY_ADDRESS 1         /* limited by sv_querylimit */
+#define QUERY_TOTAL 2           /* limited by sv_querylimit_total */
+
+#define QUERY_HASHSIZE 1024     /* must be a power of two */
+#define QUERY_PROBES 4
+
+/* the time the next query of an address is due,
+   a query may come up to a second early */
+typedef struct
+{
+	netadr_t adr;
+	int next;
+} querybucket_t;
+
+static querybucket_t sv_querybuckets [ QUERY_HASHSIZE ];
+static int sv_querynext;        /* for all addresses together */
+static char *sv_queryline;
 
 char * SV_StatusString ( void );
 
@@ -158,6 +178,7 @@ SVC_DirectConnect ( void )
 	int version;
 	int qport;
 	int challenge;
+	qboolean fastconnect, fragments;
 
 	adr = net_from;
 
@@ -179,6 +200,22 @@ SVC_DirectConnect ( void )
 	strncpy( userinfo, Cmd_Argv( 4 ), sizeof ( userinfo ) - 1 );
 	userinfo [ sizeof ( userinfo ) - 1 ] = 0;
 
+	/* newer clients can take the gamestate in one
+	   piece and messages split into fragments */
+	fastconnect = fragments = false;
+
+	for ( i = 5; i < Cmd_Argc(); i++ )
+	{
+		if ( !strcmp( Cmd_Argv( i ), "fast" ) )
+		{
+			fastconnect = true;
+		}
+		else if ( !strcmp( Cmd_Argv( i ), "frag" ) )
+		{
+			fragments = true;
+		}
+	}
+
 	/* force the IP key/value pair so the game can filter based on ip */
 	Info_SetValueForKey( userinfo, "ip", NET_AdrToString( net_from ) );
 
@@ -267,6 +304,7 @@ gotnewcl:
 	/* build a new connection
 	   accept the new client
 	   this is the only place a client_t is ever initialized */
+	SV_CloseDownload( newcl );
 	*newcl = temp;
 	sv_client = newcl;
 	edictnum = ( newcl - svs.clients ) + 1;
@@ -296,16 +334,24 @@ gotnewcl:
 	SV_UserinfoChanged( newcl );
 
 	/* send the connect packet to the client */
-	Netchan_OutOfBandPrint( NS_SERVER, adr, "client_connect" );
+	Netchan_OutOfBandPrint( NS_SERVER, adr, fragments ? "client_connect frag" : "client_connect" );
 
 	Netchan_Setup( NS_SERVER, &newcl->netchan, adr, qport );
 
+	if ( fragments )
+	{
+		Netchan_EnableFragments( &newcl->netchan );
+	}
+
 	newcl->state = cs_connected;
+	sv.clusters_valid = false;
 
 	SZ_Init( &newcl->datagram, newcl->datagram_buf, sizeof ( newcl->datagram_buf ) );
 	newcl->datagram.allowoverflow = true;
 	newcl->lastmessage = svs.realtime;  /* don't timeout */
 	newcl->lastconnect = svs.realtime;
+	newcl->connecttime = Sys_Milliseconds();
+	newcl->fastconnect = fastconnect;
 }
 
 int
@@ -368,6 +414,133 @@ SVC_RemoteCommand ( void )
 	Com_EndRedirect();
 }
 
+void
+SVC_BadPacket ( void )
+{
+	Com_Printf( "bad connectionless packet from %s:\n%s\n",
+			NET_AdrToString( net_from ), sv_queryline );
+}
+
+/*
+ * getchallenge and connect aren't limited, the
+ * challenges already protect them and many
+ * clients can share an address.
+ */
+static struct
+{
+	char    *name;
+	void ( *func )( void );
+	int limits;
+	int received;
+	int dropped;
+} sv_queries[] = {
+	{ "ping", SVC_Ping, QUERY_ADDRESS },
+	{ "ack", SVC_Ack, QUERY_ADDRESS },
+	{ "status", SVC_Status, QUERY_ADDRESS | QUERY_TOTAL },
+	{ "info", SVC_Info, QUERY_ADDRESS | QUERY_TOTAL },
+	{ "getchallenge", SVC_GetChallenge, 0 },
+	{ "connect", SVC_DirectConnect, 0 },
+	{ "rcon", SVC_RemoteCommand, QUERY_ADDRESS },
+	{ NULL, SVC_BadPacket, QUERY_ADDRESS } /* everything else */
+};
+
+/*
+ * Token bucket with room for limit queries
+ * that is refilled with limit queries per
+ * second. Kept as the time the next query
+ * is due, it may come up to a second early.
+ */
+static qboolean
+SV_QueryAllowed ( int *next, int limit )
+{
+	int interval;
+
+	if ( limit <= 0 )
+	{
+		return ( true );
+	}
+
+	interval = limit < 1000 ? 1000 / limit : 1;
+
+	if ( *next - curtime > 1000 - interval )
+	{
+		return ( false );
+	}
+
+	if ( *next - curtime < 0 )
+	{
+		*next = curtime;
+	}
+
+	*next += interval;
+
+	return ( true );
+}
+
+/*
+ * Finds the bucket of an address. If it has
+ * none the one that was idle the longest is
+ * taken over.
+ */
+static int *
+SV_QueryBucket ( netadr_t adr )
+{
+	querybucket_t *bucket, *oldest;
+	unsigned int hash;
+	int i, len;
+
+	len = adr.type == NA_IP6 ? 16 : 4;
+
+	for ( hash = 0, i = 0; i < len; i++ )
+	{
+		hash = hash * 31 + adr.ip [ i ];
+	}
+
+	oldest = NULL;
+
+	for ( i = 0; i < QUERY_PROBES; i++ )
+	{
+		bucket = &sv_querybuckets [ ( hash + i ) & ( QUERY_HASHSIZE - 1 ) ];
+
+		if ( NET_CompareBaseAdr( adr, bucket->adr ) )
+		{
+			return ( &bucket->next );
+		}
+
+		if ( !oldest || ( bucket->next - oldest->next < 0 ) )
+		{
+			oldest = bucket;
+		}
+	}
+
+	oldest->adr = adr;
+	oldest->next = curtime;
+
+	return ( &oldest->next );
+}
+
+void
+SV_QueryStats_f ( void )
+{
+	int i;
+
+	Com_Printf( "%-14s %10s %10s\n", "query", "received", "dropped" );
+
+	for ( i = 0; ; i++ )
+	{
+		Com_Printf( "%-14s %10i %10i\n", sv_queries [ i ].name ? sv_queries [ i ].name : "other",
+				sv_queries [ i ].received, sv_queries [ i ].dropped );
+
+		if ( !sv_queries [ i ].name )
+		{
+			break;
+		}
+	}
+
+	Com_Printf( "status string built %i times, reused %i times\n",
+			sv_statusbuilds, sv_statusreuses );
+}
+
 /*
  * A connectionless packet has four leading 0xff
  * characters to distinguish it from a game channel.
@@ -379,48 +552,46 @@ SV_ConnectionlessPacket ( void )
 {
 	char    *s;
 	char    *c;
+	int i;
 
 	MSG_BeginReading( &net_message );
 	MSG_ReadLong( &net_message ); /* skip the -1 marker */
 
 	s = MSG_ReadStringLine( &net_message );
+	sv_queryline = s;
 
 	Cmd_TokenizeString( s, false );
 
 	c = Cmd_Argv( 0 );
 	Com_DPrintf( "Packet %s : %s\n", NET_AdrToString( net_from ), c );
 
-	if ( !strcmp( c, "ping" ) )
+	for ( i = 0; sv_queries [ i ].name; i++ )
 	{
-		SVC_Ping();
-	}
-	else if ( !strcmp( c, "ack" ) )
-	{
-		SVC_Ack();
-	}
-	else if ( !strcmp( c, "status" ) )
-	{
-		SVC_Status();
-	}
-	else if ( !strcmp( c, "info" ) )
-	{
-		SVC_Info();
-	}
-	else if ( !strcmp( c, "getchallenge" ) )
-	{
-		SVC_GetChallenge();
-	}
-	else if ( !strcmp( c, "connect" ) )
-	{
-		SVC_DirectConnect();
-	}
-	else if ( !strcmp( c, "rcon" ) )
-	{
-		SVC_RemoteCommand();
+		if ( !strcmp( c, sv_queries [ i ].name ) )
+		{
+			break;
+		}
 	}
-	else
+
+	sv_queries [ i ].received++;
+
+	/* floods must not eat into the frame */
+	if ( net_from.type != NA_LOOPBACK )
 	{
-		Com_Printf( "bad connectionless packet from %s:\n%s\n",
-				NET_AdrToString( net_from ), s );
+		if ( ( sv_queries [ i ].limits & QUERY_ADDRESS ) &&
+			 !SV_QueryAllowed( SV_QueryBucket( net_from ), (int) sv_querylimit->value ) )
+		{
+			sv_queries [ i ].dropped++;
+			return;
+		}
+
+		if ( ( sv_queries [ i ].limits & QUERY_TOTAL ) &&
+			 !SV_QueryAllowed( &sv_querynext, (int) sv_querylimit_total->value ) )
+		{
+			sv_queries [ i ].dropped++;
+			return;
+		}
 	}
+
+	sv_queries [ i ].func();
 }
@@ -30,6 +30,31 @@
 
 byte fatpvs [ 65536 / 8 ];
 
+/*
+ * Returns the index'th entity of a client frame. Entities
+ * owned by the client are copied to state with solid cleared.
+ */
+static entity_state_t *
+SV_FrameEntity ( client_frame_t *frame, int index, entity_state_t *state )
+{
+	int i;
+	entity_state_t *ent;
+
+	i = svs.client_entities [ ( frame->first_entity + index ) % svs.num_client_entities ];
+	ent = &svs.snapshots [ frame->snapshot ].entities [ i & ~SNAP_NOTSOLID ];
+
+	if ( !( i & SNAP_NOTSOLID ) )
+	{
+		return ( ent );
+	}
+
+	/* don't mark players missiles as solid */
+	*state = *ent;
+	state->solid = 0;
+
+	return ( state );
+}
+
 /*
  * Writes a delta update of an entity_state_t list to the message.
  */
@@ -37,6 +62,7 @@ void
 SV_EmitPacketEntities ( client_frame_t *from, client_frame_t *to, sizebuf_t *msg )
 {
 	entity_state_t  *oldent, *newent;
+	entity_state_t oldstate, newstate;
 	int oldindex, newindex;
 	int oldnum, newnum;
 	int from_num_entities;
@@ -60,7 +86,7 @@ SV_EmitPacketEntities ( client_frame_t *from, client_frame_t *to, sizebuf_t *msg
 
 	while ( newindex < to->num_entities || oldindex < from_num_entities )
 	{
-		if ( msg->cursize > MAX_MSGLEN - 150 )
+		if ( msg->cursize > msg->maxsize - 150 )
 		{
 			break;
 		}
@@ -71,7 +97,7 @@ SV_EmitPacketEntities ( client_frame_t *from, client_frame_t *to, sizebuf_t *msg
 		}
 		else
 		{
-			newent = &svs.client_entities [ ( to->first_entity + newindex ) % svs.num_client_entities ];
+			newent = SV_FrameEntity( to, newindex, &newstate );
 			newnum = newent->number;
 		}
 
@@ -81,7 +107,7 @@ SV_EmitPacketEntities ( client_frame_t *from, client_frame_t *to, sizebuf_t *msg
 		}
 		else
 		{
-			oldent = &svs.client_entities [ ( from->first_entity + oldindex ) % svs.num_client_entities ];
+			oldent = SV_FrameEntity( from, oldindex, &oldstate );
 			oldnum = oldent->number;
 		}
 
@@ -481,6 +507,58 @@ SV_FatPVS ( vec3_t org )
 	}
 }
 
+/*
+ * Copies the state of every entity that could be sent
+ * to someone into the snapshot of the current frame.
+ * Done once per frame, all clients share it.
+ */
+static snapshot_t *
+SV_BuildSnapshot ( void )
+{
+	int e;
+	edict_t *ent;
+	snapshot_t *snap;
+
+	snap = &svs.snapshots [ sv.framenum & UPDATE_MASK ];
+
+	if ( ( snap->framenum == sv.framenum ) && ( snap->spawncount == svs.spawncount ) )
+	{
+		return ( snap ); /* already built for this frame */
+	}
+
+	snap->framenum = sv.framenum;
+	snap->spawncount = svs.spawncount;
+	snap->num_entities = 0;
+
+	for ( e = 1; e < ge->num_edicts; e++ )
+	{
+		ent = EDICT_NUM( e );
+
+		/* ignore ents without visible models */
+		if ( ent->svflags & SVF_NOCLIENT )
+		{
+			continue;
+		}
+
+		/* ignore ents without visible models unless they have an effect */
+		if ( !ent->s.modelindex && !ent->s.effects && !ent->s.sound &&
+			 !ent->s.event )
+		{
+			continue;
+		}
+
+		if ( ent->s.number != e )
+		{
+			Com_DPrintf( "FIXING ENT->S.NUMBER!!!\n" );
+			ent->s.number = e;
+		}
+
+		snap->entities [ snap->num_entities++ ] = ent->s;
+	}
+
+	return ( snap );
+}
+
 /*
  * Decides which entities are going to be visible to the client, and
  * copies off the playerstat and areabits.
@@ -493,7 +571,8 @@ SV_BuildClientFrame ( client_t *client )
 	edict_t *ent;
 	edict_t *clent;
 	client_frame_t  *frame;
-	entity_state_t  *state;
+	snapshot_t      *snap;
+	int index;
 	int l;
 	int clientarea, clientcluster;
 	int leafnum;
@@ -503,14 +582,15 @@ SV_BuildClientFrame ( client_t *client )
 
 	clent = client->edict;
 
+	/* this is the frame we are creating */
+	frame = &client->frames [ sv.framenum & UPDATE_MASK ];
+
 	if ( !clent->client )
 	{
+		frame->num_entities = 0;
 		return; /* not in game yet */
 	}
 
-	/* this is the frame we are creating */
-	frame = &client->frames [ sv.framenum & UPDATE_MASK ];
-
 	frame->senttime = svs.realtime; /* save it for ping calc later */
 
 	/* find the client's PVS */
@@ -533,27 +613,17 @@ SV_BuildClientFrame ( client_t *client )
 	clientphs = CM_ClusterPHS( clientcluster );
 
 	/* build up the list of visible entities */
+	snap = SV_BuildSnapshot();
+
 	frame->num_entities = 0;
 	frame->first_entity = svs.next_client_entities;
+	frame->snapshot = sv.framenum & UPDATE_MASK;
 
 	c_fullsend = 0;
 
-	for ( e = 1; e < ge->num_edicts; e++ )
+	for ( e = 0; e < snap->num_entities; e++ )
 	{
-		ent = EDICT_NUM( e );
-
-		/* ignore ents without visible models */
-		if ( ent->svflags & SVF_NOCLIENT )
-		{
-			continue;
-		}
-
-		/* ignore ents without visible models unless they have an effect */
-		if ( !ent->s.modelindex && !ent->s.effects && !ent->s.sound &&
-			 !ent->s.event )
-		{
-			continue;
-		}
+		ent = EDICT_NUM( snap->entities [ e ].number );
 
 		/* ignore if not touching a PV leaf */
 		if ( ent != clent )
@@ -630,23 +700,16 @@ SV_BuildClientFrame ( client_t *client )
 			}
 		}
 
-		/* add it to the circular client_entities array */
-		state = &svs.client_entities [ svs.next_client_entities % svs.num_client_entities ];
-
-		if ( ent->s.number != e )
-		{
-			Com_DPrintf( "FIXING ENT->S.NUMBER!!!\n" );
-			ent->s.number = e;
-		}
-
-		*state = ent->s;
+		/* add its index to the circular client_entities array */
+		index = e;
 
 		/* don't mark players missiles as solid */
 		if ( ent->owner == client->edict )
 		{
-			state->solid = 0;
+			index |= SNAP_NOTSOLID;
 		}
 
+		svs.client_entities [ svs.next_client_entities % svs.num_client_entities ] = index;
 		svs.next_client_entities++;
 		frame->num_entities++;
 	}
@@ -200,6 +200,7 @@ PF_Configstring ( int index, char *val )
 
 	/* change the string in sv */
 	strcpy( sv.configstrings [ index ], val );
+	sv.csversion [ index ] = ++sv.csgeneration;
 
 	if ( sv.state != ss_loading )
 	{
@@ -298,6 +299,23 @@ PF_inPHS ( vec3_t p1, vec3_t p2 )
 	return ( true );
 }
 
+/*
+ * Player movement done by the game, the
+ * traces are counted separately
+ */
+void
+PF_Pmove ( pmove_t *pm )
+{
+	int caller;
+
+	caller = trace_caller;
+	trace_caller = TRACE_PMOVE;
+
+	Pmove( pm );
+
+	trace_caller = caller;
+}
+
 void
 PF_StartSound ( edict_t *entity, int channel, int sound_num, float volume, float attenuation, float timeofs )
 {
@@ -360,11 +378,12 @@ SV_InitGameProgs ( void )
 	import.unlinkentity = SV_UnlinkEdict;
 	import.BoxEdicts = SV_AreaEdicts;
 	import.trace = SV_Trace;
+	import.TraceBatch = SV_TraceBatch;
 	import.pointcontents = SV_PointContents;
 	import.setmodel = PF_setmodel;
 	import.inPVS = PF_inPVS;
 	import.inPHS = PF_inPHS;
-	import.Pmove = Pmove;
+	import.Pmove = PF_Pmove;
 
 	import.modelindex = SV_ModelIndex;
 	import.soundindex = SV_SoundIndex;
@@ -404,6 +423,9 @@ SV_InitGameProgs ( void )
 	import.SetAreaPortalState = CM_SetAreaPortalState;
 	import.AreasConnected = CM_AreasConnected;
 
+	/* tell the game which of the appended functions are there */
+	Cvar_FullSet( GAME_IMPORTS_CVAR, va( "%i", GAME_IMPORTS_TRACEBATCH ), CVAR_NOSET );
+
 	ge = (game_export_t *) Sys_GetGameAPI( &import );
 
 	if ( !ge )
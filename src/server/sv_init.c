@@ -58,6 +58,7 @@ SV_FindIndex ( char *name, int start, int max, qboolean create )
 	}
 
 	strncpy( sv.configstrings [ start + i ], name, sizeof ( sv.configstrings [ i ] ) );
+	sv.csversion [ start + i ] = ++sv.csgeneration;
 
 	if ( sv.state != ss_loading )
 	{
@@ -201,6 +202,9 @@ SV_SpawnServer ( char *server, char *spawnpoint, server_state_t serverstate, qbo
 	sv.state = ss_dead;
 	Com_SetServerState( sv.state );
 
+	SV_ClearGamestate();
+	SV_FlushDownloads( false );
+
 	/* wipe the entire per-level structure */
 	memset( &sv, 0, sizeof ( sv ) );
 	svs.realtime = 0;
@@ -235,6 +239,8 @@ SV_SpawnServer ( char *server, char *spawnpoint, server_state_t serverstate, qbo
 		}
 
 		svs.clients [ i ].lastframe = -1;
+		svs.clients [ i ].gamestatesending = false;
+		svs.clients [ i ].connecttime = 0;
 	}
 
 	sv.time = 1000;
@@ -373,7 +379,7 @@ SV_InitGame ( void )
 	svs.spawncount = rand();
 	svs.clients = Z_Malloc( sizeof ( client_t ) * maxclients->value );
 	svs.num_client_entities = maxclients->value * UPDATE_BACKUP * 64;
-	svs.client_entities = Z_Malloc( sizeof ( entity_state_t ) * svs.num_client_entities );
+	svs.client_entities = Z_Malloc( sizeof ( unsigned short ) * svs.num_client_entities );
 
 	/* init network stuff */
 	NET_Config( ( maxclients->value > 1 ) );
@@ -386,6 +392,14 @@ SV_InitGame ( void )
 	/* init game */
 	SV_InitGameProgs();
 
+	/* one shared snapshot per frame we may delta from */
+	svs.snapshots [ 0 ].entities = Z_Malloc( sizeof ( entity_state_t ) * ge->max_edicts * UPDATE_BACKUP );
+
+	for ( i = 1; i < UPDATE_BACKUP; i++ )
+	{
+		svs.snapshots [ i ].entities = svs.snapshots [ 0 ].entities + i * ge->max_edicts;
+	}
+
 	for ( i = 0; i < maxclients->value; i++ )
 	{
 		ent = EDICT_NUM( i + 1 );
@@ -423,6 +437,8 @@ SV_Map ( qboolean attractloop, char *levelstring, qboolean loadgame )
 		SV_InitGame(); /* the game is just starting */
 	}
 
+	SV_JournalStart( attractloop, levelstring, loadgame );
+
 	strcpy( level, levelstring );
 
 	/* if there is a + in the map, set nextserver to the remainder */
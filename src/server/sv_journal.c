@@ -0,0 +1,596 @@
+/*
+ * Copyright (C) 1997-2001 Id Software, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * =======================================================================
+ *
+ * Server input journal. "journal <file>" records everything that drives
+ * the server from the next map on: the msec of each SV_Frame, every
+ * packet read by SV_ReadPackets and the console commands. Demos hold
+ * only what was sent to the clients, a journal holds what came in.
+ * "journalreplay <file>" feeds it back through the same code paths as
+ * fast as possible with the network stubbed out, which gives the same
+ * server workload on every run.
+ *
+ * =======================================================================
+ */
+
+#include "header/server.h"
+
+#define JOURNAL_IDENT ( ( 'R' << 24 ) + ( 'J' << 16 ) + ( 'V' << 8 ) + 'S' )
+#define JOURNAL_VERSION 2
+
+typedef enum
+{
+	JE_EOF,
+	JE_START,       /* seed, spawncount, map and the server cvars */
+	JE_FRAME,       /* msec and curtime of one SV_Frame */
+	JE_PACKET,      /* one packet for SV_ReadPackets */
+	JE_COMMAND      /* one console line */
+} journalevent_t;
+
+static FILE *sj_file;
+static qboolean sj_armed;           /* start recording with the next map */
+static qboolean sj_recording;
+static qboolean sj_replaying;
+static qboolean sj_quit;            /* quit at the end of the replay */
+static qboolean sj_starting;        /* replay not yet at SV_JournalStart */
+static int sj_seed;
+static int sj_spawncount;
+
+/* the next event of the replay */
+static struct
+{
+	int type;
+	int msec;
+	int curtime;
+	netadr_t adr;
+	int length;
+	byte data [ MAX_BIGMSGLEN ];
+} sj_next;
+
+static int sj_frames;
+static int sj_packets;
+static int sj_bytes;
+static long long sj_starttime;
+
+static void SV_Journal_f ( void );
+static void SV_JournalReplay_f ( void );
+
+void
+SV_InitJournal ( void )
+{
+	Cmd_AddCommand( "journal", SV_Journal_f );
+	Cmd_AddCommand( "journalreplay", SV_JournalReplay_f );
+}
+
+static void
+SV_JournalWriteLong ( int l )
+{
+	l = LittleLong( l );
+	fwrite( &l, sizeof( l ), 1, sj_file );
+}
+
+static void
+SV_JournalWriteData ( const void *data, int length )
+{
+	SV_JournalWriteLong( length );
+	fwrite( data, 1, length, sj_file );
+}
+
+static void
+SV_JournalWriteString ( const char *s )
+{
+	SV_JournalWriteData( s, strlen( s ) );
+}
+
+static qboolean
+SV_JournalReadLong ( int *l )
+{
+	if ( fread( l, sizeof( *l ), 1, sj_file ) != 1 )
+	{
+		return ( false );
+	}
+
+	*l = LittleLong( *l );
+	return ( true );
+}
+
+static qboolean
+SV_JournalReadData ( void *data, int *length, int maxlength )
+{
+	if ( !SV_JournalReadLong( length ) || ( *length < 0 ) || ( *length >= maxlength ) )
+	{
+		return ( false );
+	}
+
+	return ( fread( data, 1, *length, sj_file ) == (size_t) *length );
+}
+
+static qboolean
+SV_JournalReadString ( char *s, int size )
+{
+	int length;
+
+	if ( !SV_JournalReadData( s, &length, size ) )
+	{
+		return ( false );
+	}
+
+	s [ length ] = 0;
+	return ( true );
+}
+
+/*
+ * Reads the next event of the replay into sj_next.
+ * A truncated journal ends like a complete one.
+ */
+static void
+SV_JournalReadEvent ( void )
+{
+	int l;
+
+	if ( !SV_JournalReadLong( &sj_next.type ) )
+	{
+		sj_next.type = JE_EOF;
+		return;
+	}
+
+	switch ( sj_next.type )
+	{
+		case JE_FRAME:
+
+			if ( SV_JournalReadLong( &sj_next.msec ) && SV_JournalReadLong( &sj_next.curtime ) )
+			{
+				return;
+			}
+
+			break;
+
+		case JE_PACKET:
+			memset( &sj_next.adr, 0, sizeof( sj_next.adr ) );
+
+			if ( !SV_JournalReadLong( &l ) )
+			{
+				break;
+			}
+
+			sj_next.adr.type = l;
+
+			if ( ( fread( sj_next.adr.ip, 1, sizeof( sj_next.adr.ip ), sj_file ) != sizeof( sj_next.adr.ip ) ) ||
+				 !SV_JournalReadLong( &l ) )
+			{
+				break;
+			}
+
+			sj_next.adr.scope_id = l;
+
+			if ( !SV_JournalReadLong( &l ) )
+			{
+				break;
+			}
+
+			sj_next.adr.port = BigShort( (short) l );
+
+			if ( SV_JournalReadData( sj_next.data, &sj_next.length, sizeof( sj_next.data ) ) )
+			{
+				return;
+			}
+
+			break;
+
+		case JE_COMMAND:
+
+			if ( SV_JournalReadString( (char *) sj_next.data, sizeof( sj_next.data ) ) )
+			{
+				return;
+			}
+
+			break;
+	}
+
+	Com_Printf( "Journal is damaged, replay stopped.\n" );
+	sj_next.type = JE_EOF;
+}
+
+/*
+ * Closes the journal, called by "journal stop",
+ * at the end of a replay and by SV_Shutdown.
+ */
+void
+SV_JournalStop ( void )
+{
+	double seconds;
+
+	/* an armed journal survives the shutdown
+	   that precedes the map it waits for */
+	if ( sj_armed )
+	{
+		return;
+	}
+
+	if ( sj_recording )
+	{
+		Com_Printf( "Journal stopped, %i frames and %i packets (%i bytes) recorded.\n",
+				sj_frames, sj_packets, sj_bytes );
+	}
+
+	if ( sj_replaying )
+	{
+		seconds = ( Sys_Microseconds() - sj_starttime ) / 1000000.0;
+
+		Com_Printf( "Journal replayed, %i frames and %i packets (%i bytes) in %.2f seconds, %.1f frames/s.\n",
+				sj_frames, sj_packets, sj_bytes, seconds,
+				seconds > 0 ? sj_frames / seconds : 0 );
+
+		NET_Stub( false );
+
+		if ( sj_quit )
+		{
+			Cbuf_AddText( "quit\n" );
+		}
+	}
+
+	if ( sj_file )
+	{
+		fclose( sj_file );
+		sj_file = NULL;
+	}
+
+	sj_recording = sj_replaying = sj_starting = false;
+}
+
+/*
+ * Called by SV_Map once the game is up. An armed
+ * journal starts recording here, the seed and all
+ * cvars which change the gameplay are written so
+ * the replay can start the same map the same way.
+ */
+void
+SV_JournalStart ( qboolean attractloop, char *levelstring, qboolean loadgame )
+{
+	cvar_t *var;
+	int seed;
+	int count;
+
+	/* SV_InitGame has used rand() already, the
+	   replay is seeded at the same point */
+	if ( sj_starting )
+	{
+		sj_starting = false;
+		srand( sj_seed );
+		svs.spawncount = sj_spawncount;
+		return;
+	}
+
+	if ( !sj_armed )
+	{
+		return;
+	}
+
+	sj_armed = false;
+	sj_recording = true;
+	sj_frames = sj_packets = sj_bytes = 0;
+
+	seed = Sys_Milliseconds();
+	srand( seed );
+
+	SV_JournalWriteLong( JE_START );
+	SV_JournalWriteLong( seed );
+	SV_JournalWriteLong( svs.spawncount );
+	SV_JournalWriteLong( attractloop );
+	SV_JournalWriteLong( loadgame );
+	SV_JournalWriteString( levelstring );
+
+	for ( count = 0, var = cvar_vars; var; var = var->next )
+	{
+		if ( var->flags & ( CVAR_SERVERINFO | CVAR_LATCH ) )
+		{
+			count++;
+		}
+	}
+
+	SV_JournalWriteLong( count );
+
+	for ( var = cvar_vars; var; var = var->next )
+	{
+		if ( var->flags & ( CVAR_SERVERINFO | CVAR_LATCH ) )
+		{
+			SV_JournalWriteString( var->name );
+			SV_JournalWriteString( var->string );
+		}
+	}
+
+	Com_Printf( "Journal recording %s.\n", levelstring );
+}
+
+/*
+ * Called by SV_Frame. Records the frame time or
+ * replaces it with the recorded one. Returns
+ * false if the replay has just ended.
+ */
+qboolean
+SV_JournalFrame ( int *msec )
+{
+	if ( sj_recording )
+	{
+		SV_JournalWriteLong( JE_FRAME );
+		SV_JournalWriteLong( *msec );
+		SV_JournalWriteLong( curtime );
+		sj_frames++;
+		return ( true );
+	}
+
+	if ( !sj_replaying )
+	{
+		return ( true );
+	}
+
+	if ( sj_next.type != JE_FRAME )
+	{
+		SV_JournalStop();
+		return ( false );
+	}
+
+	*msec = sj_next.msec;
+	curtime = sj_next.curtime;
+	sj_frames++;
+
+	SV_JournalReadEvent();
+
+	return ( true );
+}
+
+/*
+ * Used by SV_ReadPackets in place of NET_GetPacket.
+ */
+qboolean
+SV_JournalGetPacket ( netadr_t *from, sizebuf_t *message )
+{
+	if ( !sj_replaying )
+	{
+		if ( !NET_GetPacket( NS_SERVER, from, message ) )
+		{
+			return ( false );
+		}
+
+		if ( sj_recording )
+		{
+			SV_JournalWriteLong( JE_PACKET );
+			SV_JournalWriteLong( from->type );
+			fwrite( from->ip, 1, sizeof( from->ip ), sj_file );
+			SV_JournalWriteLong( from->scope_id );
+			SV_JournalWriteLong( BigShort( from->port ) );
+			SV_JournalWriteData( message->data, message->cursize );
+
+			sj_packets++;
+			sj_bytes += message->cursize;
+		}
+
+		return ( true );
+	}
+
+	if ( ( sj_next.type != JE_PACKET ) || ( sj_next.length > message->maxsize ) )
+	{
+		return ( false );
+	}
+
+	*from = sj_next.adr;
+	memcpy( message->data, sj_next.data, sj_next.length );
+	message->cursize = sj_next.length;
+
+	sj_packets++;
+	sj_bytes += sj_next.length;
+
+	SV_JournalReadEvent();
+
+	return ( true );
+}
+
+/*
+ * Called by Qcommon_Frame for each console line.
+ */
+void
+SV_JournalCommand ( char *text )
+{
+	if ( sj_recording )
+	{
+		SV_JournalWriteLong( JE_COMMAND );
+		SV_JournalWriteString( text );
+	}
+}
+
+/*
+ * Called by Qcommon_Frame before the command buffer
+ * is run, queues the commands recorded at this point.
+ */
+void
+SV_JournalCommands ( void )
+{
+	while ( sj_replaying && ( sj_next.type == JE_COMMAND ) )
+	{
+		Cbuf_AddText( va( "%s\n", (char *) sj_next.data ) );
+		SV_JournalReadEvent();
+	}
+}
+
+/*
+ * While a replay runs the main loop
+ * doesn't wait for the clock.
+ */
+qboolean
+SV_JournalReplaying ( void )
+{
+	return ( sj_replaying );
+}
+
+static void
+SV_Journal_f ( void )
+{
+	char name [ MAX_OSPATH ];
+	int l;
+
+	if ( Cmd_Argc() != 2 )
+	{
+		Com_Printf( "journal <file> : record the server input from the next map on\n" );
+		Com_Printf( "journal stop : stop recording\n" );
+		return;
+	}
+
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "stop" ) )
+	{
+		if ( !sj_recording && !sj_armed )
+		{
+			Com_Printf( "Not recording a journal.\n" );
+			return;
+		}
+
+		sj_armed = false;
+		SV_JournalStop();
+		return;
+	}
+
+	if ( sj_file )
+	{
+		Com_Printf( "Already recording or replaying a journal.\n" );
+		return;
+	}
+
+	Com_sprintf( name, sizeof( name ), "%s/%s", FS_Gamedir(), Cmd_Argv( 1 ) );
+	FS_CreatePath( name );
+
+	sj_file = fopen( name, "wb" );
+
+	if ( !sj_file )
+	{
+		Com_Printf( "Couldn't open %s.\n", name );
+		return;
+	}
+
+	l = LittleLong( JOURNAL_IDENT );
+	fwrite( &l, sizeof( l ), 1, sj_file );
+	l = LittleLong( JOURNAL_VERSION );
+	fwrite( &l, sizeof( l ), 1, sj_file );
+
+	sj_armed = true;
+	Com_Printf( "Journal %s starts with the next map.\n", name );
+}
+
+/*
+ * Replays only what was recorded: the client packets,
+ * the console and the serverinfo and latched cvars. A
+ * different game library or other cvars may diverge.
+ */
+static void
+SV_JournalReplay_f ( void )
+{
+	char name [ MAX_OSPATH ];
+	char levelstring [ MAX_TOKEN_CHARS ];
+	char cvarname [ MAX_TOKEN_CHARS ];
+	char value [ MAX_TOKEN_CHARS ];
+	int ident, version;
+	int type, seed, spawncount, attractloop, loadgame;
+	int count;
+
+	if ( ( Cmd_Argc() != 2 ) && ( Cmd_Argc() != 3 ) )
+	{
+		Com_Printf( "journalreplay <file> [quit] : replay a server journal\n" );
+		return;
+	}
+
+	if ( sj_file )
+	{
+		Com_Printf( "Already recording or replaying a journal.\n" );
+		return;
+	}
+
+	/* start from scratch like the recording did */
+	SV_Shutdown( "Server is replaying a journal.\n", false );
+
+	Com_sprintf( name, sizeof( name ), "%s/%s", FS_Gamedir(), Cmd_Argv( 1 ) );
+
+	sj_file = fopen( name, "rb" );
+
+	if ( !sj_file )
+	{
+		Com_Printf( "Couldn't open %s.\n", name );
+		return;
+	}
+
+	if ( !SV_JournalReadLong( &ident ) || !SV_JournalReadLong( &version ) ||
+		 ( ident != JOURNAL_IDENT ) || ( version != JOURNAL_VERSION ) )
+	{
+		Com_Printf( "%s is not a version %i journal.\n", name, JOURNAL_VERSION );
+		fclose( sj_file );
+		sj_file = NULL;
+		return;
+	}
+
+	if ( !SV_JournalReadLong( &type ) || ( type != JE_START ) ||
+		 !SV_JournalReadLong( &seed ) || !SV_JournalReadLong( &spawncount ) ||
+		 !SV_JournalReadLong( &attractloop ) ||
+		 !SV_JournalReadLong( &loadgame ) ||
+		 !SV_JournalReadString( levelstring, sizeof( levelstring ) ) ||
+		 !SV_JournalReadLong( &count ) )
+	{
+		Com_Printf( "%s has no start, nothing was recorded.\n", name );
+		fclose( sj_file );
+		sj_file = NULL;
+		return;
+	}
+
+	while ( count-- > 0 )
+	{
+		if ( !SV_JournalReadString( cvarname, sizeof( cvarname ) ) ||
+			 !SV_JournalReadString( value, sizeof( value ) ) )
+		{
+			Com_Printf( "%s is damaged.\n", name );
+			fclose( sj_file );
+			sj_file = NULL;
+			return;
+		}
+
+		/* the gamedir can't be switched from here */
+		if ( !strcmp( cvarname, "game" ) )
+		{
+			if ( strcmp( value, Cvar_VariableString( "game" ) ) )
+			{
+				Com_Printf( "WARNING: journal was recorded with game \"%s\".\n", value );
+			}
+
+			continue;
+		}
+
+		Cvar_ForceSet( cvarname, value );
+	}
+
+	sj_replaying = true;
+	sj_quit = ( Cmd_Argc() == 3 ) && !Q_stricmp( Cmd_Argv( 2 ), "quit" );
+	sj_frames = sj_packets = sj_bytes = 0;
+
+	NET_Stub( true );
+	SV_JournalReadEvent();
+
+	Com_Printf( "Replaying journal %s.\n", name );
+
+	sj_starttime = Sys_Microseconds();
+	sj_starting = true;
+	sj_seed = seed;
+	sj_spawncount = spawncount;
+	SV_Map( attractloop, levelstring, loadgame );
+}
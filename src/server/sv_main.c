@@ -49,6 +49,8 @@ cvar_t  *maxclients;            /* FIXME: rename sv_maxclients */
 cvar_t  *sv_showclamp;
 cvar_t  *hostname;
 cvar_t  *public_server;         /* should heartbeats be sent */
+cvar_t  *sv_paralleltraces;     /* spread batched traces over all cores */
+cvar_t  *sv_downloadrate;       /* cap on the rate downloads are streamed at */
 
 void Master_Shutdown ( void );
 void SV_ConnectionlessPacket ( void );
@@ -71,18 +73,65 @@ SV_DropClient ( client_t *drop )
 		ge->ClientDisconnect( drop->edict );
 	}
 
-	if ( drop->download )
-	{
-		FS_FreeFile( drop->download );
-		drop->download = NULL;
-	}
+	SV_CloseDownload( drop );
 
 	drop->state = cs_zombie; /* become free in a few seconds */
 	drop->name [ 0 ] = 0;
 }
 
+/* what the status string was built from */
+static struct
+{
+	qboolean valid;
+	qboolean listed [ MAX_CLIENTS ];
+	int frags [ MAX_CLIENTS ];
+	int ping [ MAX_CLIENTS ];
+	char name [ MAX_CLIENTS ] [ 32 ];
+} sv_status;
+
+int sv_statusbuilds;
+int sv_statusreuses;
+
 /*
- * Builds the string that is sent as heartbeats and status replies
+ * True if a player joined or left or
+ * changed the name, score or ping
+ * since the status string was built
+ */
+static qboolean
+SV_StatusChanged ( void )
+{
+	int i;
+	client_t    *cl;
+	qboolean listed;
+
+	for ( i = 0; i < maxclients->value; i++ )
+	{
+		cl = &svs.clients [ i ];
+		listed = ( cl->state == cs_connected ) || ( cl->state == cs_spawned );
+
+		if ( listed != sv_status.listed [ i ] )
+		{
+			return ( true );
+		}
+
+		if ( !listed )
+		{
+			continue;
+		}
+
+		if ( ( cl->edict->client->ps.stats [ STAT_FRAGS ] != sv_status.frags [ i ] ) ||
+			 ( cl->ping != sv_status.ping [ i ] ) || strcmp( cl->name, sv_status.name [ i ] ) )
+		{
+			return ( true );
+		}
+	}
+
+	return ( false );
+}
+
+/*
+ * Builds the string that is sent as heartbeats and status replies.
+ * It's only rebuilt when the serverinfo or a player changed.
  */
 char *
 SV_StatusString ( void )
@@ -93,10 +142,23 @@ SV_StatusString ( void )
 	client_t    *cl;
 	int statusLength;
 	int playerLength;
+	qboolean full;
+
+	if ( sv_status.valid && !serverinfo_modified && !SV_StatusChanged() )
+	{
+		sv_statusreuses++;
+		return ( status );
+	}
+
+	sv_statusbuilds++;
+	serverinfo_modified = false;
+	memset( &sv_status, 0, sizeof ( sv_status ) );
+	sv_status.valid = true;
 
 	strcpy( status, Cvar_Serverinfo() );
 	strcat( status, "\n" );
 	statusLength = (int) strlen( status );
+	full = false;
 
 	for ( i = 0; i < maxclients->value; i++ )
 	{
@@ -104,13 +166,19 @@ SV_StatusString ( void )
 
 		if ( ( cl->state == cs_connected ) || ( cl->state == cs_spawned ) )
 		{
+			sv_status.listed [ i ] = true;
+			sv_status.frags [ i ] = cl->edict->client->ps.stats [ STAT_FRAGS ];
+			sv_status.ping [ i ] = cl->ping;
+			strcpy( sv_status.name [ i ], cl->name );
+
 			Com_sprintf( player, sizeof ( player ), "%i %i \"%s\"\n",
 					cl->edict->client->ps.stats [ STAT_FRAGS ], cl->ping, cl->name );
 			playerLength = (int) strlen( player );
 
-			if ( statusLength + playerLength >= sizeof ( status ) )
+			if ( full || ( statusLength + playerLength >= sizeof ( status ) ) )
 			{
-				break; /* can't hold any more */
+				full = true; /* can't hold any more */
+				continue;
 			}
 
 			strcpy( status + statusLength, player );
@@ -201,7 +269,7 @@ SV_ReadPackets ( void )
 	client_t    *cl;
 	int qport;
 
-	while ( NET_GetPacket( NS_SERVER, &net_from, &net_message ) )
+	while ( SV_JournalGetPacket( &net_from, &net_message ) )
 	{
 		/* check for connectionless packet (0xffffffff) first */
 		if ( *(int *) net_message.data == -1 )
@@ -252,6 +320,19 @@ SV_ReadPackets ( void )
 					{
 						SV_ExecuteClientMessage( cl );
 					}
+
+					/* the ack may have made room for the
+					   next part of the gamestate, send it
+					   now instead of with the next frame */
+					if ( cl->gamestatesending )
+					{
+						SV_SendGamestate( cl );
+
+						if ( !cl->netchan.reliable_length )
+						{
+							Netchan_Transmit( &cl->netchan, 0, NULL );
+						}
+					}
 				}
 			}
 
@@ -348,6 +429,10 @@ SV_RunGameFrame ( void )
 	sv.framenum++;
 	sv.time = sv.framenum * 100;
 
+	/* the game can move clients without linking
+	   them, like MoveClientToIntermission does */
+	sv.clusters_valid = false;
+
 	/* don't run if paused */
 	if ( !sv_paused->value || ( maxclients->value > 1 ) )
 	{
@@ -388,8 +473,16 @@ SV_Frame ( int msec )
 		return;
 	}
 
+	/* record or replay the frame time */
+	if ( !SV_JournalFrame( &msec ) )
+	{
+		return;
+	}
+
 	svs.realtime += msec;
 
+	SV_ProfileBegin();
+
 	/* keep the random time dependent */
 	rand();
 
@@ -399,6 +492,8 @@ SV_Frame ( int msec )
 	/* get packets from clients */
 	SV_ReadPackets();
 
+	SV_ProfileMark( SVP_PACKETS );
+
 	/* move autonomous things around if enough time has passed */
 	if ( !sv_timedemo->value && ( svs.realtime < sv.time ) )
 	{
@@ -426,17 +521,25 @@ SV_Frame ( int msec )
 	/* let everything in the world think and move */
 	SV_RunGameFrame();
 
+	SV_ProfileMark( SVP_GAME );
+
 	/* send messages back to the clients that had packets read this frame */
 	SV_SendClientMessages();
 
+	SV_ProfileMark( SVP_SEND );
+
 	/* save the entire world state if recording a serverdemo */
 	SV_RecordDemoMessage();
 
+	SV_ProfileMark( SVP_DEMO );
+
 	/* send a heartbeat to the master if needed */
 	Master_Heartbeat();
 
 	/* clear teleport flags, etc for next frame */
 	SV_PrepWorldFrame();
+
+	SV_ProfileEnd();
 }
 
 /*
@@ -610,6 +713,16 @@ SV_Init ( void )
 
 	public_server = Cvar_Get( "public", "0", 0 );
 
+	sv_reconnect_limit = Cvar_Get( "sv_reconnect_limit", "3", CVAR_ARCHIVE );
+	sv_querylimit = Cvar_Get( "sv_querylimit", "10", 0 );
+	sv_querylimit_total = Cvar_Get( "sv_querylimit_total", "100", 0 );
+
+	sv_paralleltraces = Cvar_Get( "sv_paralleltraces", "1", 0 );
+	sv_downloadrate = Cvar_Get( "sv_downloadrate", "1000000", CVAR_ARCHIVE );
+
+	SV_InitProfile();
+	SV_InitJournal();
+
 	SZ_Init( &net_message, net_message_buffer, sizeof ( net_message_buffer ) );
 }
 
@@ -679,6 +792,9 @@ SV_Shutdown ( char *finalmsg, qboolean reconnect )
 		FS_FCloseFile( (size_t) sv.demofile );
 	}
 
+	SV_ClearGamestate();
+	SV_FlushDownloads( true );
+
 	memset( &sv, 0, sizeof ( sv ) );
 	Com_SetServerState( sv.state );
 
@@ -693,10 +809,17 @@ SV_Shutdown ( char *finalmsg, qboolean reconnect )
 		Z_Free( svs.client_entities );
 	}
 
+	if ( svs.snapshots [ 0 ].entities )
+	{
+		Z_Free( svs.snapshots [ 0 ].entities );
+	}
+
 	if ( svs.demofile )
 	{
 		FS_FCloseFile( (size_t) svs.demofile );
 	}
 
 	memset( &svs, 0, sizeof ( svs ) );
+
+	SV_JournalStop();
 }
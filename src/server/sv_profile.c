@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 1997-2001 Id Software, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * =======================================================================
+ *
+ * Server tick profiler. While "sv_profile" is set every server tick is
+ * split into its phases and kept in a rolling window. "serverprofile"
+ * prints the distribution and a histogram of the last ticks, the game
+ * side breakdown is printed by "sv profile". With "sv_profile 2" each
+ * tick that overruns the 100ms budget is logged.
+ *
+ * =======================================================================
+ */
+
+#include "header/server.h"
+
+#define SVP_WINDOW 600                  /* one minute of ticks */
+#define SVP_BUDGET 100000               /* one tick in usec */
+
+static const char *svp_phasenames [ SVP_NUMPHASES ] = {
+	"packets", "game", "send", "demo", "other"
+};
+
+/* upper bounds of the histogram buckets in ms,
+   the last bucket takes everything above */
+static const int svp_buckets [ ] = {
+	1, 2, 5, 10, 20, 50, 100
+};
+
+#define SVP_NUMBUCKETS ( (int) ( sizeof( svp_buckets ) / sizeof( svp_buckets [ 0 ] ) ) + 1 )
+
+typedef struct
+{
+	int total;
+	int phase [ SVP_NUMPHASES ];
+} svp_tick_t;
+
+static svp_tick_t svp_ticks [ SVP_WINDOW ];
+static int svp_numticks;                /* ticks ever recorded */
+static int svp_overbudget;              /* ticks ever over budget */
+
+static svp_tick_t svp_current;
+static long long svp_stamp;
+static qboolean svp_active;
+
+cvar_t *sv_profile;
+
+static void SV_Profile_f ( void );
+
+void
+SV_InitProfile ( void )
+{
+	sv_profile = Cvar_Get( "sv_profile", "0", 0 );
+
+	Cmd_AddCommand( "serverprofile", SV_Profile_f );
+}
+
+/*
+ * Called at the start of every SV_Frame,
+ * even if no tick is run. Packet reading
+ * accumulates until the next tick.
+ */
+void
+SV_ProfileBegin ( void )
+{
+	svp_active = sv_profile->value != 0;
+
+	if ( !svp_active )
+	{
+		return;
+	}
+
+	svp_stamp = Sys_Microseconds();
+}
+
+/*
+ * Charges the time since the
+ * last mark to the given phase.
+ */
+void
+SV_ProfileMark ( int phase )
+{
+	long long now;
+
+	if ( !svp_active )
+	{
+		return;
+	}
+
+	now = Sys_Microseconds();
+	svp_current.phase [ phase ] += (int) ( now - svp_stamp );
+	svp_stamp = now;
+}
+
+/*
+ * Called once a full tick has been run.
+ */
+void
+SV_ProfileEnd ( void )
+{
+	svp_tick_t *tick;
+	int i;
+
+	if ( !svp_active )
+	{
+		return;
+	}
+
+	SV_ProfileMark( SVP_OTHER );
+
+	tick = &svp_ticks [ svp_numticks % SVP_WINDOW ];
+	*tick = svp_current;
+	tick->total = 0;
+
+	for ( i = 0; i < SVP_NUMPHASES; i++ )
+	{
+		tick->total += tick->phase [ i ];
+	}
+
+	svp_numticks++;
+
+	if ( tick->total > SVP_BUDGET )
+	{
+		svp_overbudget++;
+
+		if ( sv_profile->value > 1 )
+		{
+			Com_Printf( "sv_profile: frame %i took %.1fms (packets %.1f game %.1f send %.1f demo %.1f other %.1f)\n",
+					sv.framenum, tick->total / 1000.0f,
+					tick->phase [ SVP_PACKETS ] / 1000.0f, tick->phase [ SVP_GAME ] / 1000.0f,
+					tick->phase [ SVP_SEND ] / 1000.0f, tick->phase [ SVP_DEMO ] / 1000.0f,
+					tick->phase [ SVP_OTHER ] / 1000.0f );
+		}
+	}
+
+	memset( &svp_current, 0, sizeof( svp_current ) );
+}
+
+static int
+SV_ProfileCompare ( const void *a, const void *b )
+{
+	return ( *(const int *) a - *(const int *) b );
+}
+
+/*
+ * Prints mean, p99 and max
+ * of one column in ms.
+ */
+static void
+SV_ProfilePrintColumn ( const char *name, int *values, int count )
+{
+	int i;
+	long long sum;
+
+	qsort( values, count, sizeof( int ), SV_ProfileCompare );
+
+	for ( i = 0, sum = 0; i < count; i++ )
+	{
+		sum += values [ i ];
+	}
+
+	Com_Printf( "%-8s %7.2f %7.2f %7.2f\n", name,
+			( sum / count ) / 1000.0,
+			values [ ( count * 99 ) / 100 ] / 1000.0,
+			values [ count - 1 ] / 1000.0 );
+}
+
+static void
+SV_Profile_f ( void )
+{
+	int values [ SVP_WINDOW ];
+	int histogram [ SVP_NUMBUCKETS ];
+	int count;
+	int i, j;
+
+	if ( ( Cmd_Argc() > 1 ) && !Q_stricmp( Cmd_Argv( 1 ), "reset" ) )
+	{
+		svp_numticks = svp_overbudget = 0;
+		memset( &svp_current, 0, sizeof( svp_current ) );
+		Com_Printf( "Server profile reset.\n" );
+		return;
+	}
+
+	count = svp_numticks < SVP_WINDOW ? svp_numticks : SVP_WINDOW;
+
+	if ( !count )
+	{
+		Com_Printf( "No ticks profiled, set sv_profile 1.\n" );
+		return;
+	}
+
+	Com_Printf( "Last %i of %i ticks, times in ms:\n", count, svp_numticks );
+	Com_Printf( "%-8s %7s %7s %7s\n", "", "mean", "p99", "max" );
+
+	for ( i = 0; i < count; i++ )
+	{
+		values [ i ] = svp_ticks [ i ].total;
+	}
+
+	SV_ProfilePrintColumn( "total", values, count );
+
+	for ( j = 0; j < SVP_NUMPHASES; j++ )
+	{
+		for ( i = 0; i < count; i++ )
+		{
+			values [ i ] = svp_ticks [ i ].phase [ j ];
+		}
+
+		SV_ProfilePrintColumn( svp_phasenames [ j ], values, count );
+	}
+
+	memset( histogram, 0, sizeof( histogram ) );
+
+	for ( i = 0; i < count; i++ )
+	{
+		for ( j = 0; j < SVP_NUMBUCKETS - 1; j++ )
+		{
+			if ( svp_ticks [ i ].total < svp_buckets [ j ] * 1000 )
+			{
+				break;
+			}
+		}
+
+		histogram [ j ]++;
+	}
+
+	Com_Printf( "Tick histogram:\n" );
+
+	for ( j = 0; j < SVP_NUMBUCKETS - 1; j++ )
+	{
+		Com_Printf( "  < %3ims %5i\n", svp_buckets [ j ], histogram [ j ] );
+	}
+
+	Com_Printf( " >= %3ims %5i\n", svp_buckets [ j - 1 ], histogram [ j ] );
+	Com_Printf( "%i ticks over budget since reset.\n", svp_overbudget );
+
+	/* the game breakdown */
+	if ( ge )
+	{
+		Cbuf_AddText( "sv profile\n" );
+	}
+}
@@ -138,6 +138,80 @@ SV_BroadcastCommand ( char *fmt, ... )
 	SV_Multicast( NULL, MULTICAST_ALL_R );
 }
 
+/*
+ * Looks up the cluster and area of every connected
+ * client and sorts them by cluster, so that SV_Multicast
+ * only has to test each occupied cluster once. Clients
+ * without a cluster are outside the world and left out.
+ */
+static void
+SV_BuildClientClusters ( void )
+{
+	client_t *client;
+	clientcluster_t cc;
+	int leafnum;
+	int i, j;
+
+	sv.num_clientclusters = 0;
+
+	for ( i = 0, client = svs.clients; i < maxclients->value; i++, client++ )
+	{
+		if ( ( client->state == cs_free ) || ( client->state == cs_zombie ) )
+		{
+			continue;
+		}
+
+		leafnum = CM_PointLeafnum( client->edict->s.origin );
+
+		cc.cluster = CM_LeafCluster( leafnum );
+		cc.area = CM_LeafArea( leafnum );
+		cc.client = client;
+
+		if ( cc.cluster < 0 )
+		{
+			continue;
+		}
+
+		for ( j = sv.num_clientclusters; j > 0; j-- )
+		{
+			if ( sv.clientclusters [ j - 1 ].cluster <= cc.cluster )
+			{
+				break;
+			}
+
+			sv.clientclusters [ j ] = sv.clientclusters [ j - 1 ];
+		}
+
+		sv.clientclusters [ j ] = cc;
+		sv.num_clientclusters++;
+	}
+
+	sv.clusters_valid = true;
+}
+
+static void
+SV_MulticastToClient ( client_t *client, qboolean reliable )
+{
+	if ( ( client->state == cs_free ) || ( client->state == cs_zombie ) )
+	{
+		return;
+	}
+
+	if ( ( client->state != cs_spawned ) && !reliable )
+	{
+		return;
+	}
+
+	if ( reliable )
+	{
+		SZ_Write( &client->netchan.message, sv.multicast.data, sv.multicast.cursize );
+	}
+	else
+	{
+		SZ_Write( &client->datagram, sv.multicast.data, sv.multicast.cursize );
+	}
+}
+
 /*
  * Sends the contents of sv.multicast to a subset of the clients,
  * then clears sv.multicast.
@@ -150,11 +224,13 @@ void
 SV_Multicast ( vec3_t origin, multicast_t to )
 {
 	client_t    *client;
+	clientcluster_t *cc;
 	byte        *mask;
 	int leafnum, cluster;
 	int j;
 	qboolean reliable;
-	int area1, area2;
+	qboolean visible;
+	int area1;
 
 	reliable = false;
 
@@ -187,7 +263,6 @@ SV_Multicast ( vec3_t origin, multicast_t to )
 		case MULTICAST_PHS_R:
 			reliable = true; /* intentional fallthrough */
 		case MULTICAST_PHS:
-			leafnum = CM_PointLeafnum( origin );
 			cluster = CM_LeafCluster( leafnum );
 			mask = CM_ClusterPHS( cluster );
 			break;
@@ -195,7 +270,6 @@ SV_Multicast ( vec3_t origin, multicast_t to )
 		case MULTICAST_PVS_R:
 			reliable = true; /* intentional fallthrough */
 		case MULTICAST_PVS:
-			leafnum = CM_PointLeafnum( origin );
 			cluster = CM_LeafCluster( leafnum );
 			mask = CM_ClusterPVS( cluster );
 			break;
@@ -206,42 +280,39 @@ SV_Multicast ( vec3_t origin, multicast_t to )
 	}
 
 	/* send the data to all relevent clients */
-	for ( j = 0, client = svs.clients; j < maxclients->value; j++, client++ )
+	if ( !mask )
 	{
-		if ( ( client->state == cs_free ) || ( client->state == cs_zombie ) )
+		for ( j = 0, client = svs.clients; j < maxclients->value; j++, client++ )
 		{
-			continue;
+			SV_MulticastToClient( client, reliable );
 		}
-
-		if ( ( client->state != cs_spawned ) && !reliable )
+	}
+	else
+	{
+		if ( !sv.clusters_valid )
 		{
-			continue;
+			SV_BuildClientClusters();
 		}
 
-		if ( mask )
+		cluster = -1;
+		visible = false;
+
+		for ( j = 0; j < sv.num_clientclusters; j++ )
 		{
-			leafnum = CM_PointLeafnum( client->edict->s.origin );
-			cluster = CM_LeafCluster( leafnum );
-			area2 = CM_LeafArea( leafnum );
+			cc = &sv.clientclusters [ j ];
 
-			if ( !CM_AreasConnected( area1, area2 ) )
+			if ( cc->cluster != cluster )
 			{
-				continue;
+				cluster = cc->cluster;
+				visible = mask [ cluster >> 3 ] & ( 1 << ( cluster & 7 ) );
 			}
 
-			if ( mask && ( !( mask [ cluster >> 3 ] & ( 1 << ( cluster & 7 ) ) ) ) )
+			if ( !visible || !CM_AreasConnected( area1, cc->area ) )
 			{
 				continue;
 			}
-		}
 
-		if ( reliable )
-		{
-			SZ_Write( &client->netchan.message, sv.multicast.data, sv.multicast.cursize );
-		}
-		else
-		{
-			SZ_Write( &client->datagram, sv.multicast.data, sv.multicast.cursize );
+			SV_MulticastToClient( cc->client, reliable );
 		}
 	}
 
@@ -416,12 +487,13 @@ SV_StartSound ( vec3_t origin, edict_t *entity, int channel, int soundindex, flo
 qboolean
 SV_SendClientDatagram ( client_t *client )
 {
-	byte msg_buf [ MAX_MSGLEN ];
+	byte msg_buf [ MAX_BIGMSGLEN ];
 	sizebuf_t msg;
 
 	SV_BuildClientFrame( client );
 
-	SZ_Init( &msg, msg_buf, sizeof ( msg_buf ) );
+	/* larger than a packet if the netchan can fragment */
+	SZ_Init( &msg, msg_buf, client->netchan.maxmsglen );
 	msg.allowoverflow = true;
 
 	/* send over all the relevant entity_state_t
@@ -454,7 +526,7 @@ SV_SendClientDatagram ( client_t *client )
 	Netchan_Transmit( &client->netchan, msg.cursize, msg.data );
 
 	/* record the size for rate estimation */
-	client->message_size [ sv.framenum % RATE_MESSAGES ] = msg.cursize;
+	client->message_size [ sv.framenum % RATE_MESSAGES ] += msg.cursize;
 
 	return ( true );
 }
@@ -472,21 +544,16 @@ SV_DemoCompleted ( void )
 }
 
 /*
- * Returns true if the client is over its current
- * bandwidth estimation and should not be sent another packet
+ * Bytes the client can still be sent before it
+ * is over rate, negative if it is over. The
+ * rate is the client's own or its download rate.
  */
-qboolean
-SV_RateDrop ( client_t *c )
+int
+SV_RateLeft ( client_t *c, int rate )
 {
 	int total;
 	int i;
 
-	/* never drop over the loopback */
-	if ( c->netchan.remote_address.type == NA_LOOPBACK )
-	{
-		return ( false );
-	}
-
 	total = 0;
 
 	for ( i = 0; i < RATE_MESSAGES; i++ )
@@ -494,10 +561,25 @@ SV_RateDrop ( client_t *c )
 		total += c->message_size [ i ];
 	}
 
-	if ( total > c->rate )
+	return ( rate - total );
+}
+
+/*
+ * Returns true if the client is over its current
+ * bandwidth estimation and should not be sent another packet
+ */
+qboolean
+SV_RateDrop ( client_t *c )
+{
+	/* never drop over the loopback */
+	if ( c->netchan.remote_address.type == NA_LOOPBACK )
+	{
+		return ( false );
+	}
+
+	if ( SV_RateLeft( c, c->rate ) < 0 )
 	{
 		c->surpressCount++;
-		c->message_size [ sv.framenum % RATE_MESSAGES ] = 0;
 		return ( true );
 	}
 
@@ -510,7 +592,7 @@ SV_SendClientMessages ( void )
 	int i;
 	client_t    *c;
 	int msglen;
-	byte msgbuf [ MAX_MSGLEN ];
+	byte msgbuf [ MAX_BIGMSGLEN ];
 	size_t r;
 
 	msglen = 0;
@@ -541,9 +623,9 @@ SV_SendClientMessages ( void )
 				return;
 			}
 
-			if ( msglen > MAX_MSGLEN )
+			if ( msglen > MAX_BIGMSGLEN )
 			{
-				Com_Error( ERR_DROP, "SV_SendClientMessages: msglen > MAX_MSGLEN" );
+				Com_Error( ERR_DROP, "SV_SendClientMessages: msglen > MAX_BIGMSGLEN" );
 			}
 
 			r = FS_FRead( msgbuf, msglen, 1, (size_t) sv.demofile );
@@ -574,6 +656,15 @@ SV_SendClientMessages ( void )
 			SV_DropClient( c );
 		}
 
+		/* the downloads and the datagram of this
+		   frame are counted against the rate */
+		c->message_size [ sv.framenum % RATE_MESSAGES ] = 0;
+
+		if ( c->download && c->downloadrate )
+		{
+			SV_SendDownload( c );
+		}
+
 		if ( ( sv.state == ss_cinematic ) ||
 			 ( sv.state == ss_demo ) ||
 			 ( sv.state == ss_pic )
@@ -593,6 +684,11 @@ SV_SendClientMessages ( void )
 		}
 		else
 		{
+			if ( c->gamestatesending )
+			{
+				SV_SendGamestate( c );
+			}
+
 			/* just update reliable	if needed */
 			if ( c->netchan.message.cursize  || ( curtime - c->netchan.last_sent > 1000 ) )
 			{
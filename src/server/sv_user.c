@@ -26,6 +26,45 @@
 
 #include "header/server.h"
 
+#ifdef ZIP
+ #include <zlib.h>
+#endif
+
+/* enough for every configstring and baseline */
+#define GAMESTATE_MAXLENGTH ( MAX_CONFIGSTRINGS * ( MAX_QPATH + 4 ) + MAX_EDICTS * 64 )
+
+/* configstrings sent after the gamestate
+   blob before it's rebuilt */
+#define GAMESTATE_MAXCHANGED 64
+
+typedef struct
+{
+	int count;
+	int total;                          /* ms */
+	int max;                            /* ms */
+} joinstats_t;
+
+static joinstats_t sv_joinstats [ 2 ];  /* slow, fast */
+static int sv_gamestatebuilds;
+
+#define DOWNLOAD_CACHESIZE 8
+#define DOWNLOAD_TIMEOUT 300                /* ms without progress before resending */
+#define DOWNLOAD_MAXRETRIES 30
+
+typedef struct
+{
+	char name [ MAX_QPATH ];
+	byte *data;
+	int size;
+	qboolean frompak;
+	int refcount;                       /* clients downloading it */
+	int lastused;                       /* curtime */
+} dlcache_t;
+
+static dlcache_t sv_dlcache [ DOWNLOAD_CACHESIZE ];
+static int sv_dlcachehits;
+static int sv_dlcachemisses;
+
 #define MAX_STRINGCMDS  8
 
 edict_t *sv_player;
@@ -44,6 +83,230 @@ SV_BeginDemoserver ( void )
 	}
 }
 
+#ifdef ZIP
+
+/*
+ * Compresses what SV_Configstrings_f and SV_Baselines_f
+ * would send into sv.gamestate. Returns false if zlib
+ * fails, the client gets it the slow way then.
+ */
+static qboolean
+SV_BuildGamestate ( void )
+{
+	sizebuf_t buf;
+	entity_state_t nullstate;
+	entity_state_t  *base;
+	uLongf size;
+	int i;
+
+	if ( sv.gamestate )
+	{
+		Z_Free( sv.gamestate );
+		sv.gamestate = NULL;
+	}
+
+	SZ_Init( &buf, Z_Malloc( GAMESTATE_MAXLENGTH ), GAMESTATE_MAXLENGTH );
+
+	for ( i = 0; i < MAX_CONFIGSTRINGS; i++ )
+	{
+		if ( sv.configstrings [ i ] [ 0 ] )
+		{
+			MSG_WriteByte( &buf, svc_configstring );
+			MSG_WriteShort( &buf, i );
+			MSG_WriteString( &buf, sv.configstrings [ i ] );
+		}
+	}
+
+	memset( &nullstate, 0, sizeof ( nullstate ) );
+
+	for ( i = 0; i < MAX_EDICTS; i++ )
+	{
+		base = &sv.baselines [ i ];
+
+		if ( base->modelindex || base->sound || base->effects )
+		{
+			MSG_WriteByte( &buf, svc_spawnbaseline );
+			MSG_WriteDeltaEntity( &nullstate, base, &buf, true, true );
+		}
+	}
+
+	size = compressBound( buf.cursize );
+	sv.gamestate = Z_Malloc( size );
+
+	if ( compress2( sv.gamestate, &size, buf.data, buf.cursize, Z_BEST_COMPRESSION ) != Z_OK )
+	{
+		Z_Free( sv.gamestate );
+		sv.gamestate = NULL;
+		Z_Free( buf.data );
+		return ( false );
+	}
+
+	sv.gamestatesize = size;
+	sv.gamestatelength = buf.cursize;
+	sv.gamestategeneration = sv.csgeneration;
+	sv_gamestatebuilds++;
+
+	Z_Free( buf.data );
+
+	return ( true );
+}
+
+#endif
+
+/*
+ * Starts sending the gamestate blob to a client that
+ * asked for it in its connect. A few configstrings that
+ * changed since the blob was built are sent after it,
+ * when there are more it's rebuilt. But not while
+ * another client still gets the old one.
+ */
+static qboolean
+SV_StartGamestate ( client_t *cl )
+{
+#ifdef ZIP
+	client_t    *c;
+	int i, changed;
+
+	cl->gamestatesending = false;
+
+	if ( sv.gamestate && ( sv.gamestategeneration != sv.csgeneration ) )
+	{
+		for ( i = 0, changed = 0; i < MAX_CONFIGSTRINGS; i++ )
+		{
+			if ( sv.csversion [ i ] > sv.gamestategeneration )
+			{
+				changed++;
+			}
+		}
+
+		for ( i = 0, c = svs.clients; i < maxclients->value; i++, c++ )
+		{
+			if ( ( c->state == cs_connected ) && c->gamestatesending )
+			{
+				break;
+			}
+		}
+
+		if ( ( changed > GAMESTATE_MAXCHANGED ) && ( i == maxclients->value ) )
+		{
+			Z_Free( sv.gamestate );
+			sv.gamestate = NULL;
+		}
+	}
+
+	if ( !sv.gamestate && !SV_BuildGamestate() )
+	{
+		return ( false );
+	}
+
+	cl->gamestatesending = true;
+	cl->gamestatecount = 0;
+	cl->gamestatecs = 0;
+
+	SV_SendGamestate( cl );
+
+	return ( true );
+#else
+	return ( false );
+#endif
+}
+
+/*
+ * Queues the next part of the gamestate in the reliable
+ * message. It doesn't wait for a client command, a new
+ * part is written as soon as there's room, so the next
+ * one is ready when the last one is acknowledged. The
+ * configstrings that changed after the blob was built
+ * follow it, then the precache.
+ */
+void
+SV_SendGamestate ( client_t *cl )
+{
+	sizebuf_t   *msg;
+	int length;
+	int start;
+
+	if ( !cl->gamestatesending || ( cl->state != cs_connected ) )
+	{
+		return;
+	}
+
+	msg = &cl->netchan.message;
+
+	if ( cl->gamestatecount < sv.gamestatesize )
+	{
+		/* like SV_Configstrings_f, leave half of the message
+		   for other reliable data, the header takes 15 bytes */
+		length = cl->netchan.maxmsglen / 2 - msg->cursize - 16;
+
+		if ( length > sv.gamestatesize - cl->gamestatecount )
+		{
+			length = sv.gamestatesize - cl->gamestatecount;
+		}
+		else if ( length < 256 )
+		{
+			return;
+		}
+
+		MSG_WriteByte( msg, svc_gamestate );
+		MSG_WriteLong( msg, sv.gamestatesize );
+		MSG_WriteLong( msg, sv.gamestatelength );
+		MSG_WriteLong( msg, cl->gamestatecount );
+		MSG_WriteShort( msg, length );
+		SZ_Write( msg, sv.gamestate + cl->gamestatecount, length );
+
+		cl->gamestatecount += length;
+
+		if ( cl->gamestatecount < sv.gamestatesize )
+		{
+			return;
+		}
+	}
+
+	for ( start = cl->gamestatecs; start < MAX_CONFIGSTRINGS; start++ )
+	{
+		if ( sv.csversion [ start ] <= sv.gamestategeneration )
+		{
+			continue;
+		}
+
+		if ( msg->cursize + strlen( sv.configstrings [ start ] ) + 4 > cl->netchan.maxmsglen / 2 )
+		{
+			break;
+		}
+
+		MSG_WriteByte( msg, svc_configstring );
+		MSG_WriteShort( msg, start );
+		MSG_WriteString( msg, sv.configstrings [ start ] );
+	}
+
+	cl->gamestatecs = start;
+
+	if ( ( start < MAX_CONFIGSTRINGS ) || ( msg->cursize > cl->netchan.maxmsglen / 2 ) )
+	{
+		return;
+	}
+
+	MSG_WriteByte( msg, svc_stufftext );
+	MSG_WriteString( msg, va( "precache %i\n", svs.spawncount ) );
+
+	cl->gamestatesending = false;
+}
+
+/*
+ * Frees the gamestate blob, before
+ * sv is wiped.
+ */
+void
+SV_ClearGamestate ( void )
+{
+	if ( sv.gamestate )
+	{
+		Z_Free( sv.gamestate );
+		sv.gamestate = NULL;
+	}
+}
+
 /*
  * Sends the first message from the server to a connected client.
  * This will be sent on the initial connection and upon each server load.
@@ -63,6 +326,15 @@ SV_New_f ( void )
 		return;
 	}
 
+	/* after a map change the join
+	   is timed from here */
+	if ( !sv_client->connecttime )
+	{
+		sv_client->connecttime = Sys_Milliseconds();
+	}
+
+	sv_client->gamestatesending = false;
+
 	/* demo servers just dump the file message */
 	if ( sv.state == ss_demo )
 	{
@@ -104,6 +376,15 @@ SV_New_f ( void )
 		sv_client->edict = ent;
 		memset( &sv_client->lastcmd, 0, sizeof ( sv_client->lastcmd ) );
 
+		/* the whole gamestate without round trips, but not
+		   into a demo across a level change, stock clients
+		   can't play svc_gamestate */
+		if ( sv_client->fastconnect && !sv_client->recording &&
+			 SV_StartGamestate( sv_client ) )
+		{
+			return;
+		}
+
 		/* begin fetching configstrings */
 		MSG_WriteByte( &sv_client->netchan.message, svc_stufftext );
 		MSG_WriteString( &sv_client->netchan.message, va( "cmd configstrings %i 0\n", svs.spawncount ) );
@@ -134,7 +415,7 @@ SV_Configstrings_f ( void )
 	start = atoi( Cmd_Argv( 2 ) );
 
 	/* write a packet full of data */
-	while ( sv_client->netchan.message.cursize < MAX_MSGLEN / 2 && start < MAX_CONFIGSTRINGS )
+	while ( sv_client->netchan.message.cursize < sv_client->netchan.maxmsglen / 2 && start < MAX_CONFIGSTRINGS )
 	{
 		if ( sv.configstrings [ start ] [ 0 ] )
 		{
@@ -187,7 +468,7 @@ SV_Baselines_f ( void )
 	memset( &nullstate, 0, sizeof ( nullstate ) );
 
 	/* write a packet full of data */
-	while ( sv_client->netchan.message.cursize <  MAX_MSGLEN / 2 &&
+	while ( sv_client->netchan.message.cursize < sv_client->netchan.maxmsglen / 2 &&
 			start < MAX_EDICTS )
 	{
 		base = &sv.baselines [ start ];
@@ -214,6 +495,43 @@ SV_Baselines_f ( void )
 	}
 }
 
+static void
+SV_CountJoin ( joinstats_t *stats, int time )
+{
+	stats->count++;
+	stats->total += time;
+
+	if ( time > stats->max )
+	{
+		stats->max = time;
+	}
+}
+
+/*
+ * Prints how long clients took from the
+ * connect to entering the game.
+ */
+void
+SV_JoinStats_f ( void )
+{
+	int i;
+	static char *names [ 2 ] = { "slow", "fast" };
+
+	Com_Printf( "%-8s %8s %8s %8s\n", "connect", "joins", "avg ms", "max ms" );
+
+	for ( i = 0; i < 2; i++ )
+	{
+		Com_Printf( "%-8s %8i %8i %8i\n", names [ i ], sv_joinstats [ i ].count,
+				sv_joinstats [ i ].count ? sv_joinstats [ i ].total / sv_joinstats [ i ].count : 0,
+				sv_joinstats [ i ].max );
+	}
+
+	Com_Printf( "gamestate built %i times, %i bytes, %i compressed\n",
+			sv_gamestatebuilds, sv.gamestatelength, sv.gamestatesize );
+	Com_Printf( "download cache: %i hits, %i misses\n",
+			sv_dlcachehits, sv_dlcachemisses );
+}
+
 void
 SV_Begin_f ( void )
 {
@@ -229,12 +547,312 @@ SV_Begin_f ( void )
 
 	sv_client->state = cs_spawned;
 
+	if ( sv_client->connecttime )
+	{
+		SV_CountJoin( &sv_joinstats [ sv_client->fastconnect ? 1 : 0 ],
+				Sys_Milliseconds() - sv_client->connecttime );
+		sv_client->connecttime = 0;
+	}
+
 	/* call the game begin function */
 	ge->ClientBegin( sv_player );
 
 	Cbuf_InsertFromDefer();
 }
 
+/*
+ * Files being downloaded are loaded once and
+ * shared by everyone downloading them. What
+ * nobody downloads anymore is kept until the
+ * slot is needed or the map changes, joining
+ * players tend to want the same files.
+ */
+static qboolean
+SV_OpenDownload ( client_t *cl, char *name )
+{
+	extern int file_from_pak;
+	dlcache_t *c, *slot;
+	int i;
+
+	slot = NULL;
+
+	for ( i = 0, c = sv_dlcache; i < DOWNLOAD_CACHESIZE; i++, c++ )
+	{
+		if ( c->data && !strcmp( c->name, name ) )
+		{
+			break;
+		}
+
+		/* the least recently used free slot */
+		if ( !c->refcount && ( !slot || !c->data ||
+			 ( slot->data && ( c->lastused < slot->lastused ) ) ) )
+		{
+			slot = c;
+		}
+	}
+
+	if ( i == DOWNLOAD_CACHESIZE )
+	{
+		if ( !slot || ( strlen( name ) >= MAX_QPATH ) )
+		{
+			/* every slot is busy, load a private copy */
+			cl->downloadcache = -1;
+			cl->downloadsize = FS_LoadFile( name, (void **) &cl->download );
+
+			return ( cl->download && !( ( strncmp( name, "maps/", 5 ) == 0 ) && file_from_pak ) );
+		}
+
+		c = slot;
+
+		if ( c->data )
+		{
+			FS_FreeFile( c->data );
+			c->data = NULL;
+		}
+
+		c->size = FS_LoadFile( name, (void **) &c->data );
+
+		if ( !c->data )
+		{
+			return ( false );
+		}
+
+		strcpy( c->name, name );
+		c->frompak = file_from_pak;
+		sv_dlcachemisses++;
+	}
+	else
+	{
+		sv_dlcachehits++;
+	}
+
+	if ( ( strncmp( name, "maps/", 5 ) == 0 ) && c->frompak )
+	{
+		return ( false );
+	}
+
+	c->refcount++;
+	c->lastused = curtime;
+
+	cl->downloadcache = c - sv_dlcache;
+	cl->download = c->data;
+	cl->downloadsize = c->size;
+
+	return ( true );
+}
+
+void
+SV_CloseDownload ( client_t *cl )
+{
+	if ( !cl->download )
+	{
+		return;
+	}
+
+	if ( cl->downloadcache < 0 )
+	{
+		FS_FreeFile( cl->download );
+	}
+	else
+	{
+		sv_dlcache [ cl->downloadcache ].refcount--;
+	}
+
+	cl->download = NULL;
+	cl->downloadrate = 0;
+}
+
+/*
+ * Frees the cached files. Without all only
+ * those nobody is downloading right now.
+ */
+void
+SV_FlushDownloads ( qboolean all )
+{
+	dlcache_t *c;
+	int i;
+
+	for ( i = 0, c = sv_dlcache; i < DOWNLOAD_CACHESIZE; i++, c++ )
+	{
+		if ( c->data && ( all || !c->refcount ) )
+		{
+			FS_FreeFile( c->data );
+			memset( c, 0, sizeof ( *c ) );
+		}
+	}
+}
+
+static int
+SV_SendDownloadBlock ( client_t *cl, int offset )
+{
+	sizebuf_t msg;
+	byte data [ MAX_MSGLEN ];
+	int r;
+
+	r = cl->downloadsize - offset;
+
+	if ( r > DOWNLOAD_BLOCKSIZE )
+	{
+		r = DOWNLOAD_BLOCKSIZE;
+	}
+
+	SZ_Init( &msg, data, sizeof ( data ) );
+	MSG_WriteByte( &msg, svc_downloadblock );
+	MSG_WriteByte( &msg, cl->downloadid );
+	MSG_WriteLong( &msg, cl->downloadsize );
+	MSG_WriteLong( &msg, offset );
+	MSG_WriteShort( &msg, r );
+	SZ_Write( &msg, cl->download + offset, r );
+
+	Netchan_Transmit( &cl->netchan, msg.cursize, msg.data );
+
+	/* counted like the datagrams */
+	cl->message_size [ sv.framenum % RATE_MESSAGES ] += msg.cursize;
+
+	return ( msg.cursize );
+}
+
+/*
+ * The rate a download is streamed at. A client
+ * in the game shares its rate with the datagrams,
+ * one that is still connecting gets nothing else
+ * and is only held to the negotiated download
+ * rate, the game rate is clamped far lower.
+ */
+static int
+SV_DownloadRate ( client_t *cl )
+{
+	if ( ( cl->state == cs_spawned ) &&
+		 ( cl->netchan.remote_address.type != NA_LOOPBACK ) &&
+		 ( cl->rate < cl->downloadrate ) )
+	{
+		return ( cl->rate );
+	}
+
+	return ( cl->downloadrate );
+}
+
+/*
+ * Streams a download requested with a rate. Up
+ * to SV_DownloadRate per frame is sent, one
+ * block per packet, while no more than
+ * DOWNLOAD_WINDOW blocks are unacknowledged.
+ * The blocks are counted like the datagrams
+ * are. If the client makes no progress at all
+ * we go back to what it has.
+ */
+void
+SV_SendDownload ( client_t *cl )
+{
+	int budget;
+	int rate;
+
+	if ( curtime - cl->downloadtime > DOWNLOAD_TIMEOUT + cl->ping )
+	{
+		if ( ++cl->downloadretries > DOWNLOAD_MAXRETRIES )
+		{
+			/* give up, the client goes on
+			   like the file wasn't there */
+			SV_CloseDownload( cl );
+			SV_ClientPrintf( cl, PRINT_HIGH, "Download timed out.\n" );
+			MSG_WriteByte( &cl->netchan.message, svc_download );
+			MSG_WriteShort( &cl->netchan.message, -1 );
+			MSG_WriteByte( &cl->netchan.message, 0 );
+			return;
+		}
+
+		cl->downloadcount = cl->downloadacked;
+		cl->downloadtime = curtime;
+	}
+
+	rate = SV_DownloadRate( cl );
+	budget = rate / RATE_MESSAGES;
+
+	if ( budget > SV_RateLeft( cl, rate ) )
+	{
+		budget = SV_RateLeft( cl, rate );
+	}
+
+	while ( ( budget > 0 ) && ( cl->downloadcount < cl->downloadsize ) &&
+			( cl->downloadcount - cl->downloadacked < DOWNLOAD_WINDOW * DOWNLOAD_BLOCKSIZE ) )
+	{
+		budget -= SV_SendDownloadBlock( cl, cl->downloadcount );
+		cl->downloadcount += DOWNLOAD_BLOCKSIZE;
+	}
+
+	if ( cl->downloadcount > cl->downloadsize )
+	{
+		cl->downloadcount = cl->downloadsize;
+	}
+}
+
+static qboolean
+SV_DownloadBlockReceived ( char *received, int block )
+{
+	int c;
+
+	c = received [ block / 4 ];
+	c = ( c >= 'a' ) ? c - 'a' + 10 : c - '0';
+
+	return ( ( c >> ( block % 4 ) ) & 1 );
+}
+
+/*
+ * Blocks got lost when the client has later
+ * ones. Which it has comes as hex digits, bit
+ * n for the block n after offset, the first is
+ * always missing. What was sent again is only
+ * sent again after a timeout.
+ */
+static void
+SV_ResendDownloadBlocks ( client_t *cl, int offset, char *received )
+{
+	int count, last;
+	int i;
+
+	count = strlen( received ) * 4;
+
+	if ( !count )
+	{
+		return;
+	}
+
+	if ( curtime - cl->downloadresenttime > DOWNLOAD_TIMEOUT + cl->ping )
+	{
+		cl->downloadresent = 0;
+	}
+
+	last = 0;
+
+	for ( i = 0; i < count; i++ )
+	{
+		if ( SV_DownloadBlockReceived( received, i ) )
+		{
+			last = i;
+		}
+	}
+
+	for ( i = 0; i < last; i++ )
+	{
+		/* the rest with the next ack */
+		if ( SV_RateLeft( cl, SV_DownloadRate( cl ) ) <= 0 )
+		{
+			break;
+		}
+
+		if ( SV_DownloadBlockReceived( received, i ) ||
+			 ( offset + i * DOWNLOAD_BLOCKSIZE < cl->downloadresent ) ||
+			 ( offset + i * DOWNLOAD_BLOCKSIZE >= cl->downloadcount ) )
+		{
+			continue;
+		}
+
+		SV_SendDownloadBlock( cl, offset + i * DOWNLOAD_BLOCKSIZE );
+		cl->downloadresent = offset + ( i + 1 ) * DOWNLOAD_BLOCKSIZE;
+		cl->downloadresenttime = curtime;
+	}
+}
+
 void
 SV_NextDownload_f ( void )
 {
@@ -247,6 +865,40 @@ SV_NextDownload_f ( void )
 		return;
 	}
 
+	if ( sv_client->downloadrate )
+	{
+		/* a streaming client acks what it has,
+		   the ack may be for an earlier file */
+		r = atoi( Cmd_Argv( 1 ) );
+
+		if ( ( atoi( Cmd_Argv( 2 ) ) != sv_client->downloadid ) ||
+			 ( r < sv_client->downloadacked ) || ( r > sv_client->downloadsize ) )
+		{
+			return;
+		}
+
+		if ( r > sv_client->downloadacked )
+		{
+			sv_client->downloadacked = r;
+			sv_client->downloadtime = curtime;
+			sv_client->downloadretries = 0;
+
+			if ( sv_client->downloadcount < r )
+			{
+				sv_client->downloadcount = r;
+			}
+
+			if ( r == sv_client->downloadsize )
+			{
+				SV_CloseDownload( sv_client );
+				return;
+			}
+		}
+
+		SV_ResendDownloadBlocks( sv_client, r, Cmd_Argv( 3 ) );
+		return;
+	}
+
 	r = sv_client->downloadsize - sv_client->downloadcount;
 
 	if ( r > 1024 )
@@ -275,10 +927,15 @@ SV_NextDownload_f ( void )
 		return;
 	}
 
-	FS_FreeFile( sv_client->download );
-	sv_client->download = NULL;
+	SV_CloseDownload( sv_client );
 }
 
+/*
+ * download <name> [offset] [rate id]
+ * With a rate the file is streamed by
+ * SV_SendDownload instead of sent one
+ * block per nextdl.
+ */
 void
 SV_BeginDownload_f ( void )
 {
@@ -288,8 +945,8 @@ SV_BeginDownload_f ( void )
 	extern cvar_t *allow_download_models;
 	extern cvar_t *allow_download_sounds;
 	extern cvar_t *allow_download_maps;
-	extern int file_from_pak;
 	int offset = 0;
+	int rate = 0;
 
 	name = Cmd_Argv( 1 );
 
@@ -298,6 +955,11 @@ SV_BeginDownload_f ( void )
 		offset = atoi( Cmd_Argv( 2 ) ); /* downloaded offset */
 	}
 
+	if ( Cmd_Argc() > 4 )
+	{
+		rate = atoi( Cmd_Argv( 3 ) );
+	}
+
 	/* hacked by zoid to allow more conrol over download
 	   first off, no .. or global allow check */
 	if ( strstr( name, ".." ) || strstr( name, "\\" ) || !allow_download->value
@@ -323,12 +985,20 @@ SV_BeginDownload_f ( void )
 		return;
 	}
 
-	if ( sv_client->download )
+	SV_CloseDownload( sv_client );
+
+	if ( !SV_OpenDownload( sv_client, name ) )
 	{
-		FS_FreeFile( sv_client->download );
+		Com_DPrintf( "Couldn't download %s to %s\n", name, sv_client->name );
+
+		SV_CloseDownload( sv_client );
+
+		MSG_WriteByte( &sv_client->netchan.message, svc_download );
+		MSG_WriteShort( &sv_client->netchan.message, -1 );
+		MSG_WriteByte( &sv_client->netchan.message, 0 );
+		return;
 	}
 
-	sv_client->downloadsize = FS_LoadFile( name, (void **) &sv_client->download );
 	sv_client->downloadcount = offset;
 
 	if ( offset > sv_client->downloadsize )
@@ -336,23 +1006,27 @@ SV_BeginDownload_f ( void )
 		sv_client->downloadcount = sv_client->downloadsize;
 	}
 
-	if ( !sv_client->download || ( ( strncmp( name, "maps/", 5 ) == 0 ) && file_from_pak ) )
+	if ( rate > sv_downloadrate->value )
 	{
-		Com_DPrintf( "Couldn't download %s to %s\n", name, sv_client->name );
-
-		if ( sv_client->download )
-		{
-			FS_FreeFile( sv_client->download );
-			sv_client->download = NULL;
-		}
+		rate = sv_downloadrate->value;
+	}
 
-		MSG_WriteByte( &sv_client->netchan.message, svc_download );
-		MSG_WriteShort( &sv_client->netchan.message, -1 );
-		MSG_WriteByte( &sv_client->netchan.message, 0 );
-		return;
+	/* an empty file is done with one block */
+	if ( ( rate > 0 ) && ( sv_client->downloadcount < sv_client->downloadsize ) )
+	{
+		sv_client->downloadrate = rate;
+		sv_client->downloadid = atoi( Cmd_Argv( 4 ) ) & 255;
+		sv_client->downloadacked = sv_client->downloadcount;
+		sv_client->downloadtime = curtime;
+		sv_client->downloadretries = 0;
+		sv_client->downloadresent = 0;
+		sv_client->downloadresenttime = curtime;
+	}
+	else
+	{
+		SV_NextDownload_f();
 	}
 
-	SV_NextDownload_f();
 	Com_DPrintf( "Downloading %s to %s\n", name, sv_client->name );
 }
 
@@ -400,6 +1074,18 @@ SV_Nextserver ( void )
 	Cvar_Set( "nextserver", "" );
 }
 
+/*
+ * Clients recording a demo limit the messages to what a
+ * .dm2 file can hold and lift the limit when they stop
+ */
+void
+SV_MsgLen_f ( void )
+{
+	sv_client->recording = ( atoi( Cmd_Argv( 1 ) ) <= MAX_MSGLEN );
+
+	Netchan_SetMaxMsgLen( &sv_client->netchan, atoi( Cmd_Argv( 1 ) ) );
+}
+
 /*
  * A cinematic has completed or been aborted by a client, so move
  * to the next server,
@@ -434,6 +1120,7 @@ ucmd_t ucmds[] = {
 	{ "nextserver", SV_Nextserver_f },
 
 	{ "disconnect", SV_Disconnect_f },
+	{ "msglen", SV_MsgLen_f },
 
 	/* issued by hand at client consoles */
 	{ "info", SV_ShowServerinfo_f },
@@ -169,6 +169,12 @@ SV_LinkEdict ( edict_t *ent )
 		return;
 	}
 
+	/* a client moved, SV_Multicast has to look up its cluster again */
+	if ( ( NUM_FOR_EDICT( ent ) >= 1 ) && ( NUM_FOR_EDICT( ent ) <= maxclients->value ) )
+	{
+		sv.clusters_valid = false;
+	}
+
 	/* set the size */
 	VectorSubtract( ent->maxs, ent->mins, ent->size );
 
@@ -605,6 +611,8 @@ SV_ClipMoveToEntities ( moveclip_t *clip )
 		}
 
 		/* might intersect, so do an exact clip */
+		trace_stats [ trace_caller ].entities++;
+
 		headnode = SV_HullForEntity( touch );
 		angles = touch->s.angles;
 
@@ -669,28 +677,17 @@ SV_TraceBounds ( vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, vec3_t boxm
 }
 
 /*
- * Moves the given mins/maxs volume through the world from start to end.
- * Passedict and edicts owned by passedict are explicitly not checked.
+ * Clips a trace that already went through
+ * the world against all solid entities.
  */
-trace_t
-SV_Trace ( vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t *passedict, int contentmask )
+static trace_t
+SV_ClipTraceToEntities ( trace_t trace, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t *passedict, int contentmask )
 {
 	moveclip_t clip;
 
-	if ( !mins )
-	{
-		mins = vec3_origin;
-	}
-
-	if ( !maxs )
-	{
-		maxs = vec3_origin;
-	}
-
 	memset( &clip, 0, sizeof ( moveclip_t ) );
 
-	/* clip to world */
-	clip.trace = CM_BoxTrace( start, end, mins, maxs, 0, contentmask );
+	clip.trace = trace;
 	clip.trace.ent = ge->edicts;
 
 	if ( clip.trace.fraction == 0 )
@@ -716,3 +713,104 @@ SV_Trace ( vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t *passedic
 
 	return ( clip.trace );
 }
+
+/*
+ * Moves the given mins/maxs volume through the world from start to end.
+ * Passedict and edicts owned by passedict are explicitly not checked.
+ */
+trace_t
+SV_Trace ( vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t *passedict, int contentmask )
+{
+	trace_t trace;
+
+	if ( !mins )
+	{
+		mins = vec3_origin;
+	}
+
+	if ( !maxs )
+	{
+		maxs = vec3_origin;
+	}
+
+	trace_stats [ trace_caller ].traces++;
+
+	/* clip to world */
+	trace = CM_BoxTrace( start, end, mins, maxs, 0, contentmask );
+
+	return ( SV_ClipTraceToEntities( trace, start, mins, maxs, end, passedict, contentmask ) );
+}
+
+/*
+ * One context per thread for
+ * the world part of batched traces
+ */
+static tracecontext_t *sv_tracecontexts;
+static tracestats_t sv_tracestats [ MAX_THREADS ] [ TRACE_NUMCALLERS ];
+
+static void
+SV_TraceWorld ( void *data, int index, int thread )
+{
+	tracerequest_t *req;
+
+	req = (tracerequest_t *) data + index;
+	req->trace = CM_BoxTraceContext( &sv_tracecontexts [ thread ], req->start,
+			req->end, req->mins, req->maxs, 0, req->contentmask );
+}
+
+/*
+ * Resolves a batch of traces. The world traces are
+ * independent and run in parallel, clipping against
+ * entities needs the shared box hull and area nodes
+ * and is done afterwards in order.
+ */
+void
+SV_TraceBatch ( tracerequest_t *requests, int count )
+{
+	tracerequest_t *req;
+	int numthreads;
+	int i;
+
+	if ( !sv_paralleltraces->value || ( count < 4 ) )
+	{
+		for ( i = 0, req = requests; i < count; i++, req++ )
+		{
+			req->trace = SV_Trace( req->start, req->mins, req->maxs, req->end,
+					req->passent, req->contentmask );
+		}
+
+		return;
+	}
+
+	numthreads = Sys_NumThreads();
+
+	if ( !sv_tracecontexts )
+	{
+		sv_tracecontexts = Z_Malloc( numthreads * sizeof( tracecontext_t ) );
+
+		for ( i = 0; i < numthreads; i++ )
+		{
+			CM_InitTraceContext( &sv_tracecontexts [ i ], sv_tracestats [ i ] );
+		}
+	}
+
+	for ( i = 0; i < numthreads; i++ )
+	{
+		sv_tracecontexts [ i ].caller = trace_caller;
+	}
+
+	Sys_ParallelFor( SV_TraceWorld, requests, count );
+
+	for ( i = 0; i < numthreads; i++ )
+	{
+		CM_MergeTraceStats( sv_tracestats [ i ] );
+	}
+
+	for ( i = 0, req = requests; i < count; i++, req++ )
+	{
+		trace_stats [ trace_caller ].traces++;
+
+		req->trace = SV_ClipTraceToEntities( req->trace, req->start, req->mins,
+				req->maxs, req->end, req->passent, req->contentmask );
+	}
+}
@@ -0,0 +1,688 @@
+/*
+ * Copyright (C) 1997-2001 Id Software, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * =======================================================================
+ *
+ * A headless benchmark for the collision code. It loads a map through
+ * CM_LoadMap, without server, client or renderer, and measures box
+ * traces, point contents and player movement:
+ *
+ *  - traces are random or replayed from a "tracerecord" recording
+ *  - point contents are taken at the start points of the traces
+ *  - players are spawned at the info_player_* spots of the map and
+ *    moved by random, but reproducible, usercmd sequences
+ *
+ * Finally the traces are done again on all cores and with the other
+ * collision layout and compared against the sequential results. The
+ * exit status is 1 if any of them differ, so the benchmark can gate
+ * collision changes.
+ *
+ * =======================================================================
+ */
+
+#include <time.h>
+
+#include "../common/header/common.h"
+#include "../common/header/cmodel.h"
+#include "../common/header/zone.h"
+
+#define MAX_SPOTS 256
+
+typedef struct
+{
+	vec3_t start, end;
+	vec3_t mins, maxs;
+	int headnode;
+	int brushmask;
+} benchtrace_t;
+
+typedef struct
+{
+	double *usec;
+	int count;
+	double seconds;
+} benchresult_t;
+
+extern zhead_t z_chain;
+
+static benchtrace_t *bench_traces;
+static int bench_numtraces;
+
+static trace_t *bench_results;
+static trace_t *bench_threadresults;
+static tracecontext_t *bench_contexts [ MAX_THREADS ];
+static tracestats_t bench_stats [ MAX_THREADS ] [ TRACE_NUMCALLERS ];
+
+static vec3_t bench_spots [ MAX_SPOTS ];
+static int bench_numspots;
+
+static vec3_t player_mins = { -16, -16, -24 };
+static vec3_t player_maxs = { 16, 16, 32 };
+
+/* ======================================================================= */
+
+static double
+Bench_Seconds ( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+
+	return ( ts.tv_sec + ts.tv_nsec / 1000000000.0 );
+}
+
+static int
+Bench_Random ( int range )
+{
+	return ( rand() % range );
+}
+
+static float
+Bench_Crandom ( void )
+{
+	return ( ( rand() / (float) RAND_MAX ) * 2.0f - 1.0f );
+}
+
+static int
+Bench_Compare ( const void *a, const void *b )
+{
+	double d = *(const double *) a - *(const double *) b;
+
+	return ( d < 0 ? -1 : ( d > 0 ? 1 : 0 ) );
+}
+
+static void
+Bench_Report ( const char *name, const char *unit, benchresult_t *r )
+{
+	qsort( r->usec, r->count, sizeof( double ), Bench_Compare );
+
+	printf( "%-14s %8i %12.0f %s/s  usec p50 %7.2f p90 %7.2f p99 %7.2f max %8.2f\n",
+			name, r->count, r->count / r->seconds, unit,
+			r->usec [ r->count / 2 ], r->usec [ ( r->count * 90 ) / 100 ],
+			r->usec [ ( r->count * 99 ) / 100 ], r->usec [ r->count - 1 ] );
+}
+
+/* ======================================================================= */
+
+/*
+ * Collects the origins of the player
+ * spawn spots from the entity string.
+ */
+static void
+Bench_FindSpots ( void )
+{
+	char *data;
+	char *token;
+	char key [ MAX_TOKEN_CHARS ];
+	vec3_t origin;
+	qboolean isspot;
+
+	data = CM_EntityString();
+
+	while ( 1 )
+	{
+		token = COM_Parse( &data );
+
+		if ( !data || ( token [ 0 ] != '{' ) )
+		{
+			break;
+		}
+
+		isspot = false;
+		VectorClear( origin );
+
+		while ( 1 )
+		{
+			token = COM_Parse( &data );
+
+			if ( !data || ( token [ 0 ] == '}' ) )
+			{
+				break;
+			}
+
+			Com_sprintf( key, sizeof( key ), "%s", token );
+			token = COM_Parse( &data );
+
+			if ( !strcmp( key, "classname" ) && !strncmp( token, "info_player_", 12 ) )
+			{
+				isspot = true;
+			}
+			else if ( !strcmp( key, "origin" ) )
+			{
+				sscanf( token, "%f %f %f", &origin [ 0 ], &origin [ 1 ], &origin [ 2 ] );
+			}
+		}
+
+		if ( isspot && ( bench_numspots < MAX_SPOTS ) )
+		{
+			VectorCopy( origin, bench_spots [ bench_numspots ] );
+			bench_numspots++;
+		}
+	}
+
+	/* no spots, take the middle of the world */
+	if ( !bench_numspots )
+	{
+		cmodel_t *world = &map_cmodels [ 0 ];
+
+		VectorAdd( world->mins, world->maxs, bench_spots [ 0 ] );
+		VectorScale( bench_spots [ 0 ], 0.5, bench_spots [ 0 ] );
+		bench_numspots = 1;
+	}
+}
+
+/*
+ * Random traces around the spawn spots, with
+ * the boxes and masks the game uses most.
+ */
+static void
+Bench_RandomTraces ( int count )
+{
+	benchtrace_t *bt;
+	vec3_t dir;
+	float length;
+	int i;
+
+	bench_traces = Z_Malloc( count * sizeof( benchtrace_t ) );
+	bench_numtraces = count;
+
+	for ( i = 0; i < count; i++ )
+	{
+		bt = &bench_traces [ i ];
+
+		VectorCopy( bench_spots [ Bench_Random( bench_numspots ) ], bt->start );
+		bt->start [ 0 ] += Bench_Crandom() * 256;
+		bt->start [ 1 ] += Bench_Crandom() * 256;
+		bt->start [ 2 ] += Bench_Crandom() * 64;
+
+		dir [ 0 ] = Bench_Crandom();
+		dir [ 1 ] = Bench_Crandom();
+		dir [ 2 ] = Bench_Crandom() * 0.5f;
+		VectorNormalize( dir );
+
+		switch ( Bench_Random( 4 ) )
+		{
+			case 0: /* bullets and sight checks */
+				length = 8192;
+				bt->brushmask = MASK_SHOT;
+				break;
+			case 1: /* monster and item movement */
+				length = 64;
+				VectorSet( bt->mins, -16, -16, -24 );
+				VectorSet( bt->maxs, 16, 16, 32 );
+				bt->brushmask = MASK_MONSTERSOLID;
+				break;
+			case 2: /* projectiles */
+				length = 1024;
+				VectorSet( bt->mins, -4, -4, -4 );
+				VectorSet( bt->maxs, 4, 4, 4 );
+				bt->brushmask = MASK_SHOT;
+				break;
+			default: /* position tests */
+				length = 0;
+				VectorCopy( player_mins, bt->mins );
+				VectorCopy( player_maxs, bt->maxs );
+				bt->brushmask = MASK_PLAYERSOLID;
+				break;
+		}
+
+		VectorMA( bt->start, length, dir, bt->end );
+		bt->headnode = 0;
+	}
+}
+
+/*
+ * Reads a recording made by "tracerecord"
+ * on the same map.
+ */
+static void
+Bench_LoadTraces ( char *name )
+{
+	recordedtrace_t rt;
+	char mapname [ MAX_QPATH ];
+	int header [ 2 ];
+	int max;
+	FILE *f;
+	benchtrace_t *bt;
+	int i;
+
+	f = fopen( name, "rb" );
+
+	if ( !f )
+	{
+		Com_Error( ERR_FATAL, "Couldn't open %s", name );
+	}
+
+	if ( ( fread( header, sizeof( header ), 1, f ) != 1 ) ||
+		 ( LittleLong( header [ 0 ] ) != TRACERECORD_IDENT ) ||
+		 ( LittleLong( header [ 1 ] ) != TRACERECORD_VERSION ) ||
+		 ( fread( mapname, sizeof( mapname ), 1, f ) != 1 ) )
+	{
+		Com_Error( ERR_FATAL, "%s is not a trace recording", name );
+	}
+
+	mapname [ sizeof( mapname ) - 1 ] = 0;
+
+	if ( strcmp( mapname, map_name ) )
+	{
+		Com_Error( ERR_FATAL, "%s was recorded on %s", name, mapname );
+	}
+
+	max = 0;
+
+	while ( fread( &rt, sizeof( rt ), 1, f ) == 1 )
+	{
+		if ( bench_numtraces == max )
+		{
+			max = max ? max * 2 : 4096;
+			bench_traces = realloc( bench_traces, max * sizeof( benchtrace_t ) );
+		}
+
+		bt = &bench_traces [ bench_numtraces ];
+
+		for ( i = 0; i < 3; i++ )
+		{
+			bt->start [ i ] = LittleFloat( rt.start [ i ] );
+			bt->end [ i ] = LittleFloat( rt.end [ i ] );
+			bt->mins [ i ] = LittleFloat( rt.mins [ i ] );
+			bt->maxs [ i ] = LittleFloat( rt.maxs [ i ] );
+		}
+
+		bt->headnode = LittleLong( rt.headnode );
+		bt->brushmask = LittleLong( rt.brushmask );
+
+		if ( ( bt->headnode >= 0 ) && ( bt->headnode < numnodes ) )
+		{
+			bench_numtraces++;
+		}
+	}
+
+	fclose( f );
+
+	if ( !bench_numtraces )
+	{
+		Com_Error( ERR_FATAL, "No traces in %s", name );
+	}
+}
+
+/* ======================================================================= */
+
+static void
+Bench_Traces ( benchresult_t *r )
+{
+	benchtrace_t *bt;
+	double start, t;
+	int i;
+
+	r->count = bench_numtraces;
+	r->usec = Z_Malloc( r->count * sizeof( double ) );
+	bench_results = Z_Malloc( r->count * sizeof( trace_t ) );
+
+	start = Bench_Seconds();
+
+	for ( i = 0; i < bench_numtraces; i++ )
+	{
+		bt = &bench_traces [ i ];
+
+		t = Bench_Seconds();
+		bench_results [ i ] = CM_BoxTrace( bt->start, bt->end, bt->mins,
+				bt->maxs, bt->headnode, bt->brushmask );
+		r->usec [ i ] = ( Bench_Seconds() - t ) * 1000000.0;
+	}
+
+	r->seconds = Bench_Seconds() - start;
+}
+
+static void
+Bench_PointContents ( benchresult_t *r )
+{
+	double start, t;
+	int i;
+
+	r->count = bench_numtraces;
+	r->usec = Z_Malloc( r->count * sizeof( double ) );
+
+	start = Bench_Seconds();
+
+	for ( i = 0; i < bench_numtraces; i++ )
+	{
+		t = Bench_Seconds();
+		CM_PointContents( bench_traces [ i ].start, 0 );
+		r->usec [ i ] = ( Bench_Seconds() - t ) * 1000000.0;
+	}
+
+	r->seconds = Bench_Seconds() - start;
+}
+
+static trace_t
+Bench_PMTrace ( vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end )
+{
+	return ( CM_BoxTrace( start, end, mins, maxs, 0, MASK_PLAYERSOLID ) );
+}
+
+static int
+Bench_PMPointContents ( vec3_t point )
+{
+	return ( CM_PointContents( point, 0 ) );
+}
+
+/*
+ * Every player runs its own sequence of
+ * commands, like a client at 40 fps that
+ * runs around, strafes, turns and jumps.
+ */
+static void
+Bench_Pmove ( benchresult_t *r, int players, int steps )
+{
+	pmove_t pm;
+	pmove_state_t state;
+	usercmd_t cmd;
+	double start, t;
+	vec3_t origin;
+	int i, j, n;
+
+	r->count = players * steps;
+	r->usec = Z_Malloc( r->count * sizeof( double ) );
+
+	pm_airaccelerate = 0;
+	n = 0;
+	start = Bench_Seconds();
+
+	for ( i = 0; i < players; i++ )
+	{
+		memset( &state, 0, sizeof( state ) );
+		memset( &cmd, 0, sizeof( cmd ) );
+
+		VectorCopy( bench_spots [ i % bench_numspots ], origin );
+		state.pm_type = PM_NORMAL;
+		state.gravity = 800;
+
+		for ( j = 0; j < 3; j++ )
+		{
+			state.origin [ j ] = (short) ( origin [ j ] * 8 );
+		}
+
+		for ( j = 0; j < steps; j++ )
+		{
+			/* change the keys every half second */
+			if ( !( j % 20 ) )
+			{
+				cmd.forwardmove = ( Bench_Random( 3 ) - 1 ) * 400;
+				cmd.sidemove = ( Bench_Random( 3 ) - 1 ) * 400;
+				cmd.upmove = Bench_Random( 4 ) ? 0 : 200;
+			}
+
+			cmd.msec = 25;
+			cmd.angles [ YAW ] += ANGLE2SHORT( Bench_Crandom() * 10 );
+			cmd.angles [ PITCH ] = ANGLE2SHORT( Bench_Crandom() * 30 );
+
+			memset( &pm, 0, sizeof( pm ) );
+			pm.s = state;
+			pm.cmd = cmd;
+			pm.trace = Bench_PMTrace;
+			pm.pointcontents = Bench_PMPointContents;
+
+			t = Bench_Seconds();
+			Pmove( &pm );
+			r->usec [ n++ ] = ( Bench_Seconds() - t ) * 1000000.0;
+
+			state = pm.s;
+		}
+	}
+
+	r->seconds = Bench_Seconds() - start;
+}
+
+static void
+Bench_TraceThread ( void *data, int index, int thread )
+{
+	benchtrace_t *bt = &bench_traces [ index ];
+
+	bench_threadresults [ index ] = CM_BoxTraceContext( bench_contexts [ thread ],
+			bt->start, bt->end, bt->mins, bt->maxs, bt->headnode, bt->brushmask );
+}
+
+static qboolean
+Bench_SameTrace ( trace_t *a, trace_t *b )
+{
+	return ( ( a->fraction == b->fraction ) && VectorCompare( a->endpos, b->endpos ) &&
+			 VectorCompare( a->plane.normal, b->plane.normal ) &&
+			 ( a->plane.dist == b->plane.dist ) && ( a->contents == b->contents ) &&
+			 ( a->surface == b->surface ) && ( a->startsolid == b->startsolid ) &&
+			 ( a->allsolid == b->allsolid ) );
+}
+
+/*
+ * Does all traces again on all cores, like
+ * SV_TraceBatch does, and compares them with
+ * the sequential results. Returns how many
+ * of them differ.
+ */
+static int
+Bench_Threads ( void )
+{
+	double start, seconds;
+	int threads;
+	int differ;
+	int i;
+
+	threads = Sys_NumThreads();
+
+	for ( i = 0; i < threads; i++ )
+	{
+		bench_contexts [ i ] = Z_Malloc( sizeof( tracecontext_t ) );
+		CM_InitTraceContext( bench_contexts [ i ], bench_stats [ i ] );
+	}
+
+	bench_threadresults = Z_Malloc( bench_numtraces * sizeof( trace_t ) );
+
+	start = Bench_Seconds();
+	Sys_ParallelFor( Bench_TraceThread, NULL, bench_numtraces );
+	seconds = Bench_Seconds() - start;
+
+	for ( i = 0, differ = 0; i < bench_numtraces; i++ )
+	{
+		if ( !Bench_SameTrace( &bench_results [ i ], &bench_threadresults [ i ] ) )
+		{
+			differ++;
+		}
+	}
+
+	printf( "%-14s %8i %12.0f traces/s  on %i threads, %i results differ\n",
+			"threaded", bench_numtraces, bench_numtraces / seconds, threads, differ );
+
+	return ( differ );
+}
+
+/*
+ * Does all traces again with the other
+ * collision layout and compares them.
+ * Returns how many of them differ.
+ */
+static int
+Bench_Layouts ( void )
+{
+	benchtrace_t *bt;
+	trace_t trace;
+	int compact;
+	int differ;
+	int i;
+
+	compact = cm_compact->value != 0;
+	Cvar_SetValue( "cm_compact", !compact );
+
+	for ( i = 0, differ = 0; i < bench_numtraces; i++ )
+	{
+		bt = &bench_traces [ i ];
+
+		trace = CM_BoxTrace( bt->start, bt->end, bt->mins, bt->maxs,
+				bt->headnode, bt->brushmask );
+
+		if ( !Bench_SameTrace( &bench_results [ i ], &trace ) )
+		{
+			differ++;
+		}
+	}
+
+	Cvar_SetValue( "cm_compact", compact );
+
+	printf( "%-14s %8i traces, %i results differ between the layouts\n",
+			"layouts", bench_numtraces, differ );
+
+	return ( differ );
+}
+
+/* ======================================================================= */
+
+static void
+Bench_Usage ( void )
+{
+	printf( "Usage: cmbench [options] <map>\n" );
+	printf( "  -basedir <dir>    directory with baseq2 (default .)\n" );
+	printf( "  -traces <n>       random traces (default 100000)\n" );
+	printf( "  -replay <file>    replay a tracerecord recording instead\n" );
+	printf( "  -players <n>      players to move (default 64)\n" );
+	printf( "  -steps <n>        usercmds per player (default 400)\n" );
+	printf( "  -seed <n>         seed for the random traces and usercmds\n" );
+	printf( "  -compact <0|1>    use the compact collision layout (default 1)\n" );
+	printf( "  -threads <n>      threads for the threaded traces (default all cores)\n" );
+	exit( 2 );
+}
+
+int
+main ( int argc, char **argv )
+{
+	benchresult_t traces, points, pmoves;
+	char mapname [ MAX_QPATH ];
+	char *map, *replay;
+	unsigned checksum;
+	int numtraces, players, steps;
+	int differ;
+	int i;
+
+	map = replay = NULL;
+	numtraces = 100000;
+	players = 64;
+	steps = 400;
+	srand( 1 );
+
+	z_chain.next = z_chain.prev = &z_chain;
+
+	Swap_Init();
+	Cmd_Init();
+	Cvar_Init();
+
+	for ( i = 1; i < argc; i++ )
+	{
+		if ( argv [ i ] [ 0 ] != '-' )
+		{
+			map = argv [ i ];
+			continue;
+		}
+
+		if ( i + 1 >= argc )
+		{
+			Bench_Usage();
+		}
+
+		if ( !strcmp( argv [ i ], "-basedir" ) )
+		{
+			Cvar_Get( "basedir", argv [ ++i ], CVAR_NOSET );
+		}
+		else if ( !strcmp( argv [ i ], "-traces" ) )
+		{
+			numtraces = atoi( argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-replay" ) )
+		{
+			replay = argv [ ++i ];
+		}
+		else if ( !strcmp( argv [ i ], "-players" ) )
+		{
+			players = atoi( argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-steps" ) )
+		{
+			steps = atoi( argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-seed" ) )
+		{
+			srand( atoi( argv [ ++i ] ) );
+		}
+		else if ( !strcmp( argv [ i ], "-compact" ) )
+		{
+			Cvar_Get( "cm_compact", argv [ ++i ], 0 );
+		}
+		else if ( !strcmp( argv [ i ], "-threads" ) )
+		{
+			Cvar_Get( "sys_threads", argv [ ++i ], CVAR_NOSET );
+		}
+		else
+		{
+			Bench_Usage();
+		}
+	}
+
+	if ( !map || ( numtraces < 1 ) || ( players < 1 ) || ( steps < 1 ) )
+	{
+		Bench_Usage();
+	}
+
+	FS_InitFilesystem();
+
+	/* "q2dm1" is short for "maps/q2dm1.bsp" */
+	if ( strchr( map, '/' ) )
+	{
+		Com_sprintf( mapname, sizeof( mapname ), "%s", map );
+	}
+	else
+	{
+		Com_sprintf( mapname, sizeof( mapname ), "maps/%s.bsp", map );
+	}
+
+	CM_LoadMap( mapname, false, &checksum );
+	Bench_FindSpots();
+
+	printf( "%s: %i nodes, %i brushes, %i spawn spots, compact layout %s\n",
+			mapname, numnodes, numbrushes, bench_numspots,
+			cm_compact->value ? "on" : "off" );
+
+	if ( replay )
+	{
+		Bench_LoadTraces( replay );
+	}
+	else
+	{
+		Bench_RandomTraces( numtraces );
+	}
+
+	Bench_Traces( &traces );
+	Bench_Report( replay ? "traces (rec)" : "traces", "traces", &traces );
+
+	Bench_PointContents( &points );
+	Bench_Report( "pointcontents", "points", &points );
+
+	Bench_Pmove( &pmoves, players, steps );
+	Bench_Report( "pmove", "pmoves", &pmoves );
+
+	differ = Bench_Threads();
+	differ += Bench_Layouts();
+
+	return ( differ ? 1 : 0 );
+}
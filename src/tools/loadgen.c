@@ -0,0 +1,1708 @@
+/*
+ * Copyright (C) 1997-2001 Id Software, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * =======================================================================
+ *
+ * A load generator for dedicated servers. It connects many fake clients
+ * to a q2ded over UDP, each with its own socket and qport. They go
+ * through the same handshake as the real client (getchallenge, connect,
+ * new, configstrings, baselines, begin) over the real netchan and send
+ * random or scripted usercmds once connected. The server frames are
+ * parsed, but nothing is kept and nothing is rendered.
+ *
+ * Printed are the bandwidth the server sends and receives, the frame
+ * rate and the latency the clients see and the packet loss. With
+ * -download every client downloads a file before entering the game.
+ *
+ * =======================================================================
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include "../common/header/common.h"
+#include "../common/header/zone.h"
+
+#define MAX_FAKECLIENTS 1024
+#define MAX_SCRIPTLINES 4096
+#define LG_CMD_BACKUP 64                /* same as the client */
+#define LG_MAXLATENCY 1000              /* histogram size in ms */
+
+typedef enum
+{
+	LG_IDLE,                /* not started yet */
+	LG_CHALLENGE,           /* waiting for the challenge */
+	LG_CONNECTING,          /* waiting for client_connect */
+	LG_CONNECTED,           /* loading the map */
+	LG_ACTIVE               /* got a frame, sending moves */
+} lgstate_t;
+
+typedef struct
+{
+	int socket;
+	int qport;
+	lgstate_t state;
+	int lastconnect;        /* time of the last getchallenge */
+	int connectstart;       /* time the connection was started */
+
+	netchan_t netchan;
+	int serverframe;        /* last parsed frame, -1 for none */
+
+	usercmd_t cmds [ LG_CMD_BACKUP ];
+	int cmdtime [ LG_CMD_BACKUP ];
+	float yaw;
+	int scriptline;
+
+	qboolean downloading;
+	qboolean downloaded;    /* once per run */
+	int downloadstart;
+	int downloadcount;      /* bytes we have */
+	int downloadacked;
+	int downloadacktime;
+	int ahead [ DOWNLOAD_WINDOW ];  /* numbers+1 of the blocks after a lost one */
+	qboolean aheadchanged;
+	char spawncount [ 16 ]; /* for the begin after the download */
+} fakeclient_t;
+
+typedef struct
+{
+	long long bytesin;      /* sent by the server */
+	long long bytesout;     /* received by the server */
+	int packets;
+	int dropped;
+	int frames;
+	int latency [ LG_MAXLATENCY ];
+	int numlatency;
+	int connects;
+	long long connecttime;
+	int disconnects;
+	int downloads;
+	long long downloadtime;
+} lgstats_t;
+
+extern zhead_t z_chain;
+extern cvar_t *qport;
+
+static fakeclient_t *lg_clients;
+static int lg_numclients;
+static fakeclient_t *lg_current;        /* whose socket NET_SendPacket uses */
+
+static netadr_t lg_server;
+static int lg_fps;
+static int lg_attack;
+static int lg_rate;
+static int lg_verbose;
+static int lg_fastconnect;
+static int lg_fragments;
+static char *lg_download;
+static int lg_downloadrate;
+
+static short lg_script [ MAX_SCRIPTLINES ] [ 6 ];
+static int lg_numscript;
+
+static lgstats_t lg_interval;
+static lgstats_t lg_total;
+
+/* ======================================================================= */
+
+/*
+ * The part of network.c that netchan.c needs, the rest
+ * is in stubs.c. Every fake client has its own socket,
+ * so NET_SendPacket is ours.
+ */
+
+char *
+NET_AdrToString ( netadr_t a )
+{
+	static char s [ 64 ];
+
+	Com_sprintf( s, sizeof( s ), "%i.%i.%i.%i:%i", a.ip [ 0 ], a.ip [ 1 ],
+			a.ip [ 2 ], a.ip [ 3 ], ntohs( a.port ) );
+
+	return ( s );
+}
+
+void
+NET_SendPacket ( netsrc_t sock, int length, void *data, netadr_t to )
+{
+	struct sockaddr_in addr;
+
+	memset( &addr, 0, sizeof( addr ) );
+	addr.sin_family = AF_INET;
+	addr.sin_port = to.port;
+	memcpy( &addr.sin_addr, to.ip, 4 );
+
+	if ( sendto( lg_current->socket, data, length, 0,
+				 (struct sockaddr *) &addr, sizeof( addr ) ) == -1 )
+	{
+		if ( lg_verbose )
+		{
+			Com_Printf( "sendto: %s\n", strerror( errno ) );
+		}
+
+		return;
+	}
+
+	lg_interval.bytesout += length;
+}
+
+/* ======================================================================= */
+
+static qboolean
+LG_StringToAdr ( char *s, netadr_t *a )
+{
+	struct addrinfo hints, *res;
+	char host [ 256 ];
+	char *port;
+
+	Com_sprintf( host, sizeof( host ), "%s", s );
+	port = strchr( host, ':' );
+
+	if ( port )
+	{
+		*port++ = 0;
+	}
+
+	memset( &hints, 0, sizeof( hints ) );
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+
+	if ( getaddrinfo( host, NULL, &hints, &res ) )
+	{
+		return ( false );
+	}
+
+	memset( a, 0, sizeof( *a ) );
+	a->type = NA_IP;
+	memcpy( a->ip, &( (struct sockaddr_in *) res->ai_addr )->sin_addr, 4 );
+	a->port = htons( port ? atoi( port ) : PORT_SERVER );
+
+	freeaddrinfo( res );
+
+	return ( true );
+}
+
+static void
+LG_Disconnect ( fakeclient_t *cl )
+{
+	byte final [ 32 ];
+	int i;
+
+	if ( cl->state >= LG_CONNECTED )
+	{
+		final [ 0 ] = clc_stringcmd;
+		strcpy( (char *) final + 1, "disconnect" );
+
+		lg_current = cl;
+		qport->value = cl->qport;
+
+		for ( i = 0; i < 3; i++ )
+		{
+			Netchan_Transmit( &cl->netchan, strlen( (char *) final ), final );
+		}
+	}
+
+	cl->state = LG_IDLE;
+}
+
+/*
+ * Starts over with a getchallenge, from
+ * the beginning or after being dropped.
+ */
+static void
+LG_Connect ( fakeclient_t *cl )
+{
+	lg_current = cl;
+
+	cl->state = LG_CHALLENGE;
+	cl->lastconnect = curtime;
+	cl->serverframe = -1;
+	cl->downloading = false;
+
+	Netchan_OutOfBandPrint( NS_CLIENT, lg_server, "getchallenge\n" );
+}
+
+static void
+LG_SendConnect ( fakeclient_t *cl, int challenge )
+{
+	lg_current = cl;
+	cl->state = LG_CONNECTING;
+
+	Netchan_OutOfBandPrint( NS_CLIENT, lg_server,
+			"connect %i %i %i \"\\name\\loadgen%i\\skin\\male/grunt\\rate\\%i\\msg\\1\\hand\\2\\fov\\90\"%s%s\n",
+			PROTOCOL_VERSION, cl->qport, challenge, (int) ( cl - lg_clients ), lg_rate,
+			lg_fastconnect ? " fast" : "", lg_fragments ? " frag" : "" );
+}
+
+static void
+LG_ConnectionlessPacket ( fakeclient_t *cl )
+{
+	char *s, *c;
+
+	MSG_BeginReading( &net_message );
+	MSG_ReadLong( &net_message );
+
+	s = MSG_ReadStringLine( &net_message );
+	Cmd_TokenizeString( s, false );
+	c = Cmd_Argv( 0 );
+
+	if ( !strcmp( c, "challenge" ) && ( cl->state == LG_CHALLENGE ) )
+	{
+		LG_SendConnect( cl, atoi( Cmd_Argv( 1 ) ) );
+	}
+	else if ( !strcmp( c, "client_connect" ) && ( cl->state == LG_CONNECTING ) )
+	{
+		Netchan_Setup( NS_CLIENT, &cl->netchan, net_from, cl->qport );
+
+		if ( !strcmp( Cmd_Argv( 1 ), "frag" ) )
+		{
+			Netchan_EnableFragments( &cl->netchan );
+		}
+
+		MSG_WriteChar( &cl->netchan.message, clc_stringcmd );
+		MSG_WriteString( &cl->netchan.message, "new" );
+		cl->state = LG_CONNECTED;
+	}
+	else if ( !strcmp( c, "print" ) )
+	{
+		if ( lg_verbose )
+		{
+			Com_Printf( "%i: %s", (int) ( cl - lg_clients ), MSG_ReadString( &net_message ) );
+		}
+	}
+}
+
+static void
+LG_BeginDownload ( fakeclient_t *cl, char *spawncount )
+{
+	Com_sprintf( cl->spawncount, sizeof( cl->spawncount ), "%s", spawncount );
+
+	cl->downloading = true;
+	cl->downloadstart = curtime;
+	cl->downloadcount = cl->downloadacked = 0;
+	cl->aheadchanged = false;
+	memset( cl->ahead, 0, sizeof( cl->ahead ) );
+
+	MSG_WriteByte( &cl->netchan.message, clc_stringcmd );
+
+	if ( lg_downloadrate )
+	{
+		MSG_WriteString( &cl->netchan.message, va( "download %s 0 %i 1", lg_download, lg_downloadrate ) );
+	}
+	else
+	{
+		MSG_WriteString( &cl->netchan.message, va( "download %s", lg_download ) );
+	}
+}
+
+static void
+LG_FinishDownload ( fakeclient_t *cl, qboolean ok )
+{
+	if ( ok )
+	{
+		lg_interval.downloads++;
+		lg_interval.downloadtime += curtime - cl->downloadstart;
+	}
+	else
+	{
+		Com_Printf( "%i: server doesn't have %s\n", (int) ( cl - lg_clients ), lg_download );
+	}
+
+	cl->downloading = false;
+	cl->downloaded = true;
+
+	MSG_WriteByte( &cl->netchan.message, clc_stringcmd );
+	MSG_WriteString( &cl->netchan.message, va( "begin %s\n", cl->spawncount ) );
+}
+
+/*
+ * Like CL_ParseDownload, one block per nextdl.
+ */
+static void
+LG_ParseDownload ( fakeclient_t *cl )
+{
+	int size, percent;
+
+	size = MSG_ReadShort( &net_message );
+	percent = MSG_ReadByte( &net_message );
+	net_message.readcount += size > 0 ? size : 0;
+
+	if ( !cl->downloading )
+	{
+		return;
+	}
+
+	if ( size == -1 )
+	{
+		LG_FinishDownload( cl, false );
+	}
+	else if ( percent == 100 )
+	{
+		LG_FinishDownload( cl, true );
+	}
+	else
+	{
+		MSG_WriteByte( &cl->netchan.message, clc_stringcmd );
+		MSG_WriteString( &cl->netchan.message, "nextdl" );
+	}
+}
+
+/*
+ * Like CL_ParseDownloadBlock, acked by LG_SendCmd.
+ */
+static void
+LG_ParseDownloadBlock ( fakeclient_t *cl )
+{
+	int size, offset, length;
+	int block;
+
+	MSG_ReadByte( &net_message );
+	size = MSG_ReadLong( &net_message );
+	offset = MSG_ReadLong( &net_message );
+	length = MSG_ReadShort( &net_message );
+	net_message.readcount += length > 0 ? length : 0;
+
+	if ( !cl->downloading || ( offset < cl->downloadcount ) )
+	{
+		return;
+	}
+
+	block = offset / DOWNLOAD_BLOCKSIZE;
+
+	if ( offset > cl->downloadcount )
+	{
+		if ( offset - cl->downloadcount < DOWNLOAD_WINDOW * DOWNLOAD_BLOCKSIZE )
+		{
+			cl->ahead [ block % DOWNLOAD_WINDOW ] = block + 1;
+			cl->aheadchanged = true;
+		}
+
+		return;
+	}
+
+	cl->downloadcount += length;
+
+	/* every block but the last is a full one */
+	for ( block++; cl->ahead [ block % DOWNLOAD_WINDOW ] == block + 1; block++ )
+	{
+		cl->ahead [ block % DOWNLOAD_WINDOW ] = 0;
+		cl->downloadcount = block * DOWNLOAD_BLOCKSIZE + DOWNLOAD_BLOCKSIZE;
+	}
+
+	if ( cl->downloadcount > size )
+	{
+		cl->downloadcount = size;
+	}
+
+	if ( cl->downloadcount >= size )
+	{
+		MSG_WriteByte( &cl->netchan.message, clc_stringcmd );
+		MSG_WriteString( &cl->netchan.message, va( "nextdl %i 1", size ) );
+		LG_FinishDownload( cl, true );
+	}
+}
+
+/*
+ * Runs what the server stuffed into our
+ * console, as far as the handshake needs it.
+ */
+static void
+LG_StuffText ( fakeclient_t *cl, char *text )
+{
+	char line [ MAX_STRING_CHARS ];
+	char *end;
+	int length;
+
+	while ( *text )
+	{
+		end = strchr( text, '\n' );
+
+		if ( !end )
+		{
+			end = text + strlen( text );
+		}
+
+		length = end - text;
+
+		if ( length > sizeof( line ) - 1 )
+		{
+			length = sizeof( line ) - 1;
+		}
+
+		memcpy( line, text, length );
+		line [ length ] = 0;
+		text = *end ? end + 1 : end;
+
+		Cmd_TokenizeString( line, false );
+
+		if ( !strcmp( Cmd_Argv( 0 ), "cmd" ) )
+		{
+			MSG_WriteByte( &cl->netchan.message, clc_stringcmd );
+			MSG_WriteString( &cl->netchan.message, Cmd_Args() );
+		}
+		else if ( !strcmp( Cmd_Argv( 0 ), "precache" ) )
+		{
+			if ( lg_download && !cl->downloaded )
+			{
+				LG_BeginDownload( cl, Cmd_Argv( 1 ) );
+			}
+			else
+			{
+				MSG_WriteByte( &cl->netchan.message, clc_stringcmd );
+				MSG_WriteString( &cl->netchan.message, va( "begin %s\n", Cmd_Argv( 1 ) ) );
+			}
+		}
+		else if ( !strcmp( Cmd_Argv( 0 ), "changing" ) )
+		{
+			cl->state = LG_CONNECTED;
+			cl->serverframe = -1;
+		}
+		else if ( !strcmp( Cmd_Argv( 0 ), "reconnect" ) )
+		{
+			cl->state = LG_CONNECTED;
+			cl->serverframe = -1;
+			MSG_WriteChar( &cl->netchan.message, clc_stringcmd );
+			MSG_WriteString( &cl->netchan.message, "new" );
+		}
+	}
+}
+
+/*
+ * The fields of an entity delta, see CL_ParseDelta.
+ */
+static void
+LG_SkipEntity ( unsigned bits )
+{
+	vec3_t v;
+
+	if ( bits & U_MODEL )
+	{
+		MSG_ReadByte( &net_message );
+	}
+
+	if ( bits & U_MODEL2 )
+	{
+		MSG_ReadByte( &net_message );
+	}
+
+	if ( bits & U_MODEL3 )
+	{
+		MSG_ReadByte( &net_message );
+	}
+
+	if ( bits & U_MODEL4 )
+	{
+		MSG_ReadByte( &net_message );
+	}
+
+	if ( bits & U_FRAME8 )
+	{
+		MSG_ReadByte( &net_message );
+	}
+
+	if ( bits & U_FRAME16 )
+	{
+		MSG_ReadShort( &net_message );
+	}
+
+	if ( ( bits & U_SKIN8 ) && ( bits & U_SKIN16 ) )
+	{
+		MSG_ReadLong( &net_message );
+	}
+	else if ( bits & U_SKIN8 )
+	{
+		MSG_ReadByte( &net_message );
+	}
+	else if ( bits & U_SKIN16 )
+	{
+		MSG_ReadShort( &net_message );
+	}
+
+	if ( ( bits & ( U_EFFECTS8 | U_EFFECTS16 ) ) == ( U_EFFECTS8 | U_EFFECTS16 ) )
+	{
+		MSG_ReadLong( &net_message );
+	}
+	else if ( bits & U_EFFECTS8 )
+	{
+		MSG_ReadByte( &net_message );
+	}
+	else if ( bits & U_EFFECTS16 )
+	{
+		MSG_ReadShort( &net_message );
+	}
+
+	if ( ( bits & ( U_RENDERFX8 | U_RENDERFX16 ) ) == ( U_RENDERFX8 | U_RENDERFX16 ) )
+	{
+		MSG_ReadLong( &net_message );
+	}
+	else if ( bits & U_RENDERFX8 )
+	{
+		MSG_ReadByte( &net_message );
+	}
+	else if ( bits & U_RENDERFX16 )
+	{
+		MSG_ReadShort( &net_message );
+	}
+
+	if ( bits & U_ORIGIN1 )
+	{
+		MSG_ReadCoord( &net_message );
+	}
+
+	if ( bits & U_ORIGIN2 )
+	{
+		MSG_ReadCoord( &net_message );
+	}
+
+	if ( bits & U_ORIGIN3 )
+	{
+		MSG_ReadCoord( &net_message );
+	}
+
+	if ( bits & U_ANGLE1 )
+	{
+		MSG_ReadAngle( &net_message );
+	}
+
+	if ( bits & U_ANGLE2 )
+	{
+		MSG_ReadAngle( &net_message );
+	}
+
+	if ( bits & U_ANGLE3 )
+	{
+		MSG_ReadAngle( &net_message );
+	}
+
+	if ( bits & U_OLDORIGIN )
+	{
+		MSG_ReadPos( &net_message, v );
+	}
+
+	if ( bits & U_SOUND )
+	{
+		MSG_ReadByte( &net_message );
+	}
+
+	if ( bits & U_EVENT )
+	{
+		MSG_ReadByte( &net_message );
+	}
+
+	if ( bits & U_SOLID )
+	{
+		MSG_ReadShort( &net_message );
+	}
+}
+
+/*
+ * See CL_ParseEntityBits.
+ */
+static int
+LG_ParseEntityBits ( unsigned *bits )
+{
+	unsigned total;
+
+	total = MSG_ReadByte( &net_message );
+
+	if ( total & U_MOREBITS1 )
+	{
+		total |= MSG_ReadByte( &net_message ) << 8;
+	}
+
+	if ( total & U_MOREBITS2 )
+	{
+		total |= MSG_ReadByte( &net_message ) << 16;
+	}
+
+	if ( total & U_MOREBITS3 )
+	{
+		total |= MSG_ReadByte( &net_message ) << 24;
+	}
+
+	*bits = total;
+
+	if ( total & U_NUMBER16 )
+	{
+		return ( MSG_ReadShort( &net_message ) );
+	}
+
+	return ( MSG_ReadByte( &net_message ) );
+}
+
+/*
+ * See CL_ParsePlayerstate.
+ */
+static void
+LG_SkipPlayerstate ( void )
+{
+	int flags, statbits;
+	int i;
+
+	flags = MSG_ReadShort( &net_message );
+
+	if ( flags & PS_M_TYPE )
+	{
+		MSG_ReadByte( &net_message );
+	}
+
+	if ( flags & PS_M_ORIGIN )
+	{
+		net_message.readcount += 6;
+	}
+
+	if ( flags & PS_M_VELOCITY )
+	{
+		net_message.readcount += 6;
+	}
+
+	if ( flags & PS_M_TIME )
+	{
+		MSG_ReadByte( &net_message );
+	}
+
+	if ( flags & PS_M_FLAGS )
+	{
+		MSG_ReadByte( &net_message );
+	}
+
+	if ( flags & PS_M_GRAVITY )
+	{
+		MSG_ReadShort( &net_message );
+	}
+
+	if ( flags & PS_M_DELTA_ANGLES )
+	{
+		net_message.readcount += 6;
+	}
+
+	if ( flags & PS_VIEWOFFSET )
+	{
+		net_message.readcount += 3;
+	}
+
+	if ( flags & PS_VIEWANGLES )
+	{
+		net_message.readcount += 6;
+	}
+
+	if ( flags & PS_KICKANGLES )
+	{
+		net_message.readcount += 3;
+	}
+
+	if ( flags & PS_WEAPONINDEX )
+	{
+		MSG_ReadByte( &net_message );
+	}
+
+	if ( flags & PS_WEAPONFRAME )
+	{
+		net_message.readcount += 7;
+	}
+
+	if ( flags & PS_BLEND )
+	{
+		net_message.readcount += 4;
+	}
+
+	if ( flags & PS_FOV )
+	{
+		MSG_ReadByte( &net_message );
+	}
+
+	if ( flags & PS_RDFLAGS )
+	{
+		MSG_ReadByte( &net_message );
+	}
+
+	statbits = MSG_ReadLong( &net_message );
+
+	for ( i = 0; i < MAX_STATS; i++ )
+	{
+		if ( statbits & ( 1 << i ) )
+		{
+			MSG_ReadShort( &net_message );
+		}
+	}
+}
+
+/*
+ * The layout of each temp entity as in CL_ParseTEnt.
+ * p is a position, d a direction, b a byte, s a short
+ * and l a long. Returns false for an unknown type.
+ */
+static qboolean
+LG_SkipTempEntity ( void )
+{
+	const char *layout;
+	int type;
+
+	type = MSG_ReadByte( &net_message );
+
+	switch ( type )
+	{
+		case TE_BLOOD:
+		case TE_GUNSHOT:
+		case TE_SPARKS:
+		case TE_BULLET_SPARKS:
+		case TE_SCREEN_SPARKS:
+		case TE_SHIELD_SPARKS:
+		case TE_SHOTGUN:
+		case TE_BLASTER:
+		case TE_GREENBLOOD:
+		case TE_BLASTER2:
+		case TE_FLECHETTE:
+		case TE_HEATBEAM_SPARKS:
+		case TE_HEATBEAM_STEAM:
+		case TE_MOREBLOOD:
+		case TE_ELECTRIC_SPARKS:
+			layout = "pd";
+			break;
+
+		case TE_SPLASH:
+		case TE_LASER_SPARKS:
+		case TE_WELDING_SPARKS:
+		case TE_TUNNEL_SPARKS:
+			layout = "bpdb";
+			break;
+
+		case TE_BLUEHYPERBLASTER:
+		case TE_RAILTRAIL:
+		case TE_BUBBLETRAIL:
+		case TE_DEBUGTRAIL:
+		case TE_BUBBLETRAIL2:
+		case TE_BFG_LASER:
+			layout = "pp";
+			break;
+
+		case TE_EXPLOSION2:
+		case TE_GRENADE_EXPLOSION:
+		case TE_GRENADE_EXPLOSION_WATER:
+		case TE_PLASMA_EXPLOSION:
+		case TE_EXPLOSION1_BIG:
+		case TE_EXPLOSION1_NP:
+		case TE_EXPLOSION1:
+		case TE_ROCKET_EXPLOSION:
+		case TE_ROCKET_EXPLOSION_WATER:
+		case TE_BFG_EXPLOSION:
+		case TE_BFG_BIGEXPLOSION:
+		case TE_BOSSTPORT:
+		case TE_PLAIN_EXPLOSION:
+		case TE_CHAINFIST_SMOKE:
+		case TE_TRACKER_EXPLOSION:
+		case TE_TELEPORT_EFFECT:
+		case TE_DBALL_GOAL:
+		case TE_WIDOWSPLASH:
+		case TE_NUKEBLAST:
+			layout = "p";
+			break;
+
+		case TE_PARASITE_ATTACK:
+		case TE_MEDIC_CABLE_ATTACK:
+		case TE_HEATBEAM:
+		case TE_MONSTER_HEATBEAM:
+			layout = "spp";
+			break;
+
+		case TE_GRAPPLE_CABLE:
+			layout = "sppp";
+			break;
+
+		case TE_LIGHTNING:
+			layout = "sspp";
+			break;
+
+		case TE_FLASHLIGHT:
+			layout = "ps";
+			break;
+
+		case TE_FORCEWALL:
+			layout = "ppb";
+			break;
+
+		case TE_WIDOWBEAMOUT:
+			layout = "sp";
+			break;
+
+		case TE_STEAM:
+			layout = MSG_ReadShort( &net_message ) != -1 ? "bpdbsl" : "bpdbs";
+			break;
+
+		default:
+			return ( false );
+	}
+
+	for ( ; *layout; layout++ )
+	{
+		switch ( *layout )
+		{
+			case 'p':
+				net_message.readcount += 6;
+				break;
+			case 'd':
+			case 'b':
+				net_message.readcount += 1;
+				break;
+			case 's':
+				net_message.readcount += 2;
+				break;
+			case 'l':
+				net_message.readcount += 4;
+				break;
+		}
+	}
+
+	return ( true );
+}
+
+static void
+LG_ParseFrame ( fakeclient_t *cl )
+{
+	unsigned bits;
+	int number;
+	int ack, latency;
+
+	cl->serverframe = MSG_ReadLong( &net_message );
+	MSG_ReadLong( &net_message );   /* delta frame */
+	MSG_ReadByte( &net_message );   /* suppress count */
+
+	/* area bits */
+	net_message.readcount += MSG_ReadByte( &net_message );
+
+	if ( MSG_ReadByte( &net_message ) != svc_playerinfo )
+	{
+		Com_Printf( "%i: frame without playerinfo\n", (int) ( cl - lg_clients ) );
+		net_message.readcount = net_message.cursize + 1;
+		return;
+	}
+
+	LG_SkipPlayerstate();
+
+	if ( MSG_ReadByte( &net_message ) != svc_packetentities )
+	{
+		Com_Printf( "%i: frame without packetentities\n", (int) ( cl - lg_clients ) );
+		net_message.readcount = net_message.cursize + 1;
+		return;
+	}
+
+	while ( net_message.readcount <= net_message.cursize )
+	{
+		number = LG_ParseEntityBits( &bits );
+
+		if ( !number )
+		{
+			break;
+		}
+
+		if ( !( bits & U_REMOVE ) )
+		{
+			LG_SkipEntity( bits );
+		}
+	}
+
+	if ( cl->state != LG_ACTIVE )
+	{
+		cl->state = LG_ACTIVE;
+		lg_interval.connects++;
+		lg_interval.connecttime += curtime - cl->connectstart;
+	}
+
+	/* same as the netgraph ping: the time since the
+	   last move the server has seen was sent */
+	ack = cl->netchan.incoming_acknowledged & ( LG_CMD_BACKUP - 1 );
+
+	if ( cl->cmdtime [ ack ] )
+	{
+		latency = curtime - cl->cmdtime [ ack ];
+
+		if ( latency >= LG_MAXLATENCY )
+		{
+			latency = LG_MAXLATENCY - 1;
+		}
+
+		lg_interval.latency [ latency ]++;
+		lg_interval.numlatency++;
+	}
+
+	lg_interval.frames++;
+}
+
+/*
+ * Walks through a server message like
+ * CL_ParseServerMessage, without keeping any of it.
+ */
+static void
+LG_ParseServerMessage ( fakeclient_t *cl )
+{
+	unsigned bits;
+	int cmd;
+	int size;
+
+	while ( 1 )
+	{
+		if ( net_message.readcount > net_message.cursize )
+		{
+			Com_Printf( "%i: bad server message\n", (int) ( cl - lg_clients ) );
+			LG_Connect( cl );
+			return;
+		}
+
+		cmd = MSG_ReadByte( &net_message );
+
+		if ( cmd == -1 )
+		{
+			return;
+		}
+
+		switch ( cmd )
+		{
+			case svc_nop:
+				break;
+
+			case svc_disconnect:
+				lg_interval.disconnects++;
+				LG_Connect( cl );
+				return;
+
+			case svc_reconnect:
+				LG_Connect( cl );
+				return;
+
+			case svc_print:
+				MSG_ReadByte( &net_message );
+				MSG_ReadString( &net_message );
+				break;
+
+			case svc_centerprint:
+			case svc_layout:
+				MSG_ReadString( &net_message );
+				break;
+
+			case svc_stufftext:
+				LG_StuffText( cl, MSG_ReadString( &net_message ) );
+				break;
+
+			case svc_serverdata:
+				MSG_ReadLong( &net_message );
+				MSG_ReadLong( &net_message );
+				MSG_ReadByte( &net_message );
+				MSG_ReadString( &net_message );
+				MSG_ReadShort( &net_message );
+				MSG_ReadString( &net_message );
+				cl->state = LG_CONNECTED;
+				cl->serverframe = -1;
+				break;
+
+			case svc_configstring:
+				MSG_ReadShort( &net_message );
+				MSG_ReadString( &net_message );
+				break;
+
+			case svc_sound:
+				bits = MSG_ReadByte( &net_message );
+				MSG_ReadByte( &net_message );
+				net_message.readcount += ( bits & SND_VOLUME ? 1 : 0 ) +
+										 ( bits & SND_ATTENUATION ? 1 : 0 ) +
+										 ( bits & SND_OFFSET ? 1 : 0 ) +
+										 ( bits & SND_ENT ? 2 : 0 ) +
+										 ( bits & SND_POS ? 6 : 0 );
+				break;
+
+			case svc_spawnbaseline:
+				LG_ParseEntityBits( &bits );
+				LG_SkipEntity( bits );
+				break;
+
+			case svc_temp_entity:
+
+				if ( !LG_SkipTempEntity() )
+				{
+					Com_Printf( "%i: bad temp entity\n", (int) ( cl - lg_clients ) );
+					return;
+				}
+
+				break;
+
+			case svc_muzzleflash:
+			case svc_muzzleflash2:
+				MSG_ReadShort( &net_message );
+				MSG_ReadByte( &net_message );
+				break;
+
+			case svc_download:
+				LG_ParseDownload( cl );
+				break;
+
+			case svc_downloadblock:
+				LG_ParseDownloadBlock( cl );
+				break;
+
+			case svc_frame:
+				LG_ParseFrame( cl );
+				break;
+
+			case svc_gamestate:
+				net_message.readcount += 12;
+				size = MSG_ReadShort( &net_message );
+				net_message.readcount += size > 0 ? size : 0;
+
+				/* ack it at once like the client */
+				MSG_WriteByte( &cl->netchan.message, clc_nop );
+				break;
+
+			case svc_inventory:
+				net_message.readcount += MAX_ITEMS * 2;
+				break;
+
+			default:
+				Com_Printf( "%i: illegible server message %i\n", (int) ( cl - lg_clients ), cmd );
+				return;
+		}
+	}
+}
+
+static void
+LG_ReadPackets ( fakeclient_t *cl )
+{
+	struct sockaddr_in from;
+	socklen_t fromlen;
+	int ret;
+
+	while ( 1 )
+	{
+		fromlen = sizeof( from );
+		ret = recvfrom( cl->socket, net_message.data, net_message.maxsize, 0,
+				(struct sockaddr *) &from, &fromlen );
+
+		if ( ret <= 0 )
+		{
+			return;
+		}
+
+		memset( &net_from, 0, sizeof( net_from ) );
+		net_from.type = NA_IP;
+		memcpy( net_from.ip, &from.sin_addr, 4 );
+		net_from.port = from.sin_port;
+
+		net_message.cursize = ret;
+		lg_current = cl;
+
+		if ( *(int *) net_message.data == -1 )
+		{
+			LG_ConnectionlessPacket( cl );
+			continue;
+		}
+
+		if ( ( cl->state < LG_CONNECTED ) || ( ret < 8 ) )
+		{
+			continue;
+		}
+
+		lg_interval.bytesin += ret;
+		lg_interval.packets++;
+
+		if ( !Netchan_Process( &cl->netchan, &net_message ) )
+		{
+			continue;
+		}
+
+		lg_interval.dropped += cl->netchan.dropped;
+
+		LG_ParseServerMessage( cl );
+	}
+}
+
+/*
+ * A random walk: mostly forward, some
+ * strafing, turning, jumping and firing.
+ */
+static void
+LG_CreateCmd ( fakeclient_t *cl, usercmd_t *cmd )
+{
+	short *line;
+
+	memset( cmd, 0, sizeof( *cmd ) );
+	cmd->msec = lg_fps > 4 ? 1000 / lg_fps : 250;
+
+	if ( lg_numscript )
+	{
+		line = lg_script [ cl->scriptline++ % lg_numscript ];
+
+		cmd->forwardmove = line [ 0 ];
+		cmd->sidemove = line [ 1 ];
+		cmd->upmove = line [ 2 ];
+		cmd->angles [ PITCH ] = ANGLE2SHORT( line [ 3 ] );
+		cmd->angles [ YAW ] = ANGLE2SHORT( cl->yaw + line [ 4 ] );
+		cmd->buttons = line [ 5 ];
+		return;
+	}
+
+	cl->yaw += ( rand() % 31 ) - 15;
+
+	cmd->forwardmove = ( rand() % 8 ) ? 400 : -200;
+	cmd->sidemove = ( rand() % 4 ) ? 0 : ( ( rand() & 1 ) ? 200 : -200 );
+	cmd->upmove = ( rand() % 20 ) ? 0 : 200;
+	cmd->angles [ YAW ] = ANGLE2SHORT( cl->yaw );
+
+	if ( rand() % 100 < lg_attack )
+	{
+		cmd->buttons = BUTTON_ATTACK;
+	}
+}
+
+/*
+ * See CL_WriteDownloadAck.
+ */
+static void
+LG_WriteDownloadAck ( fakeclient_t *cl, sizebuf_t *buf )
+{
+	char received [ DOWNLOAD_WINDOW / 4 + 2 ];
+	int block, length;
+	int n;
+
+	block = cl->downloadcount / DOWNLOAD_BLOCKSIZE;
+	memset( received, 0, sizeof( received ) );
+	received [ 0 ] = ' ';
+	length = 0;
+
+	for ( n = 1; n < DOWNLOAD_WINDOW; n++ )
+	{
+		if ( cl->ahead [ ( block + n ) % DOWNLOAD_WINDOW ] == block + n + 1 )
+		{
+			received [ 1 + n / 4 ] |= 1 << ( n % 4 );
+			length = n / 4 + 1;
+		}
+	}
+
+	for ( n = 1; n <= length; n++ )
+	{
+		received [ n ] = "0123456789abcdef" [ (int) received [ n ] ];
+	}
+
+	received [ length + 1 ] = 0;
+
+	MSG_WriteByte( buf, clc_stringcmd );
+	MSG_WriteString( buf, va( "nextdl %i 1%s", cl->downloadcount, length ? received : "" ) );
+
+	cl->downloadacked = cl->downloadcount;
+	cl->downloadacktime = curtime;
+	cl->aheadchanged = false;
+}
+
+/*
+ * Like CL_SendCmd: keeps the netchan alive while loading
+ * and sends the last three moves once in the game.
+ */
+static void
+LG_SendCmd ( fakeclient_t *cl )
+{
+	sizebuf_t buf;
+	byte data [ 128 ];
+	usercmd_t nullcmd;
+	usercmd_t *cmd, *oldcmd;
+	int checksumindex;
+	int i;
+
+	lg_current = cl;
+	qport->value = cl->qport;
+
+	if ( cl->state == LG_CONNECTED )
+	{
+		SZ_Init( &buf, data, sizeof( data ) );
+
+		if ( cl->downloading && ( cl->downloadcount || cl->aheadchanged ) &&
+			 ( ( cl->downloadcount != cl->downloadacked ) || cl->aheadchanged ||
+			   ( curtime - cl->downloadacktime >= 100 ) ) )
+		{
+			LG_WriteDownloadAck( cl, &buf );
+		}
+
+		if ( buf.cursize || cl->netchan.message.cursize || ( curtime - cl->netchan.last_sent > 100 ) )
+		{
+			Netchan_Transmit( &cl->netchan, buf.cursize, buf.data );
+		}
+
+		return;
+	}
+
+	i = cl->netchan.outgoing_sequence & ( LG_CMD_BACKUP - 1 );
+	LG_CreateCmd( cl, &cl->cmds [ i ] );
+	cl->cmdtime [ i ] = curtime;
+
+	SZ_Init( &buf, data, sizeof( data ) );
+
+	MSG_WriteByte( &buf, clc_move );
+	checksumindex = buf.cursize;
+	MSG_WriteByte( &buf, 0 );
+	MSG_WriteLong( &buf, cl->serverframe );
+
+	memset( &nullcmd, 0, sizeof( nullcmd ) );
+	oldcmd = &nullcmd;
+
+	for ( i = 2; i >= 0; i-- )
+	{
+		cmd = &cl->cmds [ ( cl->netchan.outgoing_sequence - i ) & ( LG_CMD_BACKUP - 1 ) ];
+		MSG_WriteDeltaUsercmd( &buf, oldcmd, cmd );
+		oldcmd = cmd;
+	}
+
+	buf.data [ checksumindex ] = COM_BlockSequenceCRCByte(
+			buf.data + checksumindex + 1, buf.cursize - checksumindex - 1,
+			cl->netchan.outgoing_sequence );
+
+	Netchan_Transmit( &cl->netchan, buf.cursize, buf.data );
+}
+
+static qboolean
+LG_OpenSocket ( fakeclient_t *cl )
+{
+	struct sockaddr_in addr;
+
+	cl->socket = socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+
+	if ( cl->socket == -1 )
+	{
+		Com_Printf( "socket: %s\n", strerror( errno ) );
+		return ( false );
+	}
+
+	memset( &addr, 0, sizeof( addr ) );
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = INADDR_ANY;
+
+	if ( ( bind( cl->socket, (struct sockaddr *) &addr, sizeof( addr ) ) == -1 ) ||
+		 ( fcntl( cl->socket, F_SETFL, fcntl( cl->socket, F_GETFL, 0 ) | O_NONBLOCK ) == -1 ) )
+	{
+		Com_Printf( "socket: %s\n", strerror( errno ) );
+		close( cl->socket );
+		return ( false );
+	}
+
+	return ( true );
+}
+
+static void
+LG_LoadScript ( char *name )
+{
+	char line [ 256 ];
+	FILE *f;
+	int v [ 6 ];
+
+	f = fopen( name, "r" );
+
+	if ( !f )
+	{
+		Com_Error( ERR_FATAL, "Couldn't open %s", name );
+	}
+
+	while ( fgets( line, sizeof( line ), f ) && ( lg_numscript < MAX_SCRIPTLINES ) )
+	{
+		if ( sscanf( line, "%i %i %i %i %i %i", &v [ 0 ], &v [ 1 ], &v [ 2 ],
+					 &v [ 3 ], &v [ 4 ], &v [ 5 ] ) == 6 )
+		{
+			lg_script [ lg_numscript ] [ 0 ] = v [ 0 ];
+			lg_script [ lg_numscript ] [ 1 ] = v [ 1 ];
+			lg_script [ lg_numscript ] [ 2 ] = v [ 2 ];
+			lg_script [ lg_numscript ] [ 3 ] = v [ 3 ];
+			lg_script [ lg_numscript ] [ 4 ] = v [ 4 ];
+			lg_script [ lg_numscript ] [ 5 ] = v [ 5 ];
+			lg_numscript++;
+		}
+	}
+
+	fclose( f );
+
+	if ( !lg_numscript )
+	{
+		Com_Error( ERR_FATAL, "%s has no usercmds", name );
+	}
+}
+
+/*
+ * Returns the latency below which
+ * the given fraction of frames arrived.
+ */
+static int
+LG_Percentile ( lgstats_t *stats, float fraction )
+{
+	int i, sum;
+
+	for ( i = 0, sum = 0; i < LG_MAXLATENCY; i++ )
+	{
+		sum += stats->latency [ i ];
+
+		if ( sum > stats->numlatency * fraction )
+		{
+			return ( i );
+		}
+	}
+
+	return ( LG_MAXLATENCY - 1 );
+}
+
+static void
+LG_PrintStats ( lgstats_t *stats, float seconds, int elapsed )
+{
+	int active, i;
+
+	for ( i = 0, active = 0; i < lg_numclients; i++ )
+	{
+		if ( lg_clients [ i ].state == LG_ACTIVE )
+		{
+			active++;
+		}
+	}
+
+	Com_Printf( "%5is %4i/%i active  server out %8.1f kbit/s (%5.1f/client) in %7.1f kbit/s  "
+			"%5.1f frames/s/client  loss %5.2f%%  latency p50 %3i p99 %3i ms",
+			elapsed / 1000, active, lg_numclients,
+			stats->bytesin * 8 / 1000.0f / seconds,
+			active ? stats->bytesin * 8 / 1000.0f / seconds / active : 0,
+			stats->bytesout * 8 / 1000.0f / seconds,
+			active ? stats->frames / seconds / active : 0,
+			stats->packets ? 100.0f * stats->dropped / ( stats->packets + stats->dropped ) : 0,
+			LG_Percentile( stats, 0.5f ), LG_Percentile( stats, 0.99f ) );
+
+	if ( stats->connects )
+	{
+		Com_Printf( "  %i joined in %i ms avg", stats->connects,
+				(int) ( stats->connecttime / stats->connects ) );
+	}
+
+	if ( stats->disconnects )
+	{
+		Com_Printf( "  %i dropped", stats->disconnects );
+	}
+
+	if ( stats->downloads )
+	{
+		Com_Printf( "  %i downloaded in %i ms avg", stats->downloads,
+				(int) ( stats->downloadtime / stats->downloads ) );
+	}
+
+	Com_Printf( "\n" );
+}
+
+static void
+LG_AddStats ( lgstats_t *to, lgstats_t *from )
+{
+	int i;
+
+	to->bytesin += from->bytesin;
+	to->bytesout += from->bytesout;
+	to->packets += from->packets;
+	to->dropped += from->dropped;
+	to->frames += from->frames;
+	to->numlatency += from->numlatency;
+	to->connects += from->connects;
+	to->connecttime += from->connecttime;
+	to->disconnects += from->disconnects;
+	to->downloads += from->downloads;
+	to->downloadtime += from->downloadtime;
+
+	for ( i = 0; i < LG_MAXLATENCY; i++ )
+	{
+		to->latency [ i ] += from->latency [ i ];
+	}
+}
+
+static void
+LG_Usage ( void )
+{
+	printf( "Usage: loadgen [options] [server[:port]]\n" );
+	printf( "  -clients <n>      fake clients (default 16, server default localhost)\n" );
+	printf( "  -time <s>         seconds to run (default 60)\n" );
+	printf( "  -fps <n>          usercmds per second and client (default 30)\n" );
+	printf( "  -joinrate <n>     clients started per second (default 20)\n" );
+	printf( "  -attack <n>       percent of usercmds with fire pressed (default 10)\n" );
+	printf( "  -rate <n>         rate in the userinfo (default 25000)\n" );
+	printf( "  -script <file>    usercmds to loop instead of random ones, one per line:\n" );
+	printf( "                    forward side up pitch yaw buttons\n" );
+	printf( "  -report <s>       seconds between reports (default 5)\n" );
+	printf( "  -seed <n>         seed for the random usercmds\n" );
+	printf( "  -fastconnect      get the gamestate in one compressed piece\n" );
+	printf( "  -fragments        let the server send messages in fragments\n" );
+	printf( "  -loss <n>         percent of the sent packets to drop\n" );
+	printf( "  -download <file>  download a file before entering the game\n" );
+	printf( "  -downloadrate <n> bytes/s to stream it at, 0 for a block per nextdl\n" );
+	printf( "                    (default 1000000)\n" );
+	printf( "  -verbose          print what the server prints\n" );
+	exit( 2 );
+}
+
+int
+main ( int argc, char **argv )
+{
+	struct pollfd *fds;
+	char *server;
+	int duration, report, joinrate;
+	int start, now, nextcmd, nextreport, lastreport;
+	int started;
+	int i;
+
+	server = "localhost";
+	lg_numclients = 16;
+	duration = 60;
+	report = 5;
+	joinrate = 20;
+	lg_fps = 30;
+	lg_attack = 10;
+	lg_rate = 25000;
+	lg_downloadrate = 1000000;
+	srand( 1 );
+
+	z_chain.next = z_chain.prev = &z_chain;
+
+	Swap_Init();
+	Cmd_Init();
+	Cvar_Init();
+	Netchan_Init();
+	SZ_Init( &net_message, net_message_buffer, sizeof( net_message_buffer ) );
+
+	for ( i = 1; i < argc; i++ )
+	{
+		if ( argv [ i ] [ 0 ] != '-' )
+		{
+			server = argv [ i ];
+			continue;
+		}
+
+		if ( !strcmp( argv [ i ], "-verbose" ) )
+		{
+			lg_verbose = 1;
+			continue;
+		}
+
+		if ( !strcmp( argv [ i ], "-fastconnect" ) )
+		{
+			lg_fastconnect = 1;
+			continue;
+		}
+
+		if ( !strcmp( argv [ i ], "-fragments" ) )
+		{
+			lg_fragments = 1;
+			continue;
+		}
+
+		if ( i + 1 >= argc )
+		{
+			LG_Usage();
+		}
+
+		if ( !strcmp( argv [ i ], "-clients" ) )
+		{
+			lg_numclients = atoi( argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-time" ) )
+		{
+			duration = atoi( argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-fps" ) )
+		{
+			lg_fps = atoi( argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-joinrate" ) )
+		{
+			joinrate = atoi( argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-attack" ) )
+		{
+			lg_attack = atoi( argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-loss" ) )
+		{
+			Cvar_Set( "net_fakeloss", argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-download" ) )
+		{
+			lg_download = argv [ ++i ];
+		}
+		else if ( !strcmp( argv [ i ], "-downloadrate" ) )
+		{
+			lg_downloadrate = atoi( argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-rate" ) )
+		{
+			lg_rate = atoi( argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-script" ) )
+		{
+			LG_LoadScript( argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-report" ) )
+		{
+			report = atoi( argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-seed" ) )
+		{
+			srand( atoi( argv [ ++i ] ) );
+		}
+		else
+		{
+			LG_Usage();
+		}
+	}
+
+	if ( ( lg_numclients < 1 ) || ( lg_numclients > MAX_FAKECLIENTS ) ||
+		 ( lg_fps < 1 ) || ( joinrate < 1 ) || ( report < 1 ) )
+	{
+		LG_Usage();
+	}
+
+	if ( !LG_StringToAdr( server, &lg_server ) )
+	{
+		Com_Error( ERR_FATAL, "Bad server address %s", server );
+	}
+
+	lg_clients = calloc( lg_numclients, sizeof( fakeclient_t ) );
+	fds = calloc( lg_numclients, sizeof( struct pollfd ) );
+
+	for ( i = 0; i < lg_numclients; i++ )
+	{
+		if ( !LG_OpenSocket( &lg_clients [ i ] ) )
+		{
+			Com_Error( ERR_FATAL, "Couldn't open socket %i", i );
+		}
+
+		lg_clients [ i ].qport = ( rand() & 0x7fff ) + 1;
+		lg_clients [ i ].yaw = rand() % 360;
+		lg_clients [ i ].scriptline = i;
+
+		fds [ i ].fd = lg_clients [ i ].socket;
+		fds [ i ].events = POLLIN;
+	}
+
+	Com_Printf( "%i clients against %s for %i seconds.\n", lg_numclients,
+			NET_AdrToString( lg_server ), duration );
+
+	start = lastreport = nextcmd = Sys_Milliseconds();
+	nextreport = start + report * 1000;
+	started = 0;
+
+	while ( 1 )
+	{
+		now = Sys_Milliseconds();
+
+		if ( now - start >= duration * 1000 )
+		{
+			break;
+		}
+
+		/* start the clients one by one */
+		while ( ( started < lg_numclients ) &&
+				( started * 1000 / joinrate <= now - start ) )
+		{
+			lg_clients [ started ].connectstart = now;
+			LG_Connect( &lg_clients [ started ] );
+			started++;
+		}
+
+		poll( fds, lg_numclients, nextcmd > now ? nextcmd - now : 0 );
+		now = Sys_Milliseconds();
+
+		for ( i = 0; i < lg_numclients; i++ )
+		{
+			if ( fds [ i ].revents & POLLIN )
+			{
+				LG_ReadPackets( &lg_clients [ i ] );
+			}
+		}
+
+		if ( now >= nextcmd )
+		{
+			nextcmd += 1000 / lg_fps;
+
+			if ( nextcmd < now )
+			{
+				nextcmd = now;
+			}
+
+			for ( i = 0; i < started; i++ )
+			{
+				switch ( lg_clients [ i ].state )
+				{
+					case LG_CHALLENGE:
+					case LG_CONNECTING:
+
+						/* lost the challenge or the connect */
+						if ( now - lg_clients [ i ].lastconnect > 3000 )
+						{
+							LG_Connect( &lg_clients [ i ] );
+						}
+
+						break;
+
+					case LG_CONNECTED:
+					case LG_ACTIVE:
+
+						if ( now - lg_clients [ i ].netchan.last_received > 30000 )
+						{
+							Com_Printf( "%i: timed out\n", i );
+							lg_interval.disconnects++;
+							lg_clients [ i ].connectstart = now;
+							LG_Connect( &lg_clients [ i ] );
+							break;
+						}
+
+						LG_SendCmd( &lg_clients [ i ] );
+						break;
+
+					default:
+						break;
+				}
+			}
+		}
+
+		if ( now >= nextreport )
+		{
+			LG_PrintStats( &lg_interval, ( now - lastreport ) / 1000.0f, now - start );
+			LG_AddStats( &lg_total, &lg_interval );
+			memset( &lg_interval, 0, sizeof( lg_interval ) );
+			lastreport = now;
+			nextreport += report * 1000;
+		}
+	}
+
+	LG_AddStats( &lg_total, &lg_interval );
+
+	Com_Printf( "Total:\n" );
+	LG_PrintStats( &lg_total, ( now - start ) / 1000.0f, now - start );
+
+	if ( lg_fragments )
+	{
+		Com_Printf( "fragments: %i received, %i dropped\n",
+				net_fragments_received, net_fragments_dropped );
+	}
+
+	for ( i = 0; i < lg_numclients; i++ )
+	{
+		LG_Disconnect( &lg_clients [ i ] );
+		close( lg_clients [ i ].socket );
+	}
+
+	return ( 0 );
+}
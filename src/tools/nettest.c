@@ -0,0 +1,552 @@
+/*
+ * Copyright (C) 1997-2001 Id Software, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * =======================================================================
+ *
+ * A test of the netchan. A client and a server channel with fragments
+ * talk over an in-memory network that loses, reorders and duplicates
+ * packets. Both sides send reliable and unreliable messages of up to
+ * MAX_BIGMSGLEN, and every message that comes out of Netchan_Process
+ * is checked byte for byte against what was sent. Reliable messages
+ * must arrive exactly once and in order, unreliable ones at most once
+ * and in order. For a while the server is limited to MAX_MSGLEN like
+ * for a client recording a demo.
+ *
+ * Exits with 0 if everything arrived as it should, 1 otherwise.
+ *
+ * =======================================================================
+ */
+
+#include "../common/header/common.h"
+#include "../common/header/zone.h"
+
+#define MAX_QUEUED 4096
+#define NT_RELIABLE 1
+#define NT_UNRELIABLE 2
+#define NT_RECORDHEADER 7       /* kind, id, length */
+#define NT_MAXDRAIN 1000        /* ticks to get the reliable messages through */
+#define NT_FRAGMENTBIT 0x40     /* bit 30 of the sequence, in its last byte */
+
+typedef struct
+{
+	netsrc_t sock;          /* who sent it */
+	int deliver;            /* tick it arrives at */
+	int order;              /* sent as the n-th packet */
+	int length;
+	byte data [ MAX_MSGLEN ];
+} ntpacket_t;
+
+typedef struct
+{
+	netchan_t netchan;
+	int nextreliable;       /* id of the next message sent */
+	int nextunreliable;
+	int expectreliable;     /* id of the next message to arrive */
+	int lastunreliable;
+	int messages;           /* from Netchan_Process */
+	int reliables;
+	int unreliables;
+} ntside_t;
+
+extern zhead_t z_chain;
+extern qboolean stubs_quiet;
+
+static ntpacket_t nt_queue [ MAX_QUEUED ];
+static int nt_numqueued;
+static int nt_order;
+static int nt_tick;
+
+static ntside_t nt_client;
+static ntside_t nt_server;
+
+static int nt_loss;
+static int nt_reorder;
+static int nt_duplicate;
+static qboolean nt_limited;     /* server messages limited to MAX_MSGLEN */
+static qboolean nt_failed;
+
+static int nt_lost;
+static int nt_reordered;
+static int nt_duplicated;
+
+/* ======================================================================= */
+
+/*
+ * The part of network.c that netchan.c needs, the rest
+ * is in stubs.c. The network is ours and lives in
+ * nt_queue.
+ */
+
+char *
+NET_AdrToString ( netadr_t a )
+{
+	return ( "loopback" );
+}
+
+static void
+NT_Fail ( char *fmt, ... )
+{
+	va_list argptr;
+
+	va_start( argptr, fmt );
+	printf( "FAILED at tick %i: ", nt_tick );
+	vprintf( fmt, argptr );
+	printf( "\n" );
+	va_end( argptr );
+
+	nt_failed = true;
+}
+
+static void
+NT_Queue ( netsrc_t sock, int length, void *data, int deliver )
+{
+	ntpacket_t *p;
+
+	if ( nt_numqueued == MAX_QUEUED )
+	{
+		NT_Fail( "too many packets queued" );
+		return;
+	}
+
+	p = &nt_queue [ nt_numqueued++ ];
+	p->sock = sock;
+	p->deliver = deliver;
+	p->order = nt_order++;
+	p->length = length;
+	memcpy( p->data, data, length );
+}
+
+void
+NET_SendPacket ( netsrc_t sock, int length, void *data, netadr_t to )
+{
+	int deliver;
+
+	if ( length > MAX_MSGLEN )
+	{
+		NT_Fail( "%i byte packet", length );
+		return;
+	}
+
+	/* nothing longer than a packet while limited, once a
+	   reliable message from before the limit is through */
+	if ( ( sock == NS_SERVER ) && nt_limited &&
+		 ( nt_server.netchan.reliable_length <= MAX_MSGLEN - 16 ) &&
+		 ( ( (byte *) data ) [ 3 ] & NT_FRAGMENTBIT ) )
+	{
+		NT_Fail( "fragment sent while limited to MAX_MSGLEN" );
+	}
+
+	if ( ( rand() % 100 ) < nt_loss )
+	{
+		nt_lost++;
+		return;
+	}
+
+	deliver = nt_tick + 1;
+
+	if ( ( rand() % 100 ) < nt_reorder )
+	{
+		deliver += 1 + rand() % 3;
+		nt_reordered++;
+	}
+
+	NT_Queue( sock, length, data, deliver );
+
+	if ( ( rand() % 100 ) < nt_duplicate )
+	{
+		NT_Queue( sock, length, data, deliver + rand() % 2 );
+		nt_duplicated++;
+	}
+}
+
+/* ======================================================================= */
+
+/*
+ * The content of every message follows
+ * from its kind, id and position
+ */
+static byte
+NT_Byte ( int kind, int id, int i )
+{
+	unsigned h;
+
+	h = (unsigned) id * 2654435761u + (unsigned) i * 40503u + (unsigned) kind * 97u;
+
+	return ( ( h >> 13 ) & 0xff );
+}
+
+static void
+NT_WriteMessage ( sizebuf_t *buf, int kind, int id, int length )
+{
+	byte *data;
+	int i;
+
+	MSG_WriteByte( buf, kind );
+	MSG_WriteLong( buf, id );
+	MSG_WriteShort( buf, length );
+
+	data = SZ_GetSpace( buf, length );
+
+	for ( i = 0; i < length; i++ )
+	{
+		data [ i ] = NT_Byte( kind, id, i );
+	}
+}
+
+/*
+ * Mostly small messages, now and then
+ * one that needs several fragments
+ */
+static int
+NT_Length ( int max )
+{
+	int length;
+
+	if ( ( rand() % 4 ) == 0 )
+	{
+		length = rand() % max;
+	}
+	else
+	{
+		length = rand() % 300;
+	}
+
+	return ( length < max ? length : max );
+}
+
+static void
+NT_Send ( ntside_t *side, qboolean idle )
+{
+	byte data [ MAX_BIGMSGLEN ];
+	sizebuf_t buf;
+	sizebuf_t *message;
+	int room, length;
+
+	message = &side->netchan.message;
+
+	/* a reliable message if it fits behind the pending ones */
+	room = message->maxsize - message->cursize - NT_RECORDHEADER;
+
+	if ( !idle && ( room > 0 ) && ( ( rand() % 3 ) == 0 ) )
+	{
+		NT_WriteMessage( message, NT_RELIABLE, side->nextreliable++,
+				NT_Length( room ) );
+	}
+
+	SZ_Init( &buf, data, sizeof( data ) );
+
+	if ( !idle )
+	{
+		length = NT_Length( side->netchan.maxmsglen - 16 - NT_RECORDHEADER );
+		NT_WriteMessage( &buf, NT_UNRELIABLE, side->nextunreliable++, length );
+	}
+
+	Netchan_Transmit( &side->netchan, buf.cursize, buf.data );
+}
+
+/*
+ * Checks a message that came out of Netchan_Process,
+ * the reliable part first, then the unreliable one
+ */
+static void
+NT_Check ( ntside_t *side, sizebuf_t *msg )
+{
+	int kind, id, length;
+	int i;
+
+	side->messages++;
+
+	while ( msg->readcount < msg->cursize )
+	{
+		if ( msg->cursize - msg->readcount < NT_RECORDHEADER )
+		{
+			NT_Fail( "%i bytes left over", msg->cursize - msg->readcount );
+			return;
+		}
+
+		kind = MSG_ReadByte( msg );
+		id = MSG_ReadLong( msg );
+		length = MSG_ReadShort( msg );
+
+		if ( ( length < 0 ) || ( msg->readcount + length > msg->cursize ) )
+		{
+			NT_Fail( "message %i with %i bytes, %i there", id, length,
+					msg->cursize - msg->readcount );
+			return;
+		}
+
+		for ( i = 0; i < length; i++ )
+		{
+			if ( msg->data [ msg->readcount + i ] != NT_Byte( kind, id, i ) )
+			{
+				NT_Fail( "message %i differs at byte %i of %i", id, i, length );
+				return;
+			}
+		}
+
+		msg->readcount += length;
+
+		if ( kind == NT_RELIABLE )
+		{
+			if ( id != side->expectreliable )
+			{
+				NT_Fail( "reliable message %i instead of %i", id, side->expectreliable );
+				return;
+			}
+
+			side->expectreliable++;
+			side->reliables++;
+		}
+		else if ( kind == NT_UNRELIABLE )
+		{
+			if ( id <= side->lastunreliable )
+			{
+				NT_Fail( "unreliable message %i after %i", id, side->lastunreliable );
+				return;
+			}
+
+			side->lastunreliable = id;
+			side->unreliables++;
+		}
+		else
+		{
+			NT_Fail( "message of kind %i", kind );
+			return;
+		}
+	}
+}
+
+static int
+NT_ComparePackets ( const void *a, const void *b )
+{
+	const ntpacket_t *pa = a;
+	const ntpacket_t *pb = b;
+
+	if ( pa->deliver != pb->deliver )
+	{
+		return ( pa->deliver - pb->deliver );
+	}
+
+	return ( pa->order - pb->order );
+}
+
+/*
+ * Hands the packets due by now to the other side
+ */
+static void
+NT_Deliver ( void )
+{
+	ntpacket_t *p;
+	ntside_t *to;
+	int i, n;
+
+	qsort( nt_queue, nt_numqueued, sizeof( nt_queue [ 0 ] ), NT_ComparePackets );
+
+	for ( n = 0; n < nt_numqueued && nt_queue [ n ].deliver <= nt_tick; n++ )
+	{
+		p = &nt_queue [ n ];
+		to = p->sock == NS_CLIENT ? &nt_server : &nt_client;
+
+		SZ_Init( &net_message, net_message_buffer, sizeof( net_message_buffer ) );
+		SZ_Write( &net_message, p->data, p->length );
+
+		if ( Netchan_Process( &to->netchan, &net_message ) )
+		{
+			NT_Check( to, &net_message );
+		}
+	}
+
+	for ( i = n; i < nt_numqueued; i++ )
+	{
+		nt_queue [ i - n ] = nt_queue [ i ];
+	}
+
+	nt_numqueued -= n;
+}
+
+static void
+NT_Setup ( ntside_t *side, netsrc_t sock )
+{
+	netadr_t adr;
+
+	memset( side, 0, sizeof( *side ) );
+	memset( &adr, 0, sizeof( adr ) );
+	adr.type = NA_LOOPBACK;
+
+	Netchan_Setup( sock, &side->netchan, adr, 1 );
+	Netchan_EnableFragments( &side->netchan );
+
+	side->lastunreliable = -1;
+}
+
+static qboolean
+NT_Drained ( ntside_t *from, ntside_t *to )
+{
+	return ( !from->netchan.reliable_length && !from->netchan.message.cursize &&
+			 ( to->expectreliable == from->nextreliable ) );
+}
+
+static void
+NT_Usage ( void )
+{
+	printf( "Usage: nettest [options]\n"
+			"  -ticks <n>        packets sent by each side (default 20000)\n"
+			"  -loss <n>         percent of the packets to drop (default 10)\n"
+			"  -reorder <n>      percent of the packets to delay (default 10)\n"
+			"  -duplicate <n>    percent of the packets to send twice (default 2)\n"
+			"  -seed <n>         seed for the messages and the network\n"
+			"  -verbose          print what the netchan prints\n" );
+
+	exit( 1 );
+}
+
+int
+main ( int argc, char **argv )
+{
+	int ticks, seed;
+	int i;
+
+	ticks = 20000;
+	stubs_quiet = true;
+	seed = 1;
+	nt_loss = 10;
+	nt_reorder = 10;
+	nt_duplicate = 2;
+
+	for ( i = 1; i < argc; i++ )
+	{
+		if ( !strcmp( argv [ i ], "-verbose" ) )
+		{
+			stubs_quiet = false;
+			continue;
+		}
+
+		if ( i + 1 >= argc )
+		{
+			NT_Usage();
+		}
+
+		if ( !strcmp( argv [ i ], "-ticks" ) )
+		{
+			ticks = atoi( argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-loss" ) )
+		{
+			nt_loss = atoi( argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-reorder" ) )
+		{
+			nt_reorder = atoi( argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-duplicate" ) )
+		{
+			nt_duplicate = atoi( argv [ ++i ] );
+		}
+		else if ( !strcmp( argv [ i ], "-seed" ) )
+		{
+			seed = atoi( argv [ ++i ] );
+		}
+		else
+		{
+			NT_Usage();
+		}
+	}
+
+	z_chain.next = z_chain.prev = &z_chain;
+
+	Swap_Init();
+	Cmd_Init();
+	Cvar_Init();
+	Netchan_Init();
+
+	srand( seed );
+
+	NT_Setup( &nt_client, NS_CLIENT );
+	NT_Setup( &nt_server, NS_SERVER );
+
+	for ( nt_tick = 0; nt_tick < ticks && !nt_failed; nt_tick++ )
+	{
+		curtime = nt_tick * 10;
+
+		/* the middle third like a client recording a demo */
+		if ( nt_tick == ticks / 3 )
+		{
+			Netchan_SetMaxMsgLen( &nt_server.netchan, MAX_MSGLEN );
+			nt_limited = true;
+		}
+		else if ( nt_tick == 2 * ticks / 3 )
+		{
+			Netchan_SetMaxMsgLen( &nt_server.netchan, MAX_BIGMSGLEN );
+			nt_limited = false;
+		}
+
+		NT_Send( &nt_client, false );
+		NT_Send( &nt_server, false );
+		NT_Deliver();
+	}
+
+	/* a clean network until all reliable messages are through */
+	nt_loss = nt_reorder = nt_duplicate = 0;
+
+	for ( i = 0; i < NT_MAXDRAIN && !nt_failed; i++, nt_tick++ )
+	{
+		if ( NT_Drained( &nt_client, &nt_server ) && NT_Drained( &nt_server, &nt_client ) )
+		{
+			break;
+		}
+
+		curtime = nt_tick * 10;
+
+		NT_Send( &nt_client, true );
+		NT_Send( &nt_server, true );
+		NT_Deliver();
+	}
+
+	if ( !nt_failed && ( i == NT_MAXDRAIN ) )
+	{
+		NT_Fail( "reliable messages still missing: client %i of %i, server %i of %i",
+				nt_server.expectreliable, nt_client.nextreliable,
+				nt_client.expectreliable, nt_server.nextreliable );
+	}
+
+	if ( !nt_failed && !net_fragments_received )
+	{
+		NT_Fail( "no message was reassembled" );
+	}
+
+	printf( "client -> server: %i messages, %i reliable, %i of %i unreliable\n",
+			nt_server.messages, nt_server.reliables, nt_server.unreliables,
+			nt_client.nextunreliable );
+	printf( "server -> client: %i messages, %i reliable, %i of %i unreliable\n",
+			nt_client.messages, nt_client.reliables, nt_client.unreliables,
+			nt_server.nextunreliable );
+	printf( "packets: %i lost, %i reordered, %i duplicated\n",
+			nt_lost, nt_reordered, nt_duplicated );
+	printf( "fragments: %i sent, %i received, %i dropped\n",
+			net_fragments_sent, net_fragments_received, net_fragments_dropped );
+
+	if ( nt_failed )
+	{
+		return ( 1 );
+	}
+
+	printf( "ok\n" );
+
+	return ( 0 );
+}
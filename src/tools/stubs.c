@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 1997-2001 Id Software, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * =======================================================================
+ *
+ * The parts of misc.c, com_clientserver.c, logfile.c and vid.c that
+ * the common code linked into the headless tools needs. There's no
+ * server, client or logfile. Whatever a tool does with the network
+ * stays in the tool.
+ *
+ * =======================================================================
+ */
+
+#include "../common/header/common.h"
+
+cvar_t *dedicated;
+cvar_t *nostdout;
+void ( *IN_Update_fp )( void );
+
+qboolean stubs_quiet;   /* a tool that only wants its own output */
+
+void
+Com_Printf ( char *fmt, ... )
+{
+	va_list argptr;
+
+	if ( stubs_quiet )
+	{
+		return;
+	}
+
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+}
+
+void
+Com_DPrintf ( char *fmt, ... )
+{
+}
+
+void
+Com_MDPrintf ( char *fmt, ... )
+{
+}
+
+void
+Com_Error ( int code, char *fmt, ... )
+{
+	va_list argptr;
+
+	va_start( argptr, fmt );
+	fprintf( stderr, "Error: " );
+	vfprintf( stderr, fmt, argptr );
+	fprintf( stderr, "\n" );
+	va_end( argptr );
+
+	exit( 2 );
+}
+
+int
+Com_ServerState ( void )
+{
+	return ( 0 );
+}
+
+void
+Cmd_ForwardToServer ( void )
+{
+}
+
+void
+CL_Shutdown ( void )
+{
+}
+
+void
+Qcommon_Shutdown ( void )
+{
+}
+
+void
+Sys_LogClose ( void )
+{
+}
@@ -0,0 +1,303 @@
+/*
+ * Copyright (C) 1997-2001 Id Software, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * =======================================================================
+ *
+ * Asynchronous logfile. Com_Printf copies the text into a ring buffer
+ * and returns, a background thread writes the ring to disk. Only the
+ * main thread may print, so the ring needs no lock. When the disk can't
+ * keep up and the ring is full, text is dropped and a note about it is
+ * written instead of stalling the frame.
+ *
+ * =======================================================================
+ */
+
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "../common/header/common.h"
+
+#define LOG_MINSIZE ( 16 * 1024 )
+#define LOG_MAXSIZE ( 64 * 1024 * 1024 )
+
+static FILE *log_file;
+static pthread_t log_thread;
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t log_wakeup = PTHREAD_COND_INITIALIZER;
+
+static char *log_ring;
+static unsigned int log_size;               /* power of two */
+static volatile unsigned int log_head;      /* end of the printed text */
+static volatile unsigned int log_claimed;   /* end of the text a writer took */
+static volatile unsigned int log_tail;      /* end of the written text */
+
+static volatile int log_flushtime;          /* ms */
+static volatile qboolean log_stop;
+static int log_dropped;                     /* bytes */
+
+/*
+ * Writes everything printed so far. A writer
+ * claims its part before writing it, so the
+ * thread and a crash flush never write the
+ * same text twice.
+ */
+static qboolean
+Sys_LogDrain ( void )
+{
+	unsigned int start, end;
+	unsigned int first, len;
+
+	do
+	{
+		start = log_claimed;
+		end = log_head;
+
+		if ( start == end )
+		{
+			return ( false );
+		}
+	}
+	while ( !__sync_bool_compare_and_swap( &log_claimed, start, end ) );
+
+	len = end - start;
+	first = start & ( log_size - 1 );
+
+	if ( first + len > log_size )
+	{
+		fwrite( log_ring + first, 1, log_size - first, log_file );
+		fwrite( log_ring, 1, len - ( log_size - first ), log_file );
+	}
+	else
+	{
+		fwrite( log_ring + first, 1, len, log_file );
+	}
+
+	__sync_fetch_and_add( &log_tail, len );
+
+	return ( true );
+}
+
+static void *
+Sys_LogThread ( void *arg )
+{
+	struct timeval now;
+	struct timespec timeout;
+	int wait;
+
+	pthread_mutex_lock( &log_lock );
+
+	while ( !log_stop )
+	{
+		/* text that has to be on disk at
+		   once comes with a wakeup, but
+		   that may be missed while writing */
+		wait = log_flushtime > 0 ? log_flushtime : 10;
+
+		gettimeofday( &now, NULL );
+		timeout.tv_sec = now.tv_sec + wait / 1000;
+		timeout.tv_nsec = ( now.tv_usec + ( wait % 1000 ) * 1000 ) * 1000;
+
+		if ( timeout.tv_nsec >= 1000000000 )
+		{
+			timeout.tv_sec++;
+			timeout.tv_nsec -= 1000000000;
+		}
+
+		pthread_cond_timedwait( &log_wakeup, &log_lock, &timeout );
+		pthread_mutex_unlock( &log_lock );
+
+		if ( Sys_LogDrain() )
+		{
+			fflush( log_file );
+		}
+
+		pthread_mutex_lock( &log_lock );
+	}
+
+	pthread_mutex_unlock( &log_lock );
+
+	return ( NULL );
+}
+
+static void
+Sys_LogPut ( const char *text, unsigned int len )
+{
+	unsigned int first;
+
+	first = log_head & ( log_size - 1 );
+
+	if ( first + len > log_size )
+	{
+		memcpy( log_ring + first, text, log_size - first );
+		memcpy( log_ring, text + ( log_size - first ), len - ( log_size - first ) );
+	}
+	else
+	{
+		memcpy( log_ring + first, text, len );
+	}
+
+	/* the text must be there before the
+	   writer sees the new head */
+	__sync_synchronize();
+	log_head += len;
+}
+
+/*
+ * Opens the logfile and starts the writer.
+ * buffersize is rounded up to a power of two.
+ */
+qboolean
+Sys_LogOpen ( char *name, qboolean append, int buffersize )
+{
+	if ( log_file )
+	{
+		return ( true );
+	}
+
+	log_file = fopen( name, append ? "a" : "w" );
+
+	if ( !log_file )
+	{
+		return ( false );
+	}
+
+	if ( buffersize > LOG_MAXSIZE )
+	{
+		buffersize = LOG_MAXSIZE;
+	}
+
+	for ( log_size = LOG_MINSIZE; log_size < buffersize; log_size <<= 1 )
+	{
+	}
+
+	log_ring = malloc( log_size );
+	log_head = log_claimed = log_tail = 0;
+	log_dropped = 0;
+	log_stop = false;
+
+	if ( !log_ring || ( pthread_create( &log_thread, NULL, Sys_LogThread, NULL ) != 0 ) )
+	{
+		free( log_ring );
+		log_ring = NULL;
+		fclose( log_file );
+		log_file = NULL;
+		return ( false );
+	}
+
+	return ( true );
+}
+
+/*
+ * Queues text for the logfile. It's on disk
+ * after at most flushtime ms, a flushtime
+ * of 0 writes it as soon as possible.
+ */
+void
+Sys_LogWrite ( char *text, int flushtime )
+{
+	char note [ 64 ];
+	unsigned int len, space;
+
+	if ( !log_file )
+	{
+		return;
+	}
+
+	len = strlen( text );
+	space = log_size - ( log_head - log_tail );
+
+	if ( log_dropped )
+	{
+		Com_sprintf( note, sizeof( note ), "[%i bytes of log dropped]\n", log_dropped );
+
+		if ( space < strlen( note ) + len )
+		{
+			log_dropped += len;
+			return;
+		}
+
+		Sys_LogPut( note, strlen( note ) );
+		space -= strlen( note );
+		log_dropped = 0;
+	}
+
+	if ( space < len )
+	{
+		log_dropped += len;
+		return;
+	}
+
+	Sys_LogPut( text, len );
+
+	log_flushtime = flushtime;
+
+	if ( ( flushtime <= 0 ) || ( log_head - log_tail > log_size / 2 ) )
+	{
+		pthread_cond_signal( &log_wakeup );
+	}
+}
+
+/*
+ * Writes out what's left without waiting
+ * for the writer. Called by the signal
+ * handler, the main thread may be dead.
+ */
+void
+Sys_LogFlush ( void )
+{
+	if ( !log_file )
+	{
+		return;
+	}
+
+	Sys_LogDrain();
+	fflush( log_file );
+}
+
+/*
+ * Stops the writer and closes the file.
+ */
+void
+Sys_LogClose ( void )
+{
+	if ( !log_file )
+	{
+		return;
+	}
+
+	pthread_mutex_lock( &log_lock );
+	log_stop = true;
+	pthread_cond_signal( &log_wakeup );
+	pthread_mutex_unlock( &log_lock );
+
+	pthread_join( log_thread, NULL );
+
+	Sys_LogDrain();
+
+	if ( log_dropped )
+	{
+		fprintf( log_file, "[%i bytes of log dropped]\n", log_dropped );
+	}
+
+	fclose( log_file );
+	log_file = NULL;
+
+	free( log_ring );
+	log_ring = NULL;
+}
@@ -102,7 +102,7 @@ main ( int argc, char **argv )
 			newtime = Sys_Milliseconds();
 			time = newtime - oldtime;
 		}
-		while ( time < 1 );
+		while ( ( time < 1 ) && !SV_JournalReplaying() );
 
 		Qcommon_Frame( time );
 		oldtime = newtime;
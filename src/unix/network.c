@@ -41,25 +41,37 @@
 netadr_t net_local_adr;
 
 #define LOOPBACK		0x7f000001
-#define MAX_LOOPBACK    4
+#define MAX_LOOPBACK    16  /* room for a message in fragments */
 #define QUAKE2MCAST		"ff12::666"
 
 typedef struct
 {
-	byte data [ MAX_MSGLEN ];
+	byte data [ MAX_BIGMSGLEN ];        /* fragments are put together in place */
 	int datalen;
 } loopmsg_t;
 
+/*
+ * One writer and one reader, so the indices
+ * need no lock. A message belongs to the
+ * writer until send passes it and to the
+ * reader until get passes it.
+ */
 typedef struct
 {
 	loopmsg_t msgs [ MAX_LOOPBACK ];
-	int get, send;
+	unsigned int get, send;
+
+	sizebuf_t *lent;                    /* reads msgs [ get ] in place */
+	byte *saveddata;                    /* its own buffer */
+	int savedsize;
 } loopback_t;
 
 loopback_t loopbacks [ 2 ];
 int ip_sockets [ 2 ];
 int ip6_sockets[2];
 int ipx_sockets [ 2 ];
+
+static qboolean net_stubbed;    /* journal replay, no traffic */
 char *multicast_interface = NULL;
 
 int NET_Socket(char *net_interface, int port, netsrc_t type, int family);
@@ -457,28 +469,65 @@ NET_IsLocalAddress ( netadr_t adr )
 	return ( NET_CompareAdr( adr, net_local_adr ) );
 }
 
+/*
+ * Gives the message lent to net_message back
+ * to the writer, net_message gets its own
+ * buffer again.
+ */
+static void
+NET_ReleaseLoopPacket ( sizebuf_t *net_message )
+{
+	loopback_t  *loop;
+	int sock;
+
+	for ( sock = 0; sock < 2; sock++ )
+	{
+		loop = &loopbacks [ sock ];
+
+		if ( loop->lent != net_message )
+		{
+			continue;
+		}
+
+		net_message->data = loop->saveddata;
+		net_message->maxsize = loop->savedsize;
+		loop->lent = NULL;
+
+		/* done reading before the
+		   writer may reuse it */
+		__atomic_store_n( &loop->get, loop->get + 1, __ATOMIC_RELEASE );
+	}
+}
+
+/*
+ * The message isn't copied, net_message reads
+ * it where it is until the next NET_GetPacket.
+ */
 qboolean
 NET_GetLoopPacket ( netsrc_t sock, netadr_t *net_from, sizebuf_t *net_message )
 {
 	int i;
 	loopback_t  *loop;
 
-	loop = &loopbacks [ sock ];
+	NET_ReleaseLoopPacket( net_message );
 
-	if ( loop->send - loop->get > MAX_LOOPBACK )
-	{
-		loop->get = loop->send - MAX_LOOPBACK;
-	}
+	loop = &loopbacks [ sock ];
 
-	if ( loop->get >= loop->send )
+	/* the message was written before
+	   send was advanced */
+	if ( loop->get == __atomic_load_n( &loop->send, __ATOMIC_ACQUIRE ) )
 	{
 		return ( false );
 	}
 
 	i = loop->get & ( MAX_LOOPBACK - 1 );
-	loop->get++;
 
-	memcpy( net_message->data, loop->msgs [ i ].data, loop->msgs [ i ].datalen );
+	loop->lent = net_message;
+	loop->saveddata = net_message->data;
+	loop->savedsize = net_message->maxsize;
+
+	net_message->data = loop->msgs [ i ].data;
+	net_message->maxsize = sizeof ( loop->msgs [ i ].data );
 	net_message->cursize = loop->msgs [ i ].datalen;
 	*net_from = net_local_adr;
 	return ( true );
@@ -492,11 +541,19 @@ NET_SendLoopPacket ( netsrc_t sock, int length, void *data, netadr_t to )
 
 	loop = &loopbacks [ sock ^ 1 ];
 
+	/* the reader is behind, lost like
+	   a packet over the network */
+	if ( loop->send - __atomic_load_n( &loop->get, __ATOMIC_ACQUIRE ) >= MAX_LOOPBACK )
+	{
+		return;
+	}
+
 	i = loop->send & ( MAX_LOOPBACK - 1 );
-	loop->send++;
 
 	memcpy( loop->msgs [ i ].data, data, length );
 	loop->msgs [ i ].datalen = length;
+
+	__atomic_store_n( &loop->send, loop->send + 1, __ATOMIC_RELEASE );
 }
 
 qboolean
@@ -509,6 +566,11 @@ NET_GetPacket ( netsrc_t sock, netadr_t *net_from, sizebuf_t *net_message )
 	int protocol;
 	int err;
 
+	if (net_stubbed)
+	{
+		return false;
+	}
+
 	if (NET_GetLoopPacket(sock, net_from, net_message))
 	{
 		return true;
@@ -575,6 +637,11 @@ NET_SendPacket ( netsrc_t sock, int length, void *data, netadr_t to )
 	int net_socket;
 	int addr_size = sizeof(struct sockaddr_in);
 
+	if (net_stubbed)
+	{
+		return;
+	}
+
 	switch (to.type)
 	{
 		case NA_LOOPBACK:
@@ -931,6 +998,17 @@ NET_Socket ( char *net_interface, int port, netsrc_t type, int family )
 	return newsocket;
 }
 
+/*
+ * While stubbed nothing is sent or received
+ * and NET_Sleep returns at once. Used by the
+ * server journal replay.
+ */
+void
+NET_Stub ( qboolean stub )
+{
+	net_stubbed = stub;
+}
+
 void
 NET_Shutdown ( void )
 {
@@ -957,6 +1035,11 @@ NET_Sleep ( int msec )
 	extern cvar_t *dedicated;
 	extern qboolean stdin_active;
 
+	if (net_stubbed)
+	{
+		return;
+	}
+
 	if ((!ip_sockets[NS_SERVER] && !ip6_sockets[NS_SERVER]) || (dedicated && !dedicated->value))
 	{
 		return; /* we're not a server, just run full speed */
@@ -0,0 +1,764 @@
+/*
+ * Copyright (C) 1997-2001 Id Software, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * =======================================================================
+ *
+ * This file implements the headless "null" refresher backend. It
+ * replaces qgl.c, the SDL window and the SDL input backend when
+ * building ref_null.so. All QGL function pointers are bound to stubs
+ * which do nothing but count what would have been sent to the GPU,
+ * so the whole CPU side of the renderer (BSP traversal, culling, mesh
+ * lerping, lightmap building, particles) can be benchmarked with
+ * "timedemo 1" on machines without a GPU or a display.
+ *
+ * =======================================================================
+ */
+
+#if !defined(QGL_DIRECT_LINK)
+
+#include "../refresh/header/local.h"
+#include "header/unix.h"
+#include "header/glwindow.h"
+
+glwstate_t glw_state;
+qboolean have_stencil = false;
+
+/* Statistics gathered by the stubs */
+typedef struct
+{
+	int frames;
+	int calls;
+	int begins;
+	int vertices;
+	int drawarrays;
+	int arrayvertices;
+	int binds;
+	int uploads;
+	int uploadbytes;
+	int clears;
+} qglnull_stats_t;
+
+static qglnull_stats_t qglnull_stats;
+
+void ( APIENTRY *qglAlphaFunc )( GLenum func, GLclampf ref );
+void ( APIENTRY *qglArrayElement )( GLint i );
+void ( APIENTRY *qglBegin )( GLenum mode );
+void ( APIENTRY *qglBindTexture )( GLenum target, GLuint texture );
+void ( APIENTRY *qglBlendFunc )( GLenum sfactor, GLenum dfactor );
+void ( APIENTRY *qglClear )( GLbitfield mask );
+void ( APIENTRY *qglClearColor )( GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha );
+void ( APIENTRY *qglClearStencil )( GLint s );
+void ( APIENTRY *qglColor4f )( GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha );
+void ( APIENTRY *qglColor4ubv )( const GLubyte *v );
+void ( APIENTRY *qglColorPointer )( GLint size, GLenum type, GLsizei stride, const GLvoid *pointer );
+void ( APIENTRY *qglCullFace )( GLenum mode );
+void ( APIENTRY *qglDeleteTextures )( GLsizei n, const GLuint *textures );
+void ( APIENTRY *qglDepthFunc )( GLenum func );
+void ( APIENTRY *qglDepthMask )( GLboolean flag );
+void ( APIENTRY *qglDepthRange )( GLclampd zNear, GLclampd zFar );
+void ( APIENTRY *qglDisable )( GLenum cap );
+void ( APIENTRY *qglDisableClientState )( GLenum array );
+void ( APIENTRY *qglDrawArrays )( GLenum mode, GLint first, GLsizei count );
+void ( APIENTRY *qglDrawBuffer )( GLenum mode );
+void ( APIENTRY *qglEnable )( GLenum cap );
+void ( APIENTRY *qglEnableClientState )( GLenum array );
+void ( APIENTRY *qglEnd )( void );
+void ( APIENTRY *qglFinish )( void );
+void ( APIENTRY *qglFrustum )( GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble zNear, GLdouble zFar );
+GLenum ( APIENTRY *qglGetError )( void );
+void ( APIENTRY *qglGetFloatv )( GLenum pname, GLfloat *params );
+const GLubyte * ( APIENTRY * qglGetString )(GLenum name);
+void ( APIENTRY *qglLoadIdentity )( void );
+void ( APIENTRY *qglLoadMatrixf )( const GLfloat *m );
+void ( APIENTRY *qglMatrixMode )( GLenum mode );
+void ( APIENTRY *qglOrtho )( GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble zNear, GLdouble zFar );
+void ( APIENTRY *qglPointSize )( GLfloat size );
+void ( APIENTRY *qglPolygonMode )( GLenum face, GLenum mode );
+void ( APIENTRY *qglPopMatrix )( void );
+void ( APIENTRY *qglPushMatrix )( void );
+void ( APIENTRY *qglReadPixels )( GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid *pixels );
+void ( APIENTRY *qglRotatef )( GLfloat angle, GLfloat x, GLfloat y, GLfloat z );
+void ( APIENTRY *qglScalef )( GLfloat x, GLfloat y, GLfloat z );
+void ( APIENTRY *qglScissor )( GLint x, GLint y, GLsizei width, GLsizei height );
+void ( APIENTRY *qglShadeModel )( GLenum mode );
+void ( APIENTRY *qglStencilFunc )( GLenum func, GLint ref, GLuint mask );
+void ( APIENTRY *qglStencilOp )( GLenum fail, GLenum zfail, GLenum zpass );
+void ( APIENTRY *qglTexCoord2f )( GLfloat s, GLfloat t );
+void ( APIENTRY *qglTexCoordPointer )( GLint size, GLenum type, GLsizei stride, const GLvoid *pointer );
+void ( APIENTRY *qglTexEnvf )( GLenum target, GLenum pname, GLfloat param );
+void ( APIENTRY *qglTexEnvi )( GLenum target, GLenum pname, GLint param );
+void ( APIENTRY *qglTexImage2D )( GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border,
+		GLenum format, GLenum type, const GLvoid *pixels );
+void ( APIENTRY *qglTexParameterf )( GLenum target, GLenum pname, GLfloat param );
+void ( APIENTRY *qglTexSubImage2D )( GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+		GLenum format, GLenum type, const GLvoid *pixels );
+void ( APIENTRY *qglTranslatef )( GLfloat x, GLfloat y, GLfloat z );
+void ( APIENTRY *qglVertex2f )( GLfloat x, GLfloat y );
+void ( APIENTRY *qglVertex3f )( GLfloat x, GLfloat y, GLfloat z );
+void ( APIENTRY *qglVertex3fv )( const GLfloat *v );
+void ( APIENTRY *qglVertexPointer )( GLint size, GLenum type, GLsizei stride, const GLvoid *pointer );
+void ( APIENTRY *qglViewport )( GLint x, GLint y, GLsizei width, GLsizei height );
+
+void ( APIENTRY *qglLockArraysEXT )( int, int );
+void ( APIENTRY *qglUnlockArraysEXT )( void );
+void ( APIENTRY *qglPointParameterfEXT )( GLenum param, GLfloat value );
+void ( APIENTRY *qglPointParameterfvEXT )( GLenum param, const GLfloat *value );
+void ( APIENTRY *qglColorTableEXT )( GLenum, GLenum, GLsizei, GLenum, GLenum, const GLvoid * );
+void ( APIENTRY *qglSelectTextureSGIS )( GLenum );
+void ( APIENTRY *qglMTexCoord2fSGIS )( GLenum, GLfloat, GLfloat );
+void ( APIENTRY *qglActiveTextureARB )( GLenum );
+void ( APIENTRY *qglClientActiveTextureARB )( GLenum );
+
+/*
+ * Stubs which only need to be counted
+ */
+static void APIENTRY
+nullAlphaFunc ( GLenum func, GLclampf ref )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullBlendFunc ( GLenum sfactor, GLenum dfactor )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullClearColor ( GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullClearStencil ( GLint s )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullColor4f ( GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullColor4ubv ( const GLubyte *v )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullPointer ( GLint size, GLenum type, GLsizei stride, const GLvoid *pointer )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullEnum ( GLenum e )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullDeleteTextures ( GLsizei n, const GLuint *textures )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullDepthMask ( GLboolean flag )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullDepthRange ( GLclampd zNear, GLclampd zFar )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullVoid ( void )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullProjection ( GLdouble left, GLdouble right, GLdouble bottom, GLdouble top, GLdouble zNear, GLdouble zFar )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullLoadMatrixf ( const GLfloat *m )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullPointSize ( GLfloat size )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullPolygonMode ( GLenum face, GLenum mode )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullTransform ( GLfloat x, GLfloat y, GLfloat z )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullRotatef ( GLfloat angle, GLfloat x, GLfloat y, GLfloat z )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullRect ( GLint x, GLint y, GLsizei width, GLsizei height )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullStencilFunc ( GLenum func, GLint ref, GLuint mask )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullStencilOp ( GLenum fail, GLenum zfail, GLenum zpass )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullTexCoord2f ( GLfloat s, GLfloat t )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullTexEnvf ( GLenum target, GLenum pname, GLfloat param )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullTexEnvi ( GLenum target, GLenum pname, GLint param )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullLockArrays ( int first, int count )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullPointParameterf ( GLenum param, GLfloat value )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullPointParameterfv ( GLenum param, const GLfloat *value )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullColorTable ( GLenum target, GLenum internalformat, GLsizei width, GLenum format, GLenum type, const GLvoid *table )
+{
+	qglnull_stats.calls++;
+}
+
+static void APIENTRY
+nullMTexCoord2f ( GLenum target, GLfloat s, GLfloat t )
+{
+	qglnull_stats.calls++;
+}
+
+/*
+ * Stubs which record geometry and texture traffic
+ */
+static void APIENTRY
+nullArrayElement ( GLint i )
+{
+	qglnull_stats.calls++;
+	qglnull_stats.arrayvertices++;
+}
+
+static void APIENTRY
+nullBegin ( GLenum mode )
+{
+	qglnull_stats.calls++;
+	qglnull_stats.begins++;
+}
+
+static void APIENTRY
+nullBindTexture ( GLenum target, GLuint texture )
+{
+	qglnull_stats.calls++;
+	qglnull_stats.binds++;
+}
+
+static void APIENTRY
+nullClear ( GLbitfield mask )
+{
+	qglnull_stats.calls++;
+	qglnull_stats.clears++;
+}
+
+static void APIENTRY
+nullDrawArrays ( GLenum mode, GLint first, GLsizei count )
+{
+	qglnull_stats.calls++;
+	qglnull_stats.drawarrays++;
+	qglnull_stats.arrayvertices += count;
+}
+
+static void APIENTRY
+nullVertex2f ( GLfloat x, GLfloat y )
+{
+	qglnull_stats.calls++;
+	qglnull_stats.vertices++;
+}
+
+static void APIENTRY
+nullVertex3f ( GLfloat x, GLfloat y, GLfloat z )
+{
+	qglnull_stats.calls++;
+	qglnull_stats.vertices++;
+}
+
+static void APIENTRY
+nullVertex3fv ( const GLfloat *v )
+{
+	qglnull_stats.calls++;
+	qglnull_stats.vertices++;
+}
+
+static int
+nullPixelSize ( GLenum format )
+{
+	switch ( format )
+	{
+		case GL_RGBA:
+			return ( 4 );
+		case GL_RGB:
+			return ( 3 );
+		default:
+			return ( 1 );
+	}
+}
+
+static void APIENTRY
+nullTexImage2D ( GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border,
+		GLenum format, GLenum type, const GLvoid *pixels )
+{
+	qglnull_stats.calls++;
+	qglnull_stats.uploads++;
+	qglnull_stats.uploadbytes += width * height * nullPixelSize( format );
+}
+
+static void APIENTRY
+nullTexSubImage2D ( GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height,
+		GLenum format, GLenum type, const GLvoid *pixels )
+{
+	qglnull_stats.calls++;
+	qglnull_stats.uploads++;
+	qglnull_stats.uploadbytes += width * height * nullPixelSize( format );
+}
+
+static void APIENTRY
+nullTexParameterf ( GLenum target, GLenum pname, GLfloat param )
+{
+	qglnull_stats.calls++;
+}
+
+/*
+ * Stubs which must return something sensible
+ */
+static GLenum APIENTRY
+nullGetError ( void )
+{
+	return ( GL_NO_ERROR );
+}
+
+static void APIENTRY
+nullGetFloatv ( GLenum pname, GLfloat *params )
+{
+	qglnull_stats.calls++;
+
+	if ( ( pname == GL_MODELVIEW_MATRIX ) || ( pname == GL_PROJECTION_MATRIX ) )
+	{
+		memset( params, 0, sizeof ( GLfloat ) * 16 );
+		params [ 0 ] = params [ 5 ] = params [ 10 ] = params [ 15 ] = 1.0f;
+	}
+	else
+	{
+		params [ 0 ] = 0.0f;
+	}
+}
+
+static const GLubyte * APIENTRY
+nullGetString ( GLenum name )
+{
+	switch ( name )
+	{
+		case GL_VENDOR:
+			return ( (const GLubyte *) "Yamagi Quake II" );
+		case GL_RENDERER:
+			return ( (const GLubyte *) "null" );
+		case GL_VERSION:
+			return ( (const GLubyte *) "1.1 null" );
+		default:
+			/* No extensions, so no further
+			   entry points are queried */
+			return ( (const GLubyte *) "" );
+	}
+}
+
+static void APIENTRY
+nullReadPixels ( GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, GLvoid *pixels )
+{
+	qglnull_stats.calls++;
+	memset( pixels, 0, width * height * nullPixelSize( format ) );
+}
+
+/*
+ * Prints what the renderer would have sent
+ * to the GPU since the last call
+ */
+static void
+QGL_NullStats_f ( void )
+{
+	int frames;
+
+	frames = qglnull_stats.frames ? qglnull_stats.frames : 1;
+
+	ri.Con_Printf( PRINT_ALL, "%i frames\n", qglnull_stats.frames );
+	ri.Con_Printf( PRINT_ALL, "%8i gl calls/frame\n", qglnull_stats.calls / frames );
+	ri.Con_Printf( PRINT_ALL, "%8i begin/end blocks/frame\n", qglnull_stats.begins / frames );
+	ri.Con_Printf( PRINT_ALL, "%8i immediate vertices/frame\n", qglnull_stats.vertices / frames );
+	ri.Con_Printf( PRINT_ALL, "%8i draw arrays/frame\n", qglnull_stats.drawarrays / frames );
+	ri.Con_Printf( PRINT_ALL, "%8i array vertices/frame\n", qglnull_stats.arrayvertices / frames );
+	ri.Con_Printf( PRINT_ALL, "%8i texture binds/frame\n", qglnull_stats.binds / frames );
+	ri.Con_Printf( PRINT_ALL, "%8i texture uploads (%i bytes)\n", qglnull_stats.uploads, qglnull_stats.uploadbytes );
+
+	memset( &qglnull_stats, 0, sizeof ( qglnull_stats ) );
+}
+
+void
+QGL_Shutdown ( void )
+{
+	qglAlphaFunc = NULL;
+	qglArrayElement = NULL;
+	qglBegin = NULL;
+	qglBindTexture = NULL;
+	qglBlendFunc = NULL;
+	qglClear = NULL;
+	qglClearColor = NULL;
+	qglClearStencil = NULL;
+	qglColor4f = NULL;
+	qglColor4ubv = NULL;
+	qglColorPointer = NULL;
+	qglCullFace = NULL;
+	qglDeleteTextures = NULL;
+	qglDepthFunc = NULL;
+	qglDepthMask = NULL;
+	qglDepthRange = NULL;
+	qglDisable = NULL;
+	qglDisableClientState = NULL;
+	qglDrawArrays = NULL;
+	qglDrawBuffer = NULL;
+	qglEnable = NULL;
+	qglEnableClientState = NULL;
+	qglEnd = NULL;
+	qglFinish = NULL;
+	qglFrustum = NULL;
+	qglGetError = NULL;
+	qglGetFloatv = NULL;
+	qglGetString = NULL;
+	qglLoadIdentity = NULL;
+	qglLoadMatrixf = NULL;
+	qglMatrixMode = NULL;
+	qglOrtho = NULL;
+	qglPointSize = NULL;
+	qglPolygonMode = NULL;
+	qglPopMatrix = NULL;
+	qglPushMatrix = NULL;
+	qglReadPixels = NULL;
+	qglRotatef = NULL;
+	qglScalef = NULL;
+	qglScissor = NULL;
+	qglShadeModel = NULL;
+	qglStencilFunc = NULL;
+	qglStencilOp = NULL;
+	qglTexCoord2f = NULL;
+	qglTexCoordPointer = NULL;
+	qglTexEnvf = NULL;
+	qglTexEnvi = NULL;
+	qglTexImage2D = NULL;
+	qglTexParameterf = NULL;
+	qglTexSubImage2D = NULL;
+	qglTranslatef = NULL;
+	qglVertex2f = NULL;
+	qglVertex3f = NULL;
+	qglVertex3fv = NULL;
+	qglVertexPointer = NULL;
+	qglViewport = NULL;
+
+	qglLockArraysEXT = NULL;
+	qglUnlockArraysEXT = NULL;
+	qglPointParameterfEXT = NULL;
+	qglPointParameterfvEXT = NULL;
+	qglColorTableEXT = NULL;
+	qglSelectTextureSGIS = NULL;
+	qglMTexCoord2fSGIS = NULL;
+	qglActiveTextureARB = NULL;
+	qglClientActiveTextureARB = NULL;
+}
+
+qboolean
+QGL_Init ( const char *dllname )
+{
+	Com_Printf( "Using the null GL backend, nothing will be drawn.\n" );
+
+	qglAlphaFunc = nullAlphaFunc;
+	qglArrayElement = nullArrayElement;
+	qglBegin = nullBegin;
+	qglBindTexture = nullBindTexture;
+	qglBlendFunc = nullBlendFunc;
+	qglClear = nullClear;
+	qglClearColor = nullClearColor;
+	qglClearStencil = nullClearStencil;
+	qglColor4f = nullColor4f;
+	qglColor4ubv = nullColor4ubv;
+	qglColorPointer = nullPointer;
+	qglCullFace = nullEnum;
+	qglDeleteTextures = nullDeleteTextures;
+	qglDepthFunc = nullEnum;
+	qglDepthMask = nullDepthMask;
+	qglDepthRange = nullDepthRange;
+	qglDisable = nullEnum;
+	qglDisableClientState = nullEnum;
+	qglDrawArrays = nullDrawArrays;
+	qglDrawBuffer = nullEnum;
+	qglEnable = nullEnum;
+	qglEnableClientState = nullEnum;
+	qglEnd = nullVoid;
+	qglFinish = nullVoid;
+	qglFrustum = nullProjection;
+	qglGetError = nullGetError;
+	qglGetFloatv = nullGetFloatv;
+	qglGetString = nullGetString;
+	qglLoadIdentity = nullVoid;
+	qglLoadMatrixf = nullLoadMatrixf;
+	qglMatrixMode = nullEnum;
+	qglOrtho = nullProjection;
+	qglPointSize = nullPointSize;
+	qglPolygonMode = nullPolygonMode;
+	qglPopMatrix = nullVoid;
+	qglPushMatrix = nullVoid;
+	qglReadPixels = nullReadPixels;
+	qglRotatef = nullRotatef;
+	qglScalef = nullTransform;
+	qglScissor = nullRect;
+	qglShadeModel = nullEnum;
+	qglStencilFunc = nullStencilFunc;
+	qglStencilOp = nullStencilOp;
+	qglTexCoord2f = nullTexCoord2f;
+	qglTexCoordPointer = nullPointer;
+	qglTexEnvf = nullTexEnvf;
+	qglTexEnvi = nullTexEnvi;
+	qglTexImage2D = nullTexImage2D;
+	qglTexParameterf = nullTexParameterf;
+	qglTexSubImage2D = nullTexSubImage2D;
+	qglTranslatef = nullTransform;
+	qglVertex2f = nullVertex2f;
+	qglVertex3f = nullVertex3f;
+	qglVertex3fv = nullVertex3fv;
+	qglVertexPointer = nullPointer;
+	qglViewport = nullRect;
+
+	/* The extension pointers are
+	   bound by R_Init() on demand */
+	qglLockArraysEXT = NULL;
+	qglUnlockArraysEXT = NULL;
+	qglPointParameterfEXT = NULL;
+	qglPointParameterfvEXT = NULL;
+	qglColorTableEXT = NULL;
+	qglSelectTextureSGIS = NULL;
+	qglMTexCoord2fSGIS = NULL;
+	qglActiveTextureARB = NULL;
+	qglClientActiveTextureARB = NULL;
+
+	return ( true );
+}
+
+void *
+qwglGetProcAddress ( char *symbol )
+{
+	/* Only reached if somebody forces an extension
+	   on, hand out stubs for the known ones */
+	if ( !strcmp( symbol, "glLockArraysEXT" ) )
+	{
+		return ( nullLockArrays );
+	}
+	else if ( !strcmp( symbol, "glUnlockArraysEXT" ) )
+	{
+		return ( nullVoid );
+	}
+	else if ( !strcmp( symbol, "glPointParameterfEXT" ) )
+	{
+		return ( nullPointParameterf );
+	}
+	else if ( !strcmp( symbol, "glPointParameterfvEXT" ) )
+	{
+		return ( nullPointParameterfv );
+	}
+	else if ( !strcmp( symbol, "glColorTableEXT" ) )
+	{
+		return ( nullColorTable );
+	}
+	else if ( !strcmp( symbol, "glMTexCoord2fSGIS" ) || !strcmp( symbol, "glMultiTexCoord2fARB" ) )
+	{
+		return ( nullMTexCoord2f );
+	}
+	else if ( !strcmp( symbol, "glSelectTextureSGIS" ) || !strcmp( symbol, "glActiveTextureARB" ) ||
+			  !strcmp( symbol, "glClientActiveTextureARB" ) )
+	{
+		return ( nullEnum );
+	}
+
+	return ( NULL );
+}
+
+void
+GLimp_EnableLogging ( qboolean enable )
+{
+}
+
+void
+GLimp_LogNewFrame ( void )
+{
+}
+
+/*
+ * There's no window, so there's nothing to initialize
+ */
+int
+GLimp_Init ( void )
+{
+	memset( &qglnull_stats, 0, sizeof ( qglnull_stats ) );
+	ri.Cmd_AddCommand( "gl_nullstats", QGL_NullStats_f );
+
+	return ( true );
+}
+
+/*
+ * Pretends to change the video mode
+ */
+int
+GLimp_SetMode ( int *pwidth, int *pheight, int mode, qboolean fullscreen )
+{
+	ri.Con_Printf( PRINT_ALL, "setting mode %d:", mode );
+
+	if ( ( mode != -1 ) && !ri.Vid_GetModeInfo( pwidth, pheight, mode ) )
+	{
+		ri.Con_Printf( PRINT_ALL, " invalid mode\n" );
+		return ( rserr_invalid_mode );
+	}
+
+	ri.Con_Printf( PRINT_ALL, " %d %d (null)\n", *pwidth, *pheight );
+
+	ri.Vid_NewWindow( *pwidth, *pheight );
+
+	return ( rserr_ok );
+}
+
+/*
+ * Closes a frame
+ */
+void
+GLimp_EndFrame ( void )
+{
+	qglnull_stats.frames++;
+}
+
+void
+GLimp_Shutdown ( void )
+{
+	ri.Cmd_RemoveCommand( "gl_nullstats" );
+}
+
+void
+UpdateHardwareGamma ( void )
+{
+}
+
+/*
+ * Input backend. There's no window
+ * to receive events from.
+ */
+void
+IN_Update ( void )
+{
+}
+
+void
+IN_Close ( void )
+{
+}
+
+void
+IN_KeyboardInit ( Key_Event_fp_t fp )
+{
+}
+
+void
+IN_BackendInit ( in_state_t *in_state_p )
+{
+}
+
+void
+IN_BackendShutdown ( void )
+{
+}
+
+void
+IN_BackendMouseButtons ( void )
+{
+}
+
+void
+IN_BackendMove ( usercmd_t *cmd )
+{
+}
+
+#endif
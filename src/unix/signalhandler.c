@@ -103,6 +103,9 @@ signalhandler(int sig)
 	/* printf("II an even better source port. It's much appreciated.\n"); */
 	/* printf("\n=======================================================\n\n"); */
 
+	/* get the end of the log to the disk */
+	Sys_LogFlush();
+
 	printBacktrace(sig);
 
     /* reset signalhandler */
@@ -60,8 +60,6 @@ static DIR  *fdir;
 
 qboolean stdin_active = true;
 extern cvar_t *nostdout;
-extern FILE	*logfile;
-
 static qboolean
 CompareAttributes ( char *path, char *name, unsigned musthave, unsigned canthave )
 {
@@ -114,6 +112,27 @@ Sys_Milliseconds ( void )
 	return ( curtime );
 }
 
+/*
+ * High resolution timer for the profiling
+ * and benchmark code. Unlike Sys_Milliseconds()
+ * it doesn't update curtime.
+ */
+long long
+Sys_Microseconds ( void )
+{
+	struct timeval tp;
+	static long secbase;
+
+	gettimeofday( &tp, NULL );
+
+	if ( !secbase )
+	{
+		secbase = tp.tv_sec;
+	}
+
+	return ( (long long) ( tp.tv_sec - secbase ) * 1000000 + tp.tv_usec );
+}
+
 void
 Sys_Mkdir ( char *path )
 {
@@ -272,11 +291,7 @@ Sys_Quit ( void )
 	CL_Shutdown();
 #endif
 
-   	if (logfile)
-	{
-		fclose (logfile);
-		logfile = NULL;
-	}
+	Sys_LogClose();
 
 	Qcommon_Shutdown();
 	fcntl( 0, F_SETFL, fcntl( 0, F_GETFL, 0 ) & ~FNDELAY );
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 1997-2001 Id Software, Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ * 02111-1307, USA.
+ *
+ * =======================================================================
+ *
+ * A small pool of worker threads. Sys_ParallelFor splits a loop over
+ * all cores, the calling thread does its share of the work and returns
+ * when all iterations are done. The pool is started on first use.
+ *
+ * =======================================================================
+ */
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../common/header/common.h"
+
+static pthread_mutex_t sys_joblock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sys_jobstart = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t sys_jobdone = PTHREAD_COND_INITIALIZER;
+
+static int sys_numthreads;      /* including the main thread, 0 until started */
+
+static struct
+{
+	void ( *func )( void *data, int index, int thread );
+	void *data;
+	int count;
+	int next;                   /* next index to run */
+	int generation;             /* bumped for each job */
+	int running;                /* workers still busy */
+} sys_job;
+
+static void
+Sys_RunJob ( int thread )
+{
+	int i;
+
+	while ( ( i = __sync_fetch_and_add( &sys_job.next, 1 ) ) < sys_job.count )
+	{
+		sys_job.func( sys_job.data, i, thread );
+	}
+}
+
+static void *
+Sys_WorkerThread ( void *arg )
+{
+	int thread;
+	int generation;
+
+	thread = (int) (size_t) arg;
+	generation = 0;
+
+	pthread_mutex_lock( &sys_joblock );
+
+	while ( 1 )
+	{
+		while ( sys_job.generation == generation )
+		{
+			pthread_cond_wait( &sys_jobstart, &sys_joblock );
+		}
+
+		generation = sys_job.generation;
+		pthread_mutex_unlock( &sys_joblock );
+
+		Sys_RunJob( thread );
+
+		pthread_mutex_lock( &sys_joblock );
+
+		if ( --sys_job.running == 0 )
+		{
+			pthread_cond_signal( &sys_jobdone );
+		}
+	}
+
+	return ( NULL );
+}
+
+/*
+ * Returns the number of threads a job
+ * is split over, the main thread included.
+ * That's one per core unless "sys_threads"
+ * was set on the command line.
+ */
+int
+Sys_NumThreads ( void )
+{
+	pthread_t thread;
+	cvar_t *sys_threads;
+	long cores;
+
+	if ( sys_numthreads )
+	{
+		return ( sys_numthreads );
+	}
+
+	sys_threads = Cvar_Get( "sys_threads", "0", CVAR_NOSET );
+
+	if ( sys_threads->value > 0 )
+	{
+		cores = (long) sys_threads->value;
+	}
+	else
+	{
+		cores = sysconf( _SC_NPROCESSORS_ONLN );
+	}
+
+	if ( cores > MAX_THREADS )
+	{
+		cores = MAX_THREADS;
+	}
+
+	for ( sys_numthreads = 1; sys_numthreads < cores; sys_numthreads++ )
+	{
+		if ( pthread_create( &thread, NULL, Sys_WorkerThread,
+					 (void *) (size_t) sys_numthreads ) != 0 )
+		{
+			break;
+		}
+
+		pthread_detach( thread );
+	}
+
+	Com_DPrintf( "Started %i worker threads.\n", sys_numthreads - 1 );
+
+	return ( sys_numthreads );
+}
+
+/*
+ * Calls func for each index in 0 .. count-1. thread
+ * is 0 for the calling thread and below Sys_NumThreads
+ * for the workers, it can be used to pick per thread
+ * state. Not reentrant, only the main thread may call it.
+ */
+void
+Sys_ParallelFor ( void ( *func )( void *data, int index, int thread ),
+		void *data, int count )
+{
+	int i;
+
+	if ( ( count < 2 ) || ( Sys_NumThreads() < 2 ) )
+	{
+		for ( i = 0; i < count; i++ )
+		{
+			func( data, i, 0 );
+		}
+
+		return;
+	}
+
+	pthread_mutex_lock( &sys_joblock );
+
+	sys_job.func = func;
+	sys_job.data = data;
+	sys_job.count = count;
+	sys_job.next = 0;
+	sys_job.running = sys_numthreads - 1;
+	sys_job.generation++;
+
+	pthread_cond_broadcast( &sys_jobstart );
+	pthread_mutex_unlock( &sys_joblock );
+
+	Sys_RunJob( 0 );
+
+	pthread_mutex_lock( &sys_joblock );
+
+	while ( sys_job.running )
+	{
+		pthread_cond_wait( &sys_jobdone, &sys_joblock );
+	}
+
+	pthread_mutex_unlock( &sys_joblock );
+}